@@ -0,0 +1,105 @@
+/**
+ * Copyright (c) Microsoft Corporation.
+ * 
+ * MIT License
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Microbenchmark of the lane kernels of BasicVector (see vector_kernels.h)
+// for the vector widths of the graph engines. Each round relaxes a chain of
+// vertices like updateCriticalPathCycles: the lengths of a vertex are updated
+// from its parent over per-scenario weights, and the breakdown statistics of
+// the updated lanes are copied and counted.
+//
+// Usage: kernel_bench [vertices] [rounds]
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#include "vector_kernels.h"
+
+using namespace std;
+
+
+template <uint32_t W>
+void benchWidth(uint64_t vertices, uint32_t rounds)
+{
+    const int32_t absent = numeric_limits<int32_t>::max();
+    vector<int32_t> lengths(vertices * W, 0);
+    vector<int32_t> weights(vertices * W);
+    vector<int64_t> stats(vertices * W, 0);
+    for (uint64_t k = 0; k < weights.size(); ++k)
+    {
+        weights[k] = (k % 7 == 0) ? absent : (int32_t)(k % 13);
+    }
+
+    uint64_t checksum = 0;
+    sys_nanoseconds begin = chrono::system_clock::now();
+    for (uint32_t r = 0; r < rounds; ++r)
+    {
+        for (uint64_t v = 1; v < vertices; ++v)
+        {
+            int32_t* child = &lengths[v * W];
+            int64_t* child_stats = &stats[v * W];
+            LaneMask mask = kernels::relaxMixed<W>(child, child - W, &weights[v * W], absent);
+            kernels::blendMasked<W>(child_stats, child_stats - W, mask);
+            kernels::addScalarMasked<W>(child_stats, (int64_t)1, mask);
+            checksum += __builtin_popcountll(kernels::compareGreater<W>(child, (int32_t)v, mask));
+        }
+    }
+    double elapsed = (chrono::system_clock::now() - begin).count();
+
+    double per_vertex = elapsed / ((double)rounds * (vertices - 1));
+    cout << setw(5) << W << setw(14) << fixed << setprecision(2) << per_vertex
+         << setw(12) << setprecision(3) << per_vertex / W
+         << setw(16) << checksum + stats.back() << endl;
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t vertices = (argc > 1) ? strtoull(argv[1], NULL, 10) : (1 << 16);
+    uint32_t rounds = (argc > 2) ? strtoul(argv[2], NULL, 10) : 50;
+    if (vertices < 2 || rounds == 0)
+    {
+        cerr << "Usage: " << argv[0] << " [vertices (>= 2)] [rounds (>= 1)]" << endl;
+        return 1;
+    }
+
+#if defined(__AVX512F__)
+    cout << "Kernels: AVX-512" << endl;
+#elif defined(__AVX2__)
+    cout << "Kernels: AVX2" << endl;
+#else
+    cout << "Kernels: plain loops" << endl;
+#endif
+    cout << "Width     ns/vertex     ns/lane        checksum" << endl;
+    benchWidth<1>(vertices, rounds);
+    benchWidth<4>(vertices, rounds);
+    benchWidth<8>(vertices, rounds);
+    benchWidth<16>(vertices, rounds);
+    benchWidth<32>(vertices, rounds);
+    benchWidth<64>(vertices, rounds);
+
+    return 0;
+}
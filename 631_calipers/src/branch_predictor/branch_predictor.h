@@ -33,6 +33,8 @@
 class BranchPredictor
 {
 public:
+    static constexpr bool fromTrace = false; // True only for TraceBp
+
     uint32_t predictionCycles;
 
     virtual bool mispredicted(uint64_t pc) = 0;
@@ -35,7 +35,7 @@ using namespace std;
 /**
  * A statistical/stochastic branch predictor with fixed accuracy
  */
-class StatisticalBp : public BranchPredictor
+class StatisticalBp final : public BranchPredictor
 {
   private:
     float accuracy;
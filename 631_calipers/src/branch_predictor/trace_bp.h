@@ -0,0 +1,48 @@
+/**
+ * Copyright (c) Microsoft Corporation.
+ * 
+ * MIT License
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TRACE_BP_H
+#define TRACE_BP_H
+
+#include <stdint.h>
+
+#include "branch_predictor.h"
+
+/**
+ * Stands for the branch prediction outcomes recorded in the trace
+ * The models read the outcome of the instruction instead of querying
+ * a predictor of this type, so it is never instantiated.
+ */
+class TraceBp final : public BranchPredictor
+{
+  public:
+    static constexpr bool fromTrace = true;
+
+    bool mispredicted(uint64_t pc)
+    {
+        return false;
+    }
+};
+
+#endif // TRACE_BP_H
@@ -49,6 +49,9 @@ using namespace std;
 #define MAX_REG_RD   3 // Maximum number of registers read
 #define MAX_REG_WR   1 // Maximum number of registers written
 #define MAX_OPERANDS (MAX_REG_RD + MAX_REG_WR)
+#define MAX_REGISTERS 128 // Register numbers (IntReg/FpReg of RiscvStream) are below this
+#define LDST_WORD_BYTES 8 // Granularity of the load/store address index (see PipelineBookkeeping)
+#define LDST_MAX_WORDS  2 // Words an indexed load/store may span (wider ones are scanned for)
 
 #define INO_WINDOW  400
 #define MAX_PARENTS 10
@@ -56,7 +59,13 @@ using namespace std;
 #define OOO_HOPPING_WINDOW 10000000
 #define OOO_SLIDING_WINDOW 800
 
-#define VECTOR_WIDTH 1
+#define MAX_VECTOR_WIDTH 64
+// The number of scenarios (Vector_Width) is selected at runtime among the
+// widths that the graph engines are instantiated for
+#define FOR_EACH_VECTOR_WIDTH(m) m(1) m(2) m(4) m(8) m(16) m(32) m(64)
+
+#define LENGTH_REBASE_THRESHOLD (1 << 30)
+// Window-relative critical path lengths are rebased once they exceed this value
 
 template <class Duration>
 using sys_time = chrono::time_point<chrono::system_clock, Duration>;
@@ -82,6 +82,7 @@ enum Resource
     RscFpDiv,
     RscFpMulDiv,
     RscLsu,
+    RscLast = RscLsu
 };
 
 
@@ -91,6 +92,7 @@ enum QueueResource
     RscInstrQ,
     RscLQ,
     RscSQ,
+    RscQueueLast = RscSQ
 };
 
 
@@ -125,42 +127,44 @@ typedef struct INSTRUCTION
 
 // A container of different types of instructions
 // (Used, e.g., for calculating the breakdown of critical path instructions)
-typedef struct INSTRUCTION_TYPES
+template <uint32_t W>
+struct InstructionTypes
 {
-    Vector intInstructions;
-    Vector fpInstructions;
-    Vector loadInstructions;
-    Vector storeInstructions;
-    Vector branchInstructions;
-    Vector otherInstructions;
-} InstructionTypes;
+    Vector<W> intInstructions;
+    Vector<W> fpInstructions;
+    Vector<W> loadInstructions;
+    Vector<W> storeInstructions;
+    Vector<W> branchInstructions;
+    Vector<W> otherInstructions;
+};
 
 
 // A container of different types of cycles
 // (Used, e.g., for calculating the breakdown of critical path cycles)
-typedef struct CYCLE_TYPES
+template <uint32_t W>
+struct CycleTypes
 {
-    Vector goodFetchHitCycles;
-    Vector goodFetchMissCycles;
-    Vector badFetchHitCycles;
-    Vector badFetchMissCycles;
-    Vector decodeCycles;
-    Vector dispatchCycles;
-    Vector intCycles;
-    Vector fpCycles;
-    Vector lsCycles;
-    Vector loadL1HitCycles;
-    Vector loadL2HitCycles;
-    Vector loadMissCycles;
-    Vector storeL1HitCycles;
-    Vector storeL2HitCycles;
-    Vector storeMissCycles;
-    Vector branchCycles;
-    Vector syscallCycles;
-    Vector atomicCycles;
-    Vector otherCycles;
-    Vector commitCycles;
-} CycleTypes;
+    Vector<W> goodFetchHitCycles;
+    Vector<W> goodFetchMissCycles;
+    Vector<W> badFetchHitCycles;
+    Vector<W> badFetchMissCycles;
+    Vector<W> decodeCycles;
+    Vector<W> dispatchCycles;
+    Vector<W> intCycles;
+    Vector<W> fpCycles;
+    Vector<W> lsCycles;
+    Vector<W> loadL1HitCycles;
+    Vector<W> loadL2HitCycles;
+    Vector<W> loadMissCycles;
+    Vector<W> storeL1HitCycles;
+    Vector<W> storeL2HitCycles;
+    Vector<W> storeMissCycles;
+    Vector<W> branchCycles;
+    Vector<W> syscallCycles;
+    Vector<W> atomicCycles;
+    Vector<W> otherCycles;
+    Vector<W> commitCycles;
+};
 
 
 
@@ -175,4 +179,27 @@ enum VertexType
     Last = 4
 };
 
+
+// A relaxed edge that was the winning incoming edge of its child when relaxed
+// (Used for calculating the breakdowns lazily, by walking the critical path backwards)
+typedef struct PREDECESSOR_RECORD
+{
+    int32_t parentDistance;
+    // Distance between the child and the parent in vertex order, i.e.,
+    // instrNum * (VertexType::Last + 1) + type
+
+    uint32_t parentRecord;
+    // The record of the parent's winning incoming edge at the time (0 for none)
+
+    int32_t weight;
+} PredecessorRecord;
+
+
+// The winning incoming edge of a vertex in each scenario
+template <uint32_t W>
+struct CriticalPredecessors
+{
+    uint32_t record[W]; // Index into the per-scenario predecessor log (0 for none)
+};
+
 #endif // CALIPERS_TYPES_H
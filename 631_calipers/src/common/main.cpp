@@ -27,9 +27,16 @@
 #include <fstream>
 #include <sstream>
 #include <unordered_map>
+#include <map>
+#include <set>
+#include <vector>
+#include <cstdio>
+#include <unistd.h>
+#include <sys/wait.h>
 
 #include "calipers_defs.h"
 #include "calipers_types.h"
+#include "calipers_util.h"
 #include "instruction_stream.h"
 #include "riscv_stream.h"
 #include "graph.h"
@@ -40,6 +47,10 @@
 using namespace std;
 
 uint32_t Graph::AnalysisWindow;
+unique_ptr<int32_t[]> EdgeWeight::mixedWeights[EdgeWeight::MaxMixedChunks];
+uint32_t EdgeWeight::mixedWeightsSize = 0;
+unordered_map<string, int32_t> EdgeWeight::mixedWeightIndex;
+mutex EdgeWeight::mixedWeightMutex;
 
 void extract_config(string config_file_name, unordered_map<string, string>& config)
 {
@@ -145,21 +156,296 @@ int cache_type(string str)
     return type;
 }
 
-Graph* init(char* argv[], InstructionStream* instr_stream)
+// The parameters that can be swept, i.e., given as comma-separated lists of
+// values (e.g., "Decode_Cycles 1,2,3"), one value per scenario
+const set<string> ino_sweep_params = {
+    "Fetch_Bandwidth", "Dispatch_Bandwidth", "Commit_Bandwidth",
+    "Decode_Cycles", "Dispatch_Cycles", "Execute_To_Commit_Cycles",
+    "Prediction_Cycles", "Misprediction_Penalty"};
+const set<string> ooo_sweep_params = {
+    "Fetch_Bandwidth", "Dispatch_Bandwidth", "Commit_Bandwidth",
+    "Decode_Cycles", "Dispatch_Cycles", "Execute_To_Commit_Cycles",
+    "Prediction_Cycles", "Misprediction_Penalty", "Issue_Bandwidth",
+    "Instr_Queue_Size", "Int_ALU_Count", "Int_Mul_Div_Count",
+    "FP_ALU_Count", "FP_Mul_Div_Count", "LSU_Count"};
+
+// Expands the swept parameters of config into one config per scenario, using
+// either the Cartesian product (Sweep_Mode Product, default) or the element-wise
+// combination (Sweep_Mode Zip) of the lists. No labels are produced without a sweep.
+void expand_sweep(unordered_map<string, string>& config,
+                  vector<unordered_map<string, string>>& scenario_configs,
+                  vector<string>& scenario_labels)
 {
-    srand(RAND_SEED); // For the statistical cache or branch preditor model, if used
+    const set<string>& sweep_params =
+        (config["Core"].compare("InO") == 0) ? ino_sweep_params : ooo_sweep_params;
 
-    Graph* graph;
-    unordered_map<string, string> config;
-    extract_config(argv[1], config);
+    map<string, vector<string>> swept; // Ordered, so that the scenarios are deterministic
+    for (auto& param : config)
+    {
+        if (param.second.find(',') == string::npos)
+        {
+            continue;
+        }
+        if (sweep_params.count(param.first) == 0)
+        {
+            CALIPERS_ERROR("Parameter cannot be swept for the " << config["Core"]
+                           << " core: " << param.first);
+        }
+        swept[param.first] = split_string(param.second, ',');
+    }
+
+    scenario_configs.clear();
+    scenario_labels.clear();
+    if (swept.empty())
+    {
+        scenario_configs.push_back(config);
+        return;
+    }
+
+    bool zip = (config.count("Sweep_Mode") != 0) && (config["Sweep_Mode"].compare("Zip") == 0);
+    if ((config.count("Sweep_Mode") != 0) && !zip &&
+        (config["Sweep_Mode"].compare("Product") != 0))
+    {
+        CALIPERS_ERROR("Unsupported sweep mode: " << config["Sweep_Mode"]);
+    }
+
+    uint64_t scenario_count = zip ? swept.begin()->second.size() : 1;
+    for (auto& param : swept)
+    {
+        if (zip && (param.second.size() != scenario_count))
+        {
+            CALIPERS_ERROR("Zipped parameter lists must have the same length: " << param.first);
+        }
+        if (!zip)
+        {
+            scenario_count *= param.second.size();
+        }
+        if (scenario_count > MAX_VECTOR_WIDTH)
+        {
+            CALIPERS_ERROR("Too many scenarios in the sweep (the maximum is "
+                           << MAX_VECTOR_WIDTH << ")");
+        }
+    }
+
+    for (uint64_t i = 0; i < scenario_count; ++i)
+    {
+        unordered_map<string, string> scenario_config = config;
+        string label;
+        uint64_t remaining = i; // For the product, the last parameter varies the fastest
+        for (auto param = swept.rbegin(); param != swept.rend(); ++param)
+        {
+            uint64_t idx = zip ? i : (remaining % param->second.size());
+            remaining /= param->second.size();
+            scenario_config[param->first] = param->second[idx];
+            label = param->first + "=" + param->second[idx] + (label.empty() ? "" : ", ") + label;
+        }
+        scenario_configs.push_back(scenario_config);
+        scenario_labels.push_back(label);
+    }
+}
+
+// The per-scenario values of param, where the lanes beyond the last scenario repeat it
+template <uint32_t W>
+vector<uint32_t> lane_values(vector<unordered_map<string, string>>& scenario_configs,
+                             string param)
+{
+    vector<uint32_t> values(W);
+    for (uint32_t i = 0; i < W; ++i)
+    {
+        uint32_t scenario = (i < scenario_configs.size()) ? i : (scenario_configs.size() - 1);
+        values[i] = stoi(scenario_configs[scenario][param]);
+    }
+    return values;
+}
+
+// The number of scenarios that are analyzed together (Vector_Width, widened to
+// fit the swept scenarios, if needed)
+uint32_t vector_width(unordered_map<string, string>& config, uint64_t scenarios)
+{
+    uint32_t width = (config.count("Vector_Width") != 0) ? stoi(config["Vector_Width"]) : 1;
+    while (width < scenarios)
+    {
+        width *= 2;
+    }
+    return width;
+}
+
+// Selects the engine of the out-of-order core (Engine: Hopping by default, Sliding,
+// or Auto) and sizes its analysis window for Memory_Budget (MB, 0 for no limit):
+// - Hopping windows are OOO_HOPPING_WINDOW instructions, shrunk to fit the budget
+//   (but never below the length of the trace, with the same results).
+// - The sliding window is OOO_SLIDING_WINDOW instructions, or larger if the
+//   instruction buffer needs it (see O3CoreGraphAdvanced::modelResourceDependencies).
+// - Auto picks hopping unless its window would have to be shrunk, since a
+//   sliding window then uses much less memory for no loss across windows.
+// The trace is only read ahead if the budget shrinks the hopping window (to count
+// its instructions), or for the offsets of the windows of a sharded run.
+template <uint32_t W>
+void select_engine(char* argv[], unordered_map<string, string>& config, bool swept,
+                   vector<uint64_t>& window_offsets)
+{
+    string engine = (config.count("Engine") != 0) ? config["Engine"] : "Hopping";
+    if ((engine.compare("Hopping") != 0) && (engine.compare("Sliding") != 0) &&
+        (engine.compare("Auto") != 0))
+    {
+        CALIPERS_ERROR("Unsupported engine: " << engine);
+    }
+
+    uint64_t budget = (config.count("Memory_Budget") != 0) ? stoull(config["Memory_Budget"]) : 0;
+    budget = (budget == 0) ? UINT64_MAX : (budget << 20);
+    uint32_t instr_buffer_size = stoi(config["Instr_Buffer_Size"]);
+    bool overlap_windows = (config.count("Overlap_Windows") != 0) && stoi(config["Overlap_Windows"]);
+    bool spilled = (config.count("Graph_Spill_File") != 0);
+
+    // The sliding engine runs one scenario (or copies of it) in a single process
+    bool sharded = (config.count("Shards") != 0) && (stoi(config["Shards"]) > 1);
+    string sliding_unsupported;
+    if (swept)
+    {
+        sliding_unsupported = "sweeps";
+    }
+    else if (sharded)
+    {
+        sliding_unsupported = "sharded runs";
+    }
+
+    // The largest hopping window that fits (windowBytes grows with the window)
+    uint64_t hopping_window = OOO_HOPPING_WINDOW;
+    if (O3CoreGraph<W>::windowBytes(hopping_window, overlap_windows, spilled) > budget)
+    {
+        uint64_t fits = 0;
+        uint64_t exceeds = hopping_window;
+        while (exceeds - fits > 1)
+        {
+            uint64_t window = (fits + exceeds) / 2;
+            if (O3CoreGraph<W>::windowBytes(window, overlap_windows, spilled) <= budget)
+            {
+                fits = window;
+            }
+            else
+            {
+                exceeds = window;
+            }
+        }
+        hopping_window = fits;
+    }
+
+    // The offsets are only used by sharded runs, which are not sliding. A window
+    // shorter than the instruction buffer is an error unless it is the whole trace.
+    uint64_t instructions = UINT64_MAX; // Not counted
+    window_offsets.clear();
+    if ((engine.compare("Sliding") != 0) && ((hopping_window < OOO_HOPPING_WINDOW) || sharded))
+    {
+        RiscvStream index_stream(argv[2], false, false, false);
+        uint64_t stride = sharded ? max<uint64_t>(hopping_window, instr_buffer_size) : UINT64_MAX;
+        instructions = index_stream.index(stride, window_offsets);
+    }
+
+    bool hopping_fits = (min<uint64_t>(instructions, OOO_HOPPING_WINDOW) <= hopping_window);
+    if (engine.compare("Auto") == 0)
+    {
+        engine = (hopping_fits || !sliding_unsupported.empty()) ? "Hopping" : "Sliding";
+    }
+
+    uint64_t window_bytes;
+    if (engine.compare("Hopping") == 0)
+    {
+        hopping_window = max<uint64_t>(min<uint64_t>(instructions, hopping_window), 1);
+        if (hopping_window < min<uint64_t>(instructions, instr_buffer_size))
+        {
+            CALIPERS_ERROR("The memory budget cannot hold a hopping window of the instruction buffer");
+        }
+        Graph::AnalysisWindow = hopping_window;
+        window_bytes = O3CoreGraph<W>::windowBytes(hopping_window, overlap_windows, spilled);
+    }
+    else
+    {
+        if (!sliding_unsupported.empty())
+        {
+            CALIPERS_ERROR("The sliding engine does not support " << sliding_unsupported);
+        }
+
+        // A quarter of the window is refilled at a time, and the refilled instructions
+        // must be more than the instruction buffer behind the oldest unscheduled one
+        uint64_t min_window = (2 * (uint64_t)instr_buffer_size + 3) / 4 * 4;
+        uint64_t sliding_window = max<uint64_t>(OOO_SLIDING_WINDOW, min_window);
+        window_bytes = O3CoreGraphAdvanced<W>::windowBytes(sliding_window);
+        if (window_bytes > budget)
+        {
+            CALIPERS_ERROR("The memory budget cannot hold a sliding window of "
+                           << sliding_window << " instructions");
+        }
+        Graph::AnalysisWindow = sliding_window;
+    }
+
+    // Without the count of the trace, a hopping window is only an upper bound (the
+    // graph grows with the instructions), and so is its memory, which is only worth
+    // reporting against a budget
+    config["Engine"] = engine;
+    if ((instructions == UINT64_MAX) && (engine.compare("Hopping") == 0))
+    {
+        if (budget == UINT64_MAX)
+        {
+            CALIPERS_INFO(engine << " analysis window: up to " << Graph::AnalysisWindow
+                          << " instructions");
+        }
+        else
+        {
+            CALIPERS_INFO(engine << " analysis window: up to " << Graph::AnalysisWindow
+                          << " instructions (at most about " << (window_bytes >> 20) << " MB)");
+        }
+    }
+    else if (instructions == UINT64_MAX)
+    {
+        CALIPERS_INFO(engine << " analysis window: " << Graph::AnalysisWindow
+                      << " instructions (about " << (window_bytes >> 20) << " MB)");
+    }
+    else
+    {
+        CALIPERS_INFO(engine << " analysis window: " << Graph::AnalysisWindow << " of "
+                      << instructions << " instructions (about " << (window_bytes >> 20) << " MB)");
+    }
+}
+
+// Sets Graph::AnalysisWindow (and the engine, see select_engine) for the core, and
+// the byte offsets of its windows in the trace if they are needed (see run_shards)
+void size_window(char* argv[], unordered_map<string, string>& config,
+                 vector<uint64_t>& window_offsets)
+{
+    if (config["Core"].compare("InO") == 0)
+    {
+        Graph::AnalysisWindow = INO_WINDOW;
+        return;
+    }
+
+    vector<unordered_map<string, string>> scenario_configs;
+    vector<string> scenario_labels;
+    expand_sweep(config, scenario_configs, scenario_labels);
+
+    uint32_t width = vector_width(config, scenario_configs.size());
+    switch (width)
+    {
+#define SELECT_ENGINE(w) \
+        case w: select_engine<w>(argv, config, !scenario_labels.empty(), window_offsets); break;
+        FOR_EACH_VECTOR_WIDTH(SELECT_ENGINE)
+#undef SELECT_ENGINE
+        default:
+            CALIPERS_ERROR("Unsupported vector width: " << width);
+    }
+}
+
+template <uint32_t W>
+Graph* create_graph(char* argv[], InstructionStream* instr_stream,
+                    unordered_map<string, string>& config,
+                    vector<unordered_map<string, string>>& scenario_configs,
+                    vector<string>& scenario_labels)
+{
+    VectorGraph<W>* graph;
 
     bool trace_bp = !use_bp_model(config);
     bool trace_icache = !use_icache_model(config);
     bool trace_dcache = !use_dcache_model(config);
 
-    instr_stream = new RiscvStream(argv[2], // Trace file name
-                                   trace_bp, trace_icache, trace_dcache);
-
     if (config["Core"].compare("InO") == 0)
     {
         if (!(trace_bp && trace_icache && trace_dcache))
@@ -168,19 +454,18 @@ Graph* init(char* argv[], InstructionStream* instr_stream)
                 "Current InO model needs trace-provided branch prediction and load/store info");
         }
 
-        Graph::AnalysisWindow = INO_WINDOW;
-        graph = new InorderCoreGraph(argv[2], // Trace file name
+        graph = new InorderCoreGraph<W>(argv[2], // Trace file name
                                      argv[3], // Result file name
                                      instr_stream,
-                                     stoi(config["Fetch_Bandwidth"]),
-                                     stoi(config["Dispatch_Bandwidth"]),
+                                     lane_values<W>(scenario_configs, "Fetch_Bandwidth"),
+                                     lane_values<W>(scenario_configs, "Dispatch_Bandwidth"),
                                      stoi(config["Issue_Bandwidth"]),
-                                     stoi(config["Commit_Bandwidth"]),
-                                     stoi(config["Decode_Cycles"]),
-                                     stoi(config["Dispatch_Cycles"]),
-                                     stoi(config["Execute_To_Commit_Cycles"]),
-                                     stoi(config["Prediction_Cycles"]),
-                                     stoi(config["Misprediction_Penalty"]),
+                                     lane_values<W>(scenario_configs, "Commit_Bandwidth"),
+                                     lane_values<W>(scenario_configs, "Decode_Cycles"),
+                                     lane_values<W>(scenario_configs, "Dispatch_Cycles"),
+                                     lane_values<W>(scenario_configs, "Execute_To_Commit_Cycles"),
+                                     lane_values<W>(scenario_configs, "Prediction_Cycles"),
+                                     lane_values<W>(scenario_configs, "Misprediction_Penalty"),
                                      stoi(config["Mem_Issue_Bandwidth"]),
                                      stoi(config["Mem_Commit_Bandwidth"]),
                                      stoi(config["Max_Mem_Accesses"]),
@@ -193,30 +478,29 @@ Graph* init(char* argv[], InstructionStream* instr_stream)
                                      stoi(config["Load_Early_Issue"]));
 
     }
-    else //if (config["Core"].compare("OoO") == 0)
+    else if (config["Engine"].compare("Hopping") == 0) // The windows are sized by select_engine
     {
-        Graph::AnalysisWindow = OOO_HOPPING_WINDOW;
-        graph = new O3CoreGraph(argv[2], // Trace file name
+        graph = new O3CoreGraph<W>(argv[2], // Trace file name
                                 argv[3], // Result file name
                                 instr_stream,
                                 stoi(config["Instr_Buffer_Size"]),
-                                stoi(config["Instr_Queue_Size"]),
-                                stoi(config["Fetch_Bandwidth"]),
-                                stoi(config["Dispatch_Bandwidth"]),
-                                stoi(config["Issue_Bandwidth"]),
-                                stoi(config["Commit_Bandwidth"]),
-                                stoi(config["Decode_Cycles"]),
-                                stoi(config["Dispatch_Cycles"]),
-                                stoi(config["Execute_To_Commit_Cycles"]),
-                                stoi(config["Prediction_Cycles"]),
-                                stoi(config["Misprediction_Penalty"]),
+                                lane_values<W>(scenario_configs, "Instr_Queue_Size"),
+                                lane_values<W>(scenario_configs, "Fetch_Bandwidth"),
+                                lane_values<W>(scenario_configs, "Dispatch_Bandwidth"),
+                                lane_values<W>(scenario_configs, "Issue_Bandwidth"),
+                                lane_values<W>(scenario_configs, "Commit_Bandwidth"),
+                                lane_values<W>(scenario_configs, "Decode_Cycles"),
+                                lane_values<W>(scenario_configs, "Dispatch_Cycles"),
+                                lane_values<W>(scenario_configs, "Execute_To_Commit_Cycles"),
+                                lane_values<W>(scenario_configs, "Prediction_Cycles"),
+                                lane_values<W>(scenario_configs, "Misprediction_Penalty"),
                                 stoi(config["Mem_Issue_Bandwidth"]),
                                 stoi(config["Mem_Commit_Bandwidth"]),
-                                stoi(config["Int_ALU_Count"]),
-                                stoi(config["Int_Mul_Div_Count"]),
-                                stoi(config["FP_ALU_Count"]),
-                                stoi(config["FP_Mul_Div_Count"]),
-                                stoi(config["LSU_Count"]),
+                                lane_values<W>(scenario_configs, "Int_ALU_Count"),
+                                lane_values<W>(scenario_configs, "Int_Mul_Div_Count"),
+                                lane_values<W>(scenario_configs, "FP_ALU_Count"),
+                                lane_values<W>(scenario_configs, "FP_Mul_Div_Count"),
+                                lane_values<W>(scenario_configs, "LSU_Count"),
                                 stoi(config["LQ_Size"]),
                                 stoi(config["SQ_Size"]),
                                 bp_type(config["Branch_Predictor"]),
@@ -224,10 +508,19 @@ Graph* init(char* argv[], InstructionStream* instr_stream)
                                 cache_type(config["I_Cache"]),
                                 config["I_Cache_Config"],
                                 cache_type(config["D_Cache"]),
-                                config["D_Cache_Config"]);
-        /*
-        Graph::AnalysisWindow = OOO_SLIDING_WINDOW;
-        graph = new O3CoreGraphAdvanced(argv[2], // Trace file name
+                                config["D_Cache_Config"],
+                                (config.count("Lazy_Breakdown") != 0) &&
+                                    stoi(config["Lazy_Breakdown"]),
+                                (config.count("Analysis_Threads") != 0) ?
+                                    stoi(config["Analysis_Threads"]) : 1,
+                                (config.count("Graph_Spill_File") != 0) ?
+                                    config["Graph_Spill_File"] : "",
+                                (config.count("Overlap_Windows") != 0) &&
+                                    stoi(config["Overlap_Windows"]));
+    }
+    else //if (config["Engine"].compare("Sliding") == 0)
+    {
+        graph = new O3CoreGraphAdvanced<W>(argv[2], // Trace file name
                                         argv[3], // Result file name
                                         instr_stream,
                                         stoi(config["Instr_Buffer_Size"]),
@@ -256,18 +549,142 @@ Graph* init(char* argv[], InstructionStream* instr_stream)
                                         config["I_Cache_Config"],
                                         cache_type(config["D_Cache"]),
                                         config["D_Cache_Config"]);
-        */
+    }
+
+    if (!scenario_labels.empty())
+    {
+        graph->setScenarioLabels(scenario_labels);
     }
 
     return graph;
 }
 
+Graph* init(char* argv[], unordered_map<string, string>& config,
+            InstructionStream*& instr_stream)
+{
+    srand(RAND_SEED); // For the statistical cache or branch preditor model, if used
+
+    bool trace_bp = !use_bp_model(config);
+    bool trace_icache = !use_icache_model(config);
+    bool trace_dcache = !use_dcache_model(config);
+
+    instr_stream = new RiscvStream(argv[2], // Trace file name
+                                   trace_bp, trace_icache, trace_dcache);
+
+    vector<unordered_map<string, string>> scenario_configs;
+    vector<string> scenario_labels;
+    expand_sweep(config, scenario_configs, scenario_labels);
+
+    uint32_t width = vector_width(config, scenario_configs.size());
+    switch (width)
+    {
+#define CREATE_GRAPH(w) \
+        case w: return create_graph<w>(argv, instr_stream, config, scenario_configs, scenario_labels);
+        FOR_EACH_VECTOR_WIDTH(CREATE_GRAPH)
+#undef CREATE_GRAPH
+        default:
+            CALIPERS_ERROR("Unsupported vector width: " << width);
+    }
+}
+
 void finish(InstructionStream* instr_stream, Graph* graph)
 {
     delete instr_stream;
     delete graph;
 }
 
+string shard_file_name(string file_name, uint32_t shard)
+{
+    return file_name + ".shard" + to_string(shard);
+}
+
+// Runs contiguous ranges of the hopping windows in separate processes (each with its
+// own caches, branch predictor, and random numbers) and merges their results in the
+// order of the windows. The windows before a range are warmed up functionally
+// (Shard_Functional_Warmup, all of them by default) and then in detail
+// (Shard_Detailed_Warmup, one by default). The results are the same as those of a
+// single process if all the earlier windows are warmed up in detail.
+void run_shards(char* argv[], unordered_map<string, string>& config, uint32_t shards,
+                vector<uint64_t>& offsets)
+{
+    if (config["Core"].compare("OoO") != 0)
+    {
+        CALIPERS_ERROR("Sharded runs are only supported by the out-of-order core");
+    }
+
+    // offsets = Byte offsets of the windows in the trace (see select_engine)
+    uint64_t windows = offsets.size();
+    shards = min<uint64_t>(shards, windows);
+
+    uint64_t functional_windows = (config.count("Shard_Functional_Warmup") != 0) ?
+                                  stoull(config["Shard_Functional_Warmup"]) : UINT64_MAX;
+    uint64_t detailed_windows = (config.count("Shard_Detailed_Warmup") != 0) ?
+                                stoull(config["Shard_Detailed_Warmup"]) : 1;
+
+    CALIPERS_INFO("Running " << windows << " windows in " << shards << " shards...");
+
+    vector<pid_t> pids(shards);
+    for (uint32_t s = 0; s < shards; ++s)
+    {
+        uint64_t first_window = windows * s / shards;
+        uint64_t end_window = windows * (s + 1) / shards;
+        uint64_t detailed_window = first_window - min(first_window, detailed_windows);
+        uint64_t functional_window = detailed_window - min(detailed_window, functional_windows);
+
+        pids[s] = fork();
+        if (pids[s] < 0)
+        {
+            CALIPERS_ERROR("Unable to start shard " << s);
+        }
+        if (pids[s] == 0)
+        {
+            // The results of the shard are only written to its own file
+            string result_file_name = shard_file_name(argv[3], s);
+            char* shard_argv[] = {argv[0], argv[1], argv[2], &result_file_name[0]};
+            if (config.count("Graph_Spill_File") != 0)
+            {
+                config["Graph_Spill_File"] = shard_file_name(config["Graph_Spill_File"], s);
+            }
+            cout.setstate(ios::failbit);
+
+            InstructionStream* instr_stream;
+            Graph* graph = init(shard_argv, config, instr_stream);
+            instr_stream->seek(offsets[functional_window]);
+            graph->setShard(functional_window * Graph::AnalysisWindow,
+                            detailed_window * Graph::AnalysisWindow,
+                            first_window * Graph::AnalysisWindow,
+                            end_window * Graph::AnalysisWindow);
+            graph->run();
+            finish(instr_stream, graph);
+            exit(0);
+        }
+    }
+
+    for (uint32_t s = 0; s < shards; ++s)
+    {
+        int status;
+        if ((waitpid(pids[s], &status, 0) != pids[s]) ||
+            !WIFEXITED(status) || (WEXITSTATUS(status) != 0))
+        {
+            CALIPERS_ERROR("Shard " << s << " failed");
+        }
+    }
+
+    fstream result_file;
+    result_file.open(argv[3], fstream::out | fstream::app);
+    for (uint32_t s = 0; s < shards; ++s)
+    {
+        string shard_result_file_name = shard_file_name(argv[3], s);
+        ifstream shard_result_file(shard_result_file_name);
+        ostringstream os;
+        os << shard_result_file.rdbuf();
+        cout << os.str();
+        result_file << os.str();
+        shard_result_file.close();
+        remove(shard_result_file_name.c_str());
+    }
+}
+
 int main(int argc, char* argv[])
 {
     if (argc != 4)
@@ -275,10 +692,22 @@ int main(int argc, char* argv[])
         CALIPERS_ERROR("Usage --> arg1: config file, arg2: trace file, arg3: result file");
     }
 
+    unordered_map<string, string> config;
+    vector<uint64_t> window_offsets;
+    extract_config(argv[1], config);
+    size_window(argv, config, window_offsets);
+
+    uint32_t shards = (config.count("Shards") != 0) ? stoi(config["Shards"]) : 1;
+    if (shards > 1)
+    {
+        run_shards(argv, config, shards, window_offsets);
+        return 0;
+    }
+
     InstructionStream* instr_stream;
     Graph* graph;
 
-    graph = init(argv, instr_stream);
+    graph = init(argv, config, instr_stream);
     graph->run();
     finish(instr_stream, graph);
 
@@ -0,0 +1,107 @@
+/**
+ * Copyright (c) Microsoft Corporation.
+ * 
+ * MIT License
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BIT_RING_H
+#define BIT_RING_H
+
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+
+/**
+ * A fixed-size ring of bits indexed by (unbounded) instruction numbers
+ * Numbers that are a multiple of the ring size apart share a bit, so at any
+ * time the live numbers must span less than the ring size. Runs of set bits
+ * are measured a word at a time.
+ */
+class BitRing
+{
+  private:
+    vector<uint64_t> words;
+    uint64_t mask; // Ring size - 1 (the size is a power of two and at least 64)
+
+  public:
+    BitRing() : mask(0) {}
+
+    void init(uint64_t bits)
+    {
+        uint64_t size = 64;
+        while (size < bits)
+        {
+            size <<= 1;
+        }
+        words.assign(size / 64, 0);
+        mask = size - 1;
+    }
+
+    void set(uint64_t n)
+    {
+        words[(n & mask) >> 6] |= (uint64_t)1 << (n & 63);
+    }
+
+    // The number of consecutive set bits starting at from
+    uint64_t countRun(uint64_t from) const
+    {
+        uint64_t run = 0;
+        while (run <= mask)
+        {
+            uint64_t pos = from + run;
+            uint32_t offset = pos & 63;
+            uint64_t zeros = ~(words[(pos & mask) >> 6] >> offset);
+            uint32_t available = 64 - offset;
+            uint32_t ones = (zeros == 0) ? 64 : __builtin_ctzll(zeros);
+            if (ones < available)
+            {
+                run += ones;
+                break;
+            }
+            run += available;
+        }
+        return (run > mask) ? mask + 1 : run;
+    }
+
+    // Clears count bits starting at from
+    void clearRange(uint64_t from, uint64_t count)
+    {
+        while (count > 0)
+        {
+            uint32_t offset = from & 63;
+            uint64_t bits = (count < 64 - offset) ? count : 64 - offset;
+            uint64_t range = (bits == 64) ? UINT64_MAX : (((uint64_t)1 << bits) - 1) << offset;
+            words[(from & mask) >> 6] &= ~range;
+            from += bits;
+            count -= bits;
+        }
+    }
+
+    void clear()
+    {
+        words.assign(words.size(), 0);
+    }
+};
+
+
+#endif // BIT_RING_H
@@ -55,235 +55,514 @@ Graph::Graph(string trace_file_name, string result_file_name, InstructionStream*
     l2dThreshold = 20;
 }
 
-void Graph::updateCriticalPathCycles(Vertex& parent, OutgoingEdge& e)
+void Graph::setShard(uint64_t, uint64_t, uint64_t, uint64_t)
 {
-    bool mask[VECTOR_WIDTH];
-    bool comparison[VECTOR_WIDTH];
-
-    Vertex& child = e.child;
-    Vector& weight = e.weight;
-
-    length[child].update(length[parent], weight, mask, VECTOR_WIDTH);
-
-    criticalPathInstructions[child].intInstructions.maskedSet(
-        criticalPathInstructions[parent].intInstructions, mask, VECTOR_WIDTH);
-    criticalPathInstructions[child].fpInstructions.maskedSet(
-        criticalPathInstructions[parent].fpInstructions, mask, VECTOR_WIDTH);
-    criticalPathInstructions[child].loadInstructions.maskedSet(
-        criticalPathInstructions[parent].loadInstructions, mask, VECTOR_WIDTH);
-    criticalPathInstructions[child].storeInstructions.maskedSet(
-        criticalPathInstructions[parent].storeInstructions, mask, VECTOR_WIDTH);
-    criticalPathInstructions[child].branchInstructions.maskedSet(
-        criticalPathInstructions[parent].branchInstructions, mask, VECTOR_WIDTH);
-    criticalPathInstructions[child].otherInstructions.maskedSet(
-        criticalPathInstructions[parent].otherInstructions, mask, VECTOR_WIDTH);
-
-    criticalPathCycles[child].goodFetchHitCycles.maskedSet(
-        criticalPathCycles[parent].goodFetchHitCycles, mask, VECTOR_WIDTH);
-    criticalPathCycles[child].goodFetchMissCycles.maskedSet(
-        criticalPathCycles[parent].goodFetchMissCycles, mask, VECTOR_WIDTH);
-    criticalPathCycles[child].badFetchHitCycles.maskedSet(
-        criticalPathCycles[parent].badFetchHitCycles, mask, VECTOR_WIDTH);
-    criticalPathCycles[child].badFetchMissCycles.maskedSet(
-        criticalPathCycles[parent].badFetchMissCycles, mask, VECTOR_WIDTH);
-    criticalPathCycles[child].decodeCycles.maskedSet(
-        criticalPathCycles[parent].decodeCycles, mask, VECTOR_WIDTH);
-    criticalPathCycles[child].dispatchCycles.maskedSet(
-        criticalPathCycles[parent].dispatchCycles, mask, VECTOR_WIDTH);
-    criticalPathCycles[child].intCycles.maskedSet(
-        criticalPathCycles[parent].intCycles, mask, VECTOR_WIDTH);
-    criticalPathCycles[child].fpCycles.maskedSet(
-        criticalPathCycles[parent].fpCycles, mask, VECTOR_WIDTH);
-    criticalPathCycles[child].lsCycles.maskedSet(
-        criticalPathCycles[parent].lsCycles, mask, VECTOR_WIDTH);
-    criticalPathCycles[child].loadL1HitCycles.maskedSet(
-        criticalPathCycles[parent].loadL1HitCycles, mask, VECTOR_WIDTH);
-    criticalPathCycles[child].loadL2HitCycles.maskedSet(
-        criticalPathCycles[parent].loadL2HitCycles, mask, VECTOR_WIDTH);
-    criticalPathCycles[child].loadMissCycles.maskedSet(
-        criticalPathCycles[parent].loadMissCycles, mask, VECTOR_WIDTH);
-    criticalPathCycles[child].storeL1HitCycles.maskedSet(
-        criticalPathCycles[parent].storeL1HitCycles, mask, VECTOR_WIDTH);
-    criticalPathCycles[child].storeL2HitCycles.maskedSet(
-        criticalPathCycles[parent].storeL2HitCycles, mask, VECTOR_WIDTH);
-    criticalPathCycles[child].storeMissCycles.maskedSet(
-        criticalPathCycles[parent].storeMissCycles, mask, VECTOR_WIDTH);
-    criticalPathCycles[child].branchCycles.maskedSet(
-        criticalPathCycles[parent].branchCycles, mask, VECTOR_WIDTH);
-    criticalPathCycles[child].syscallCycles.maskedSet(
-        criticalPathCycles[parent].syscallCycles, mask, VECTOR_WIDTH);
-    criticalPathCycles[child].atomicCycles.maskedSet(
-        criticalPathCycles[parent].atomicCycles, mask, VECTOR_WIDTH);
-    criticalPathCycles[child].otherCycles.maskedSet(
-        criticalPathCycles[parent].otherCycles, mask, VECTOR_WIDTH);
-    criticalPathCycles[child].commitCycles.maskedSet(
-        criticalPathCycles[parent].commitCycles, mask, VECTOR_WIDTH);
-
-    if (((parent.type == VertexType::InstrExecute) && (child.type != VertexType::MemExecute)) ||
-         (parent.type == VertexType::MemExecute))
+    CALIPERS_ERROR("Sharded runs are only supported by the out-of-order model");
+}
+
+template <uint32_t W>
+VectorGraph<W>::VectorGraph(string trace_file_name, string result_file_name,
+                            InstructionStream* instr_stream) :
+    Graph(trace_file_name, result_file_name, instr_stream),
+    lengthBase(0),
+    lazyBreakdown(false),
+    scenarioLabels(W)
+{}
+
+template <uint32_t W>
+void VectorGraph<W>::setScenarioLabels(const vector<string>& labels)
+{
+    if ((labels.size() == 0) || (labels.size() > W))
+    {
+        CALIPERS_ERROR("Invalid number of scenario labels: " << labels.size());
+    }
+    scenarioLabels = labels;
+}
+
+template <uint32_t W>
+LaneGroups VectorGraph<W>::groupLanes(const vector<uint32_t>& values)
+{
+    if (values.size() != W)
+    {
+        CALIPERS_ERROR("Invalid number of per-scenario values: " << values.size());
+    }
+
+    LaneGroups groups;
+    for (uint32_t i = 0; i < W; ++i)
+    {
+        bool found = false;
+        for (auto& group : groups)
+        {
+            if (group.first == values[i])
+            {
+                group.second |= (LaneMask)1 << i;
+                found = true;
+                break;
+            }
+        }
+        if (!found)
+        {
+            groups.push_back(make_pair(values[i], (LaneMask)1 << i));
+        }
+    }
+    return groups;
+}
+
+template <uint32_t W>
+LaneMask VectorGraph<W>::lanesOtherThan(const LaneGroups& groups, uint32_t value)
+{
+    LaneMask lanes = 0;
+    for (auto& group : groups)
+    {
+        if (group.first != value)
+        {
+            lanes |= group.second;
+        }
+    }
+    return lanes;
+}
+
+// The memory that the engines need per instruction of a window: the lengths and
+// breakdowns of its vertices, and about 2 KB for its edges and hash map nodes
+// (which bound the peak memory measured for 1 to 16 scenarios)
+template <uint32_t W>
+uint64_t VectorGraph<W>::instructionBytes()
+{
+    return (VertexType::Last + 1) *
+           (sizeof(LengthVector<W>) + sizeof(CycleTypes<W>) + sizeof(InstructionTypes<W>)) + 2048;
+}
+
+template <uint32_t W>
+typename VectorGraph<W>::VertexEntries VectorGraph<W>::vertexEntries(Vertex& v)
+{
+    if (lazyBreakdown)
+    {
+        return {&length[v], NULL, NULL, &criticalPredecessors[v]};
+    }
+    return {&length[v], &criticalPathCycles[v], &criticalPathInstructions[v], NULL};
+}
+
+// The execution type of an InstrExecute or MemExecute vertex (-1 for the other vertices)
+template <uint32_t W>
+int VectorGraph<W>::vertexExecutionType(Vertex& v)
+{
+    if ((v.type == VertexType::InstrExecute) || (v.type == VertexType::MemExecute))
+    {
+        return executionType[v.instrNum % AnalysisWindow];
+    }
+    return -1;
+}
+
+template <uint32_t W>
+LaneMask VectorGraph<W>::updateCriticalPathCycles(Vertex& parent, OutgoingEdge& e)
+{
+    VertexEntries child_entries = vertexEntries(e.child);
+    VertexEntries parent_entries = vertexEntries(parent);
+    return updateCriticalPathCycles(parent, e.child, vertexExecutionType(parent), e.weight,
+                                    parent_entries, child_entries);
+}
+
+template <uint32_t W>
+LaneMask VectorGraph<W>::updateCriticalPathCycles(Vertex& parent, Vertex& child,
+                                                  int parent_execution_type, EdgeWeight& weight,
+                                                  VertexEntries& parent_entries,
+                                                  VertexEntries& child_entries)
+{
+    LaneMask mask = child_entries.length->update(*parent_entries.length, weight);
+
+    if (lazyBreakdown)
+    {
+        CriticalPredecessors<W>& child_predecessors = *child_entries.predecessors;
+        CriticalPredecessors<W>& parent_predecessors = *parent_entries.predecessors;
+        int32_t parent_distance = vertexDistance(parent, child);
+        for (uint32_t i = 0; i < W; ++i)
+        {
+            if ((mask >> i) & 1)
+            {
+                PredecessorRecord record = {parent_distance, parent_predecessors.record[i],
+                                            weight[i]};
+                PredecessorRecord& current = predecessorLog[i][child_predecessors.record[i]];
+                if (child_predecessors.record[i] >= firstPassRecord[i])
+                {
+                    current = record;
+                    continue;
+                }
+                if ((current.parentDistance == record.parentDistance) &&
+                    (current.parentRecord == record.parentRecord) &&
+                    (current.weight == record.weight))
+                {
+                    continue; // The same edge wins again, e.g., from a parent that did not change
+                }
+                if (predecessorLog[i].size() == UINT32_MAX)
+                {
+                    CALIPERS_ERROR("Predecessor log overflow");
+                }
+                child_predecessors.record[i] = predecessorLog[i].size();
+                predecessorLog[i].push_back(record);
+            }
+        }
+        return mask;
+    }
+
+    copyBreakdown(*child_entries.cycles, *parent_entries.cycles, *child_entries.instructions,
+                  *parent_entries.instructions, mask);
+    classifyEdge(parent.type, child.type, parent_execution_type, weight, mask,
+                 *child_entries.cycles, *child_entries.instructions);
+    return mask;
+}
+
+template <uint32_t W>
+void VectorGraph<W>::copyBreakdown(CycleTypes<W>& child_cycles, CycleTypes<W>& parent_cycles,
+                                   InstructionTypes<W>& child_instructions,
+                                   InstructionTypes<W>& parent_instructions, LaneMask mask)
+{
+    child_instructions.intInstructions.maskedSet(
+        parent_instructions.intInstructions, mask);
+    child_instructions.fpInstructions.maskedSet(
+        parent_instructions.fpInstructions, mask);
+    child_instructions.loadInstructions.maskedSet(
+        parent_instructions.loadInstructions, mask);
+    child_instructions.storeInstructions.maskedSet(
+        parent_instructions.storeInstructions, mask);
+    child_instructions.branchInstructions.maskedSet(
+        parent_instructions.branchInstructions, mask);
+    child_instructions.otherInstructions.maskedSet(
+        parent_instructions.otherInstructions, mask);
+
+    child_cycles.goodFetchHitCycles.maskedSet(
+        parent_cycles.goodFetchHitCycles, mask);
+    child_cycles.goodFetchMissCycles.maskedSet(
+        parent_cycles.goodFetchMissCycles, mask);
+    child_cycles.badFetchHitCycles.maskedSet(
+        parent_cycles.badFetchHitCycles, mask);
+    child_cycles.badFetchMissCycles.maskedSet(
+        parent_cycles.badFetchMissCycles, mask);
+    child_cycles.decodeCycles.maskedSet(
+        parent_cycles.decodeCycles, mask);
+    child_cycles.dispatchCycles.maskedSet(
+        parent_cycles.dispatchCycles, mask);
+    child_cycles.intCycles.maskedSet(
+        parent_cycles.intCycles, mask);
+    child_cycles.fpCycles.maskedSet(
+        parent_cycles.fpCycles, mask);
+    child_cycles.lsCycles.maskedSet(
+        parent_cycles.lsCycles, mask);
+    child_cycles.loadL1HitCycles.maskedSet(
+        parent_cycles.loadL1HitCycles, mask);
+    child_cycles.loadL2HitCycles.maskedSet(
+        parent_cycles.loadL2HitCycles, mask);
+    child_cycles.loadMissCycles.maskedSet(
+        parent_cycles.loadMissCycles, mask);
+    child_cycles.storeL1HitCycles.maskedSet(
+        parent_cycles.storeL1HitCycles, mask);
+    child_cycles.storeL2HitCycles.maskedSet(
+        parent_cycles.storeL2HitCycles, mask);
+    child_cycles.storeMissCycles.maskedSet(
+        parent_cycles.storeMissCycles, mask);
+    child_cycles.branchCycles.maskedSet(
+        parent_cycles.branchCycles, mask);
+    child_cycles.syscallCycles.maskedSet(
+        parent_cycles.syscallCycles, mask);
+    child_cycles.atomicCycles.maskedSet(
+        parent_cycles.atomicCycles, mask);
+    child_cycles.otherCycles.maskedSet(
+        parent_cycles.otherCycles, mask);
+    child_cycles.commitCycles.maskedSet(
+        parent_cycles.commitCycles, mask);
+}
+
+template <uint32_t W>
+void VectorGraph<W>::classifyEdge(Vertex& parent, Vertex& child, EdgeWeight& weight, LaneMask mask,
+                                  CycleTypes<W>& cycles, InstructionTypes<W>& instructions)
+{
+    classifyEdge(parent.type, child.type, vertexExecutionType(parent), weight, mask,
+                 cycles, instructions);
+}
+
+template <uint32_t W>
+void VectorGraph<W>::classifyEdge(int parent_type, int child_type, int parent_execution_type,
+                                  EdgeWeight& weight, LaneMask mask,
+                                  CycleTypes<W>& cycles, InstructionTypes<W>& instructions)
+{
+    LaneMask comparison;
+
+    if (((parent_type == VertexType::InstrExecute) && (child_type != VertexType::MemExecute)) ||
+         (parent_type == VertexType::MemExecute))
     {
-        int parent_execution_type = executionType[parent.instrNum % AnalysisWindow];
-        Vector one_vector(1);
         switch (parent_execution_type)
         {
             case ExecutionType::IntBase:
             case ExecutionType::IntMul:
             case ExecutionType::IntDiv:
-                criticalPathInstructions[child].intInstructions.maskedAdd(
-                    one_vector, mask, VECTOR_WIDTH);
+                instructions.intInstructions.maskedAdd(
+                    1, mask);
                 break;
             case ExecutionType::FpBase:
             case ExecutionType::FpMul:
             case ExecutionType::FpDiv:
-                criticalPathInstructions[child].fpInstructions.maskedAdd(
-                    one_vector, mask, VECTOR_WIDTH);
+                instructions.fpInstructions.maskedAdd(
+                    1, mask);
                 break;
             case ExecutionType::Load:
-                criticalPathInstructions[child].loadInstructions.maskedAdd(
-                    one_vector, mask, VECTOR_WIDTH);
+                instructions.loadInstructions.maskedAdd(
+                    1, mask);
                 break;
             case ExecutionType::Store:
-                criticalPathInstructions[child].storeInstructions.maskedAdd(
-                    one_vector, mask, VECTOR_WIDTH);
+                instructions.storeInstructions.maskedAdd(
+                    1, mask);
                 break;
             case ExecutionType::BranchCond:
             case ExecutionType::BranchUncond:
-                criticalPathInstructions[child].branchInstructions.maskedAdd(
-                    one_vector, mask, VECTOR_WIDTH);
+                instructions.branchInstructions.maskedAdd(
+                    1, mask);
                 break;
             default:
-                criticalPathInstructions[child].otherInstructions.maskedAdd(
-                    one_vector, mask, VECTOR_WIDTH);
+                instructions.otherInstructions.maskedAdd(
+                    1, mask);
         }
     }
 
-    if (parent.type == VertexType::InstrFetch)
+    if (parent_type == VertexType::InstrFetch)
     {
-        if (child.type == VertexType::InstrFetch)
+        if (child_type == VertexType::InstrFetch)
         {
-            weight.smallerThanOrEqual(l2iThreshold, mask, comparison, VECTOR_WIDTH);
-            criticalPathCycles[child].goodFetchHitCycles.maskedAdd(
-                weight, comparison, VECTOR_WIDTH);
+            comparison = weight.smallerThanOrEqual<W>(l2iThreshold, mask);
+            cycles.goodFetchHitCycles.maskedAdd(
+                weight, comparison);
             
-            weight.largerThan(l2iThreshold, mask, comparison, VECTOR_WIDTH);
-            criticalPathCycles[child].goodFetchMissCycles.maskedAdd(
-                weight, comparison, VECTOR_WIDTH);
+            comparison = weight.largerThan<W>(l2iThreshold, mask);
+            cycles.goodFetchMissCycles.maskedAdd(
+                weight, comparison);
         }
-        else // child.type == VertexType::InstrDispatch
+        else // child_type == VertexType::InstrDispatch
         {
-            criticalPathCycles[child].decodeCycles.maskedAdd(
-                weight, mask, VECTOR_WIDTH);
+            cycles.decodeCycles.maskedAdd(
+                weight, mask);
         }
     }
-    else if (parent.type == VertexType::InstrDispatch)
+    else if (parent_type == VertexType::InstrDispatch)
     {
-        criticalPathCycles[child].dispatchCycles.maskedAdd(
-            weight, mask, VECTOR_WIDTH);
+        cycles.dispatchCycles.maskedAdd(
+            weight, mask);
     }
-    else if (parent.type == VertexType::InstrExecute)
+    else if (parent_type == VertexType::InstrExecute)
     {
-        if ((child.type == VertexType::InstrDispatch) ||
-            (child.type == VertexType::InstrExecute)  ||
-            (child.type == VertexType::MemExecute)    ||
-            (child.type == VertexType::InstrCommit))
+        if ((child_type == VertexType::InstrDispatch) ||
+            (child_type == VertexType::InstrExecute)  ||
+            (child_type == VertexType::MemExecute)    ||
+            (child_type == VertexType::InstrCommit))
         {
-            int parent_execution_type = executionType[parent.instrNum % AnalysisWindow];
             switch (parent_execution_type)
             {
                 case ExecutionType::IntBase:
                 case ExecutionType::IntMul:
                 case ExecutionType::IntDiv:
-                    criticalPathCycles[child].intCycles.maskedAdd(
-                        weight, mask, VECTOR_WIDTH);
+                    cycles.intCycles.maskedAdd(
+                        weight, mask);
                     break;
                 case ExecutionType::FpBase:
                 case ExecutionType::FpMul:
                 case ExecutionType::FpDiv:
-                    criticalPathCycles[child].fpCycles.maskedAdd(
-                        weight, mask, VECTOR_WIDTH);
+                    cycles.fpCycles.maskedAdd(
+                        weight, mask);
                     break;
                 case ExecutionType::Load:
                 case ExecutionType::Store:
-                    criticalPathCycles[child].lsCycles.maskedAdd(
-                        weight, mask, VECTOR_WIDTH);
+                    cycles.lsCycles.maskedAdd(
+                        weight, mask);
                     break;
                 case ExecutionType::BranchCond:
                 case ExecutionType::BranchUncond:
-                    criticalPathCycles[child].branchCycles.maskedAdd(
-                        weight, mask, VECTOR_WIDTH);
+                    cycles.branchCycles.maskedAdd(
+                        weight, mask);
                     break;
                 case ExecutionType::Syscall:
-                    criticalPathCycles[child].syscallCycles.maskedAdd(
-                        weight, mask, VECTOR_WIDTH);
+                    cycles.syscallCycles.maskedAdd(
+                        weight, mask);
                     break;
                 case ExecutionType::Atomic:
-                    criticalPathCycles[child].atomicCycles.maskedAdd(
-                        weight, mask, VECTOR_WIDTH);
+                    cycles.atomicCycles.maskedAdd(
+                        weight, mask);
                     break;
                 default: // ExecutionType::Other
-                    criticalPathCycles[child].otherCycles.maskedAdd(
-                        weight, mask, VECTOR_WIDTH);
+                    cycles.otherCycles.maskedAdd(
+                        weight, mask);
             }
         }
-        else // child.type == VertexType::InstrFetch
+        else // child_type == VertexType::InstrFetch
         {
             // The weight equals total cycles of RscIntAlu + mispredictionPenalty + fetchCycles
 
-            Vector br_weight(intAluTotalCycles);
-            criticalPathCycles[child].branchCycles.maskedAdd(
-                br_weight, mask, VECTOR_WIDTH);
+            cycles.branchCycles.maskedAdd(
+                (int64_t)intAluTotalCycles, mask);
 
-            Vector fetch_weight(weight, intAluTotalCycles);
+            WeightVector<W> fetch_weight(weight.toVector<W>(), intAluTotalCycles);
 
-            fetch_weight.smallerThanOrEqual(l2iThreshold, mask, comparison, VECTOR_WIDTH);
-            criticalPathCycles[child].badFetchHitCycles.maskedAdd(
-                fetch_weight, comparison, VECTOR_WIDTH);
+            comparison = fetch_weight.smallerThanOrEqual(l2iThreshold, mask);
+            cycles.badFetchHitCycles.maskedAdd(
+                fetch_weight, comparison);
 
-            fetch_weight.largerThan(l2iThreshold, mask, comparison, VECTOR_WIDTH);
-            criticalPathCycles[child].badFetchMissCycles.maskedAdd(
-                fetch_weight, comparison, VECTOR_WIDTH);
+            comparison = fetch_weight.largerThan(l2iThreshold, mask);
+            cycles.badFetchMissCycles.maskedAdd(
+                fetch_weight, comparison);
         }
     }
-    else if (parent.type == VertexType::MemExecute)
+    else if (parent_type == VertexType::MemExecute)
     {
-        int parent_execution_type = executionType[parent.instrNum % AnalysisWindow];
         if (parent_execution_type == ExecutionType::Load)
         {
-            weight.smallerThanOrEqual(l1dThreshold, mask, comparison, VECTOR_WIDTH);
-            criticalPathCycles[child].loadL1HitCycles.maskedAdd(
-                weight, comparison, VECTOR_WIDTH);
+            comparison = weight.smallerThanOrEqual<W>(l1dThreshold, mask);
+            cycles.loadL1HitCycles.maskedAdd(
+                weight, comparison);
 
-            weight.between(l1dThreshold, l2dThreshold, mask, comparison, VECTOR_WIDTH);
-            criticalPathCycles[child].loadL2HitCycles.maskedAdd(
-                weight, comparison, VECTOR_WIDTH);
+            comparison = weight.between<W>(l1dThreshold, l2dThreshold, mask);
+            cycles.loadL2HitCycles.maskedAdd(
+                weight, comparison);
 
-            weight.largerThan(l2dThreshold, mask, comparison, VECTOR_WIDTH);
-            criticalPathCycles[child].loadMissCycles.maskedAdd(
-                weight, comparison, VECTOR_WIDTH);
+            comparison = weight.largerThan<W>(l2dThreshold, mask);
+            cycles.loadMissCycles.maskedAdd(
+                weight, comparison);
         }
         else // parentExecutionType == ExecutionType::Store
         {
-            weight.smallerThanOrEqual(l1dThreshold, mask, comparison, VECTOR_WIDTH);
-            criticalPathCycles[child].storeL1HitCycles.maskedAdd(
-                weight, comparison, VECTOR_WIDTH);
+            comparison = weight.smallerThanOrEqual<W>(l1dThreshold, mask);
+            cycles.storeL1HitCycles.maskedAdd(
+                weight, comparison);
+
+            comparison = weight.between<W>(l1dThreshold, l2dThreshold, mask);
+            cycles.storeL2HitCycles.maskedAdd(
+                weight, comparison);
+
+            comparison = weight.largerThan<W>(l2dThreshold, mask);
+            cycles.storeMissCycles.maskedAdd(
+                weight, comparison);
+        }
+    }
+    else // parent_type == VertexType::InstrCommit
+    {
+        cycles.commitCycles.maskedAdd(
+            weight, mask);
+    }
+}
+
+template <uint32_t W>
+void VectorGraph<W>::resetPredecessorLog(Vertex& first_vertex)
+{
+    for (uint32_t i = 0; i < W; ++i)
+    {
+        predecessorLog[i].clear();
+        predecessorLog[i].push_back({0, 0, 0}); // Record 0 stands for no predecessor
+        firstPassRecord[i] = 1;
+        criticalPredecessors[first_vertex].record[i] = 0;
+    }
+}
+
+template <uint32_t W>
+void VectorGraph<W>::calculateLazyBreakdown(Vertex& last_vertex)
+{
+    // Walks the critical path of each scenario backwards from last_vertex and
+    // classifies its edges the same way updateCriticalPathCycles does.
+    CycleTypes<W>& last_cycles = criticalPathCycles[last_vertex];
+    InstructionTypes<W>& last_instructions = criticalPathInstructions[last_vertex];
+
+    for (uint32_t i = 0; i < W; ++i)
+    {
+        LaneMask mask = (LaneMask)1 << i;
+
+        CycleTypes<W> cycles;
+        InstructionTypes<W> instructions;
+        Vertex child = last_vertex;
+        uint32_t record = criticalPredecessors[child].record[i];
+        while (record != 0)
+        {
+            // A record only refers to older records, so the walk terminates
+            PredecessorRecord& r = predecessorLog[i][record];
+            uint64_t parent_num = vertexNumber(child) - r.parentDistance;
+            Vertex parent(parent_num % (VertexType::Last + 1),
+                          parent_num / (VertexType::Last + 1));
+            EdgeWeight weight(r.weight, i);
+            classifyEdge(parent, child, weight, mask, cycles, instructions);
+
+            child = parent;
+            record = r.parentRecord;
+        }
+
+        last_instructions.intInstructions.maskedSet(instructions.intInstructions, mask);
+        last_instructions.fpInstructions.maskedSet(instructions.fpInstructions, mask);
+        last_instructions.loadInstructions.maskedSet(instructions.loadInstructions, mask);
+        last_instructions.storeInstructions.maskedSet(instructions.storeInstructions, mask);
+        last_instructions.branchInstructions.maskedSet(instructions.branchInstructions, mask);
+        last_instructions.otherInstructions.maskedSet(instructions.otherInstructions, mask);
+
+        last_cycles.goodFetchHitCycles.maskedSet(cycles.goodFetchHitCycles, mask);
+        last_cycles.goodFetchMissCycles.maskedSet(cycles.goodFetchMissCycles, mask);
+        last_cycles.badFetchHitCycles.maskedSet(cycles.badFetchHitCycles, mask);
+        last_cycles.badFetchMissCycles.maskedSet(cycles.badFetchMissCycles, mask);
+        last_cycles.decodeCycles.maskedSet(cycles.decodeCycles, mask);
+        last_cycles.dispatchCycles.maskedSet(cycles.dispatchCycles, mask);
+        last_cycles.intCycles.maskedSet(cycles.intCycles, mask);
+        last_cycles.fpCycles.maskedSet(cycles.fpCycles, mask);
+        last_cycles.lsCycles.maskedSet(cycles.lsCycles, mask);
+        last_cycles.loadL1HitCycles.maskedSet(cycles.loadL1HitCycles, mask);
+        last_cycles.loadL2HitCycles.maskedSet(cycles.loadL2HitCycles, mask);
+        last_cycles.loadMissCycles.maskedSet(cycles.loadMissCycles, mask);
+        last_cycles.storeL1HitCycles.maskedSet(cycles.storeL1HitCycles, mask);
+        last_cycles.storeL2HitCycles.maskedSet(cycles.storeL2HitCycles, mask);
+        last_cycles.storeMissCycles.maskedSet(cycles.storeMissCycles, mask);
+        last_cycles.branchCycles.maskedSet(cycles.branchCycles, mask);
+        last_cycles.syscallCycles.maskedSet(cycles.syscallCycles, mask);
+        last_cycles.atomicCycles.maskedSet(cycles.atomicCycles, mask);
+        last_cycles.otherCycles.maskedSet(cycles.otherCycles, mask);
+        last_cycles.commitCycles.maskedSet(cycles.commitCycles, mask);
+    }
+}
 
-            weight.between(l1dThreshold, l2dThreshold, mask, comparison, VECTOR_WIDTH);
-            criticalPathCycles[child].storeL2HitCycles.maskedAdd(
-                weight, comparison, VECTOR_WIDTH);
+template <uint32_t W>
+void VectorGraph<W>::rebaseLengths(Vertex& newest_vertex)
+{
+    // Lengths are kept relative to lengthBase so that they fit in 32 bits.
+    // Shifting all lengths of a scenario by the same amount does not change
+    // the analysis; lengths that would fall below -LENGTH_REBASE_THRESHOLD
+    // belong to vertices that have long left the analysis window.
+    if (!needsRebase(length[newest_vertex]))
+    {
+        return;
+    }
+
+    LengthVector<W> shift = length[newest_vertex];
+    for (auto& entry : length)
+    {
+        entry.second.rebase(shift, -LENGTH_REBASE_THRESHOLD);
+    }
+    shiftLengthBase(shift);
+}
 
-            weight.largerThan(l2dThreshold, mask, comparison, VECTOR_WIDTH);
-            criticalPathCycles[child].storeMissCycles.maskedAdd(
-                weight, comparison, VECTOR_WIDTH);
+template <uint32_t W>
+bool VectorGraph<W>::needsRebase(const LengthVector<W>& newest_length)
+{
+    for (uint32_t i = 0; i < W; ++i)
+    {
+        if (newest_length[i] > LENGTH_REBASE_THRESHOLD)
+        {
+            return true;
         }
     }
-    else // parent.type == VertexType::InstrCommit
+    return false;
+}
+
+template <uint32_t W>
+void VectorGraph<W>::shiftLengthBase(const LengthVector<W>& shift)
+{
+    int64_t base[W];
+    for (uint32_t i = 0; i < W; ++i)
     {
-        criticalPathCycles[child].commitCycles.maskedAdd(
-            weight, mask, VECTOR_WIDTH);
+        base[i] = lengthBase[i] + shift[i];
     }
+    lengthBase = Vector<W>(base, W);
 }
 
-void Graph::recordStats(bool show_details, bool hopping_window)
+template <uint32_t W>
+void VectorGraph<W>::recordStats(bool show_details, bool hopping_window)
 {
     fstream result_file;
     result_file.open(resultFileName, fstream::out | fstream::app);
@@ -297,7 +576,12 @@ void Graph::recordStats(bool show_details, bool hopping_window)
     os << setprecision(4);
 
     Vertex last_vertex(VertexType::InstrCommit, instrCount - 1);
-    for (uint32_t i = 0; i < VECTOR_WIDTH; ++i)
+    if (lazyBreakdown)
+    {
+        calculateLazyBreakdown(last_vertex);
+    }
+
+    for (uint32_t i = 0; i < scenarioLabels.size(); ++i)
     {
         os << "--------------------------------------------------------------" << endl;
         os << "*** ";
@@ -305,7 +589,12 @@ void Graph::recordStats(bool show_details, bool hopping_window)
         {
             os << "Window " << analyzedWindows << ", ";
         }
-        os << "Scenario " << (int)i << endl << endl;
+        os << "Scenario " << (int)i;
+        if (!scenarioLabels[i].empty())
+        {
+            os << " (" << scenarioLabels[i] << ")";
+        }
+        os << endl << endl;
 
         os << "Total instructions count:  " << instrCount << endl;
         if (hopping_window)
@@ -313,9 +602,10 @@ void Graph::recordStats(bool show_details, bool hopping_window)
             os << "Window instructions count: " << window_instructions << endl << endl;
         }
 
-        os << "Length: " << length[last_vertex][i] << endl;
-        os << "ILP:    " << ((double)window_instructions / (double)length[last_vertex][i]) << endl;
-        os << "CPI:    " << ((double)length[last_vertex][i] / (double)window_instructions) << endl;
+        int64_t absolute_length = absoluteLength(last_vertex, i);
+        os << "Length: " << absolute_length << endl;
+        os << "ILP:    " << ((double)window_instructions / (double)absolute_length) << endl;
+        os << "CPI:    " << ((double)absolute_length / (double)window_instructions) << endl;
 
         if (show_details)
         {
@@ -323,64 +613,64 @@ void Graph::recordStats(bool show_details, bool hopping_window)
 
             double good_fetch_hit_cycles =
                 ((double)criticalPathCycles[last_vertex].goodFetchHitCycles[i] /
-                 (double)length[last_vertex][i]) * 100;
+                 (double)absolute_length) * 100;
             double good_fetch_miss_cycles =
                 ((double)criticalPathCycles[last_vertex].goodFetchMissCycles[i] /
-                 (double)length[last_vertex][i]) * 100;
+                 (double)absolute_length) * 100;
             double bad_fetch_hit_cycles =
                 ((double)criticalPathCycles[last_vertex].badFetchHitCycles[i] /
-                 (double)length[last_vertex][i]) * 100;
+                 (double)absolute_length) * 100;
             double bad_fetch_miss_cycles =
                 ((double)criticalPathCycles[last_vertex].badFetchMissCycles[i] /
-                 (double)length[last_vertex][i]) * 100;
+                 (double)absolute_length) * 100;
             double decode_cycles =
                 ((double)criticalPathCycles[last_vertex].decodeCycles[i] /
-                 (double)length[last_vertex][i]) * 100;
+                 (double)absolute_length) * 100;
             double dispatch_cycles =
                 ((double)criticalPathCycles[last_vertex].dispatchCycles[i] /
-                 (double)length[last_vertex][i]) * 100;
+                 (double)absolute_length) * 100;
             double int_cycles =
                 ((double)criticalPathCycles[last_vertex].intCycles[i] /
-                 (double)length[last_vertex][i]) * 100;
+                 (double)absolute_length) * 100;
             double fp_cycles =
                 ((double)criticalPathCycles[last_vertex].fpCycles[i] /
-                 (double)length[last_vertex][i]) * 100;
+                 (double)absolute_length) * 100;
             double ls_cycles =
                 ((double)criticalPathCycles[last_vertex].lsCycles[i] /
-                 (double)length[last_vertex][i]) * 100;
+                 (double)absolute_length) * 100;
             double load_l1_hit_cycles =
                 ((double)criticalPathCycles[last_vertex].loadL1HitCycles[i] /
-                 (double)length[last_vertex][i]) * 100;
+                 (double)absolute_length) * 100;
             double load_l2_hit_cycles =
                 ((double)criticalPathCycles[last_vertex].loadL2HitCycles[i] /
-                 (double)length[last_vertex][i]) * 100;
+                 (double)absolute_length) * 100;
             double load_miss_cycles =
                 ((double)criticalPathCycles[last_vertex].loadMissCycles[i] /
-                 (double)length[last_vertex][i]) * 100;
+                 (double)absolute_length) * 100;
             double store_l1_hit_cycles =
                 ((double)criticalPathCycles[last_vertex].storeL1HitCycles[i] /
-                 (double)length[last_vertex][i]) * 100;
+                 (double)absolute_length) * 100;
             double store_l2_hit_cycles =
                 ((double)criticalPathCycles[last_vertex].storeL2HitCycles[i] /
-                 (double)length[last_vertex][i]) * 100;
+                 (double)absolute_length) * 100;
             double store_miss_cycles =
                 ((double)criticalPathCycles[last_vertex].storeMissCycles[i] /
-                 (double)length[last_vertex][i]) * 100;
+                 (double)absolute_length) * 100;
             double branch_cycles =
                 ((double)criticalPathCycles[last_vertex].branchCycles[i] /
-                 (double)length[last_vertex][i]) * 100;
+                 (double)absolute_length) * 100;
             double syscall_cycles =
                 ((double)criticalPathCycles[last_vertex].syscallCycles[i] /
-                 (double)length[last_vertex][i]) * 100;
+                 (double)absolute_length) * 100;
             double atomic_cycles =
                 ((double)criticalPathCycles[last_vertex].atomicCycles[i] /
-                 (double)length[last_vertex][i]) * 100;
+                 (double)absolute_length) * 100;
             double other_cycles =
                 ((double)criticalPathCycles[last_vertex].otherCycles[i] /
-                 (double)length[last_vertex][i]) * 100;
+                 (double)absolute_length) * 100;
             double commit_cycles =
                 ((double)criticalPathCycles[last_vertex].commitCycles[i] /
-                 (double)length[last_vertex][i]) * 100;
+                 (double)absolute_length) * 100;
 
             uint64_t critical_instructions =
                 criticalPathInstructions[last_vertex].intInstructions[i] +
@@ -570,18 +860,23 @@ void Graph::recordStats(bool show_details, bool hopping_window)
     cout << "--------------------------------------------------------------" << endl;
 }
 
-void Graph::printEdge(Vertex& parent, OutgoingEdge& e)
+template <uint32_t W>
+void VectorGraph<W>::printEdge(Vertex& parent, OutgoingEdge& e)
 {
     cout << "*** Edge: "
          << parent.instrNum << "," << (int)parent.type << " to " 
          << e.child.instrNum << "," << (int)e.child.type << "; " 
-         << e.weight.toString() << endl;
+         << e.weight.toString<W>() << endl;
 }
 
-void Graph::printEdge(Vertex& child, IncomingEdge& e)
+template <uint32_t W>
+void VectorGraph<W>::printEdge(Vertex& child, IncomingEdge& e)
 {
     cout << "*** Edge: "
          << e.parent.instrNum << "," << (int)e.parent.type << " to " 
          << child.instrNum << "," << (int)child.type << "; " 
-         << e.weight.toString() << endl;
+         << e.weight.toString<W>() << endl;
 }
+
+#define INSTANTIATE_VECTOR_GRAPH(w) template class VectorGraph<w>;
+FOR_EACH_VECTOR_WIDTH(INSTANTIATE_VECTOR_GRAPH)
@@ -28,6 +28,7 @@
 #include "calipers_types.h"
 #include "instruction_stream.h"
 #include "graph_util.h"
+#include "schedule_queue.h"
 #include "cache.h"
 #include "branch_predictor.h"
 
@@ -36,11 +37,10 @@
  */
 class Graph
 {
-  private:
+  protected:
     string traceFileName;
     string resultFileName;
 
-  protected:
     struct VertexHash
     {
         uint64_t operator()(const Vertex& vertex) const
@@ -59,22 +59,6 @@ class Graph
        }
     };
 
-struct ScheduleComparison
-{
-    bool operator()(const std::pair<unsigned long, long>& lhs, const std::pair<unsigned long, long>& rhs) const
-    {
-        if (lhs.second != rhs.second)
-        {
-            return lhs.second < rhs.second;
-        }
-        else
-        {
-            return lhs.first < rhs.first;
-        }
-    }
-};
-
-
     struct VertexScheduleComparison
     {
         bool operator()(const pair<Vertex, int64_t>& lhs, const pair<Vertex, int64_t>& rhs)
@@ -94,8 +78,8 @@ struct ScheduleComparison
         }
     };
 
-    typedef std::set<pair<uint64_t, int64_t>, ScheduleComparison> ScheduleSet;
-    // First: Instruction number, Second: Critical path length
+    typedef ScheduleQueue ScheduleSet;
+    // <Instruction number, Critical path length> pairs sorted based on length
     // Used for per-instruction (per-InstrExecute-vertex) scheduling
 
     typedef std::set<pair<Vertex, int64_t>, VertexScheduleComparison> VertexScheduleSet;
@@ -120,20 +104,6 @@ struct ScheduleComparison
     // Key: Instruction number % AnalysisWindow, Value: ExecutionType (-1 for invalid)
 
 
-    /*** Analysis outcome ***/
-
-    // The size Vertex-key'ed maps are controlled through the corresponding key-equal function
-
-    unordered_map<Vertex, Vector, VertexHash, VertexEqual> length;
-    // length[v] = Length of the critical path to Vertex v
-    //VertexToVectorMapExp lengthExp;
-
-    unordered_map<Vertex, CycleTypes, VertexHash, VertexEqual> criticalPathCycles;
-    // criticalPathCycles[v] = Composition of cycles on the critical path to Vertex v
-
-    unordered_map<Vertex, InstructionTypes, VertexHash, VertexEqual> criticalPathInstructions;
-    // criticalPathInstructions[v] = Composition of instructions on the critical path to Vertex v
-    
     uint64_t instructionMix[6];
     // 0: int, 1: fp, 2: load, 3: store, 4: branch, 5: other
 
@@ -153,15 +123,120 @@ struct ScheduleComparison
     uint64_t branchCount;
 
 
-    void updateCriticalPathCycles(Vertex& parent, OutgoingEdge& e);
-    void recordStats(bool show_details, bool hopping_window);
-    void printEdge(Vertex& parent, OutgoingEdge& e);
-    void printEdge(Vertex& child, IncomingEdge& e);
+    uint64_t vertexNumber(Vertex& v)
+    {
+        return v.instrNum * (VertexType::Last + 1) + v.type;
+    }
+    int32_t vertexDistance(Vertex& parent, Vertex& child)
+    {
+        return (int32_t)(vertexNumber(child) - vertexNumber(parent));
+    }
 
   public:
     static uint32_t AnalysisWindow;
     Graph(string trace_file_name, string result_file_name, InstructionStream* instr_stream);
+    virtual ~Graph() {}
     virtual void run() = 0;
+
+    virtual void setShard(uint64_t functional_begin, uint64_t detailed_begin,
+                          uint64_t shard_begin, uint64_t shard_end);
+    // Runs the windows of the instructions [shard_begin, shard_end) of the trace, after a
+    // functional warmup from functional_begin and a detailed warmup from detailed_begin.
+    // The instruction stream must be at functional_begin (see InstructionStream::seek).
+};
+
+
+/**
+ * The base class for graph-based modeling of a processor for W scenarios
+ * The graph engines are instantiated for each width in FOR_EACH_VECTOR_WIDTH.
+ */
+template <uint32_t W>
+class VectorGraph : public Graph
+{
+  protected:
+    /*** Analysis outcome ***/
+
+    // The size Vertex-key'ed maps are controlled through the corresponding key-equal function
+
+    unordered_map<Vertex, LengthVector<W>, VertexHash, VertexEqual> length;
+    // length[v] = Length of the critical path to Vertex v, relative to lengthBase
+    //VertexToVectorMapExp lengthExp;
+
+    Vector<W> lengthBase;
+    // The per-scenario base of the (window-relative) lengths
+
+    unordered_map<Vertex, CycleTypes<W>, VertexHash, VertexEqual> criticalPathCycles;
+    // criticalPathCycles[v] = Composition of cycles on the critical path to Vertex v
+
+    unordered_map<Vertex, InstructionTypes<W>, VertexHash, VertexEqual> criticalPathInstructions;
+    // criticalPathInstructions[v] = Composition of instructions on the critical path to Vertex v
+
+    bool lazyBreakdown;
+    // If set, criticalPathCycles and criticalPathInstructions are only calculated
+    // for the last vertex when the stats are recorded (see criticalPredecessors)
+
+    unordered_map<Vertex, CriticalPredecessors<W>, VertexHash, VertexEqual> criticalPredecessors;
+    // criticalPredecessors[v] = The winning incoming edges of Vertex v (only used if lazyBreakdown)
+
+    vector<PredecessorRecord> predecessorLog[W];
+    // Log of winning edges per scenario, so that a walk sees the critical path
+    // of each parent as it was when the child was relaxed
+
+    uint32_t firstPassRecord[W];
+    // firstPassRecord[i] = The first record of the current relaxation pass of scenario i.
+    // A pass visits the vertices in a topological order, so a vertex record made in the
+    // pass is not referenced before the vertex is visited, and is overwritten in place
+    // when the vertex is relaxed again (each vertex keeps one slot per pass).
+
+    vector<string> scenarioLabels;
+    // scenarioLabels[i] = Parameter values of scenario i (only the labeled scenarios are reported)
+
+    typedef struct VERTEX_ENTRIES
+    {
+        LengthVector<W>* length;
+        CycleTypes<W>* cycles; // NULL if lazyBreakdown
+        InstructionTypes<W>* instructions; // NULL if lazyBreakdown
+        CriticalPredecessors<W>* predecessors; // NULL unless lazyBreakdown
+    } VertexEntries;
+    // The map entries of a vertex (the entries of an unordered_map keep their
+    // addresses when it rehashes), so that a pass over many edges of the same
+    // vertices can look them up once
+
+
+    VertexEntries vertexEntries(Vertex& v);
+    int vertexExecutionType(Vertex& v);
+    LaneMask updateCriticalPathCycles(Vertex& parent, OutgoingEdge& e);
+    LaneMask updateCriticalPathCycles(Vertex& parent, Vertex& child, int parent_execution_type,
+                                      EdgeWeight& weight, VertexEntries& parent_entries,
+                                      VertexEntries& child_entries);
+    // Both return the scenarios where the edge sets the length (and breakdown) of the child
+    void copyBreakdown(CycleTypes<W>& child_cycles, CycleTypes<W>& parent_cycles,
+                       InstructionTypes<W>& child_instructions,
+                       InstructionTypes<W>& parent_instructions, LaneMask mask);
+    void classifyEdge(Vertex& parent, Vertex& child, EdgeWeight& weight, LaneMask mask,
+                      CycleTypes<W>& cycles, InstructionTypes<W>& instructions);
+    void classifyEdge(int parent_type, int child_type, int parent_execution_type,
+                      EdgeWeight& weight, LaneMask mask,
+                      CycleTypes<W>& cycles, InstructionTypes<W>& instructions);
+    void resetPredecessorLog(Vertex& first_vertex);
+    void calculateLazyBreakdown(Vertex& last_vertex);
+    void rebaseLengths(Vertex& newest_vertex);
+    bool needsRebase(const LengthVector<W>& newest_length);
+    void shiftLengthBase(const LengthVector<W>& shift);
+    int64_t absoluteLength(Vertex& v, uint32_t idx)
+    {
+        return lengthBase[idx] + length[v][idx];
+    }
+    void recordStats(bool show_details, bool hopping_window);
+    void printEdge(Vertex& parent, OutgoingEdge& e);
+    void printEdge(Vertex& child, IncomingEdge& e);
+    static LaneGroups groupLanes(const vector<uint32_t>& values);
+    static LaneMask lanesOtherThan(const LaneGroups& groups, uint32_t value);
+    static uint64_t instructionBytes();
+
+  public:
+    VectorGraph(string trace_file_name, string result_file_name, InstructionStream* instr_stream);
+    void setScenarioLabels(const vector<string>& labels);
 };
 
 #endif // GRAPH_H
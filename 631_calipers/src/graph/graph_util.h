@@ -28,222 +28,669 @@
 #include <unordered_map>
 #include <set>
 #include <vector>
+#include <limits>
+#include <string>
+#include <algorithm>
+#include <memory>
+#include <mutex>
 
 #include "calipers_defs.h"
+#include "vector_kernels.h"
 
 using namespace std;
 
 
+class EdgeWeight;
+
 /**
- * A utility class for vector-weighted edges
+ * A utility class for vector-weighted edges and vector-valued path lengths
+ * There is one lane per scenario and W (the number of scenarios) is a
+ * template parameter, so that loops over the lanes are fully unrolled.
+ * The element type is narrowed where the values allow it: edge weights and
+ * (window-relative) critical path lengths use 32-bit lanes, while the
+ * accumulated statistics use 64-bit lanes.
+ * An ABSENT element denotes that the corresponding edge does not exist in
+ * that specific scenario.
+ * Element access is only bounds-checked in CALIPERS_DEBUG builds.
  */
-class Vector
+template <typename T, uint32_t W>
+class BasicVector
 {
   private:
-    int64_t vec[VECTOR_WIDTH];
+    T vec[W];
+
+    template <typename U, uint32_t V>
+    friend class BasicVector;
+
+    static_assert((W > 0) && (W <= MAX_VECTOR_WIDTH), "Unsupported vector width");
 
   public:
-    Vector(int64_t* arr, uint32_t width)
+    static constexpr T ABSENT = numeric_limits<T>::max();
+
+    BasicVector(T* arr, uint32_t width)
     {
-        if (width != VECTOR_WIDTH)
+        if (width != W)
         {
             CALIPERS_ERROR("Invalid array width in vector init");
         }
-        for (uint32_t i = 0; i < VECTOR_WIDTH; ++i)
+        for (uint32_t i = 0; i < W; ++i)
         {
             vec[i] = arr[i];
         }
     }
 
-    Vector(int64_t* arr, uint32_t width, int64_t offset)
+    BasicVector(T* arr, uint32_t width, T offset)
     {
-        if (width != VECTOR_WIDTH)
+        if (width != W)
         {
             CALIPERS_ERROR("Invalid array width in vector init with offset");
         }
-        for (uint32_t i = 0; i < VECTOR_WIDTH; ++i)
+        for (uint32_t i = 0; i < W; ++i)
         {
             vec[i] = arr[i] - offset;
         }
     }
 
-    Vector(const Vector& v_in, int64_t offset)
+    template <typename U>
+    BasicVector(const BasicVector<U, W>& v_in, T offset)
     {
-        for (uint32_t i = 0; i < VECTOR_WIDTH; ++i)
+        for (uint32_t i = 0; i < W; ++i)
         {
-            vec[i] = v_in[i] - offset;
+            vec[i] = (v_in.vec[i] == BasicVector<U, W>::ABSENT) ? ABSENT : ((T)v_in.vec[i] - offset);
         }
     }
 
-    Vector(int64_t val)
+    BasicVector(T val)
     {
-        for (uint32_t i = 0; i < VECTOR_WIDTH; ++i)
+        for (uint32_t i = 0; i < W; ++i)
         {
             vec[i] = val;
         }
     }
 
-    Vector(int64_t val, uint32_t idx)
+    BasicVector(T val, uint32_t idx)
     {
-        if (idx >= VECTOR_WIDTH)
+        if (idx >= W)
         {
             CALIPERS_ERROR("Invalid index in vector init");
         }
-        for (uint32_t i = 0; i < VECTOR_WIDTH; ++i)
+        for (uint32_t i = 0; i < W; ++i)
         {
-            vec[i] = INT64_MAX;
+            vec[i] = ABSENT;
         }
         vec[idx] = val;
     }
-    Vector() : Vector(0)
+    BasicVector() : BasicVector(0)
     {}
 
-    void operator=(const Vector& v_in)
+    BasicVector(const BasicVector& v_in) = default;
+    BasicVector& operator=(const BasicVector& v_in) = default;
+
+    T operator[](const uint32_t idx) const
     {
-        for (uint32_t i = 0; i < VECTOR_WIDTH; ++i)
+#ifdef CALIPERS_DEBUG
+        if (idx >= W)
         {
-            vec[i] = v_in[i];
+            CALIPERS_ERROR("Invalid index for vector element access");
         }
+#endif
+        return vec[idx];
     }
 
-    int64_t operator[](const uint32_t idx) const
+    const T* lanes() const
     {
-        if (idx >= VECTOR_WIDTH)
+        return vec;
+    }
+
+    bool operator==(const BasicVector& v_in) const
+    {
+        for (uint32_t i = 0; i < W; ++i)
         {
-            CALIPERS_ERROR("Invalid index for vector element access");
+            if (vec[i] != v_in.vec[i])
+            {
+                return false;
+            }
         }
-        return vec[idx];
+        return true;
+    }
+
+    // Max-plus update; returns the lanes that were updated (including ties)
+    template <typename U>
+    LaneMask update(const BasicVector& v_in1, const BasicVector<U, W>& v_in2)
+    {
+        return kernels::relaxMixed<W>(vec, v_in1.vec, v_in2.vec, BasicVector<U, W>::ABSENT);
+    }
+
+    LaneMask update(const BasicVector& v_in, const EdgeWeight& weight);
+
+    void maskedSet(const BasicVector& v_in, LaneMask mask)
+    {
+        kernels::blendMasked<W>(vec, v_in.vec, mask);
+    }
+
+    template <typename U>
+    void maskedAdd(const BasicVector<U, W>& v_in, LaneMask mask)
+    {
+        kernels::addMasked<W>(vec, v_in.vec, mask);
+    }
+
+    void maskedAdd(T val, LaneMask mask)
+    {
+        kernels::addScalarMasked<W>(vec, val, mask);
+    }
+
+    void maskedAdd(const EdgeWeight& weight, LaneMask mask);
+
+    // Subtracts shift from all elements, saturating at floor
+    void rebase(const BasicVector& shift, T floor)
+    {
+        for (uint32_t i = 0; i < W; ++i)
+        {
+            int64_t shifted = (int64_t)vec[i] - (int64_t)shift.vec[i];
+            vec[i] = (shifted > floor) ? (T)shifted : floor;
+        }
+    }
+
+    LaneMask largerThan(T val, LaneMask mask) const
+    {
+        return kernels::compareGreater<W>(vec, val, mask);
+    }
+
+    LaneMask smallerThanOrEqual(T val, LaneMask mask) const
+    {
+        return mask & ~kernels::compareGreater<W>(vec, val, mask);
+    }
+
+    LaneMask between(T val1, T val2, LaneMask mask) const
+    {
+        return kernels::compareGreater<W>(vec, val1, mask) &
+               ~kernels::compareGreater<W>(vec, val2, mask);
+    }
+
+    string toString()
+    {
+        string s = "";
+        for (uint32_t i = 0; i < W; ++i)
+        {
+            s.append(to_string(vec[i]) + " ");
+        }
+        return s;
+    }
+};
+
+template <uint32_t W>
+using Vector = BasicVector<int64_t, W>;
+// Statistics (e.g., critical path cycle/instruction breakdowns)
+
+template <uint32_t W>
+using LengthVector = BasicVector<int32_t, W>;
+// Critical path lengths, relative to a per-scenario 64-bit base
+
+template <uint32_t W>
+using WeightVector = BasicVector<int32_t, W>;
+// Edge weights
+
+
+/**
+ * A compact weight for vector-weighted edges
+ * Most edges have the same weight in all scenarios, so the weight is stored as
+ * a scalar. An edge that only exists in one scenario (e.g., a per-scenario
+ * resource edge) keeps the index of that scenario inline. Only the edges whose
+ * weights really differ across scenarios refer to their per-scenario weights,
+ * which are interned in a pool shared by all edges.
+ * The pool is shared by the threads that construct and analyze overlapped
+ * windows, so interning is serialized and the pool grows in chunks that never
+ * move; the interned weights are read without locking.
+ * An edge weight does not depend on the number of scenarios, except for the
+ * interned weights, which the users read with the right width.
+ */
+class EdgeWeight
+{
+  private:
+    int32_t val; // Weight of all scenarios, or of the only scenario the edge exists in
+    int32_t tag; // UNIFORM, the index of the only scenario, or the encoded pool offset
+
+    static const int32_t UNIFORM = -1;
+
+    static const uint32_t MixedChunkBits = 16;
+    static const uint32_t MixedChunkLanes = 1 << MixedChunkBits;
+    static const uint32_t MaxMixedChunks = 1 << 14; // Keeps the encoded pool offsets in range
+
+    static unique_ptr<int32_t[]> mixedWeights[MaxMixedChunks];
+    // The pool of interned weights that differ across scenarios (never shrinks)
+    // The weights of an edge never straddle two chunks
+
+    static uint32_t mixedWeightsSize;
+    // Lanes allocated in the pool, including the unused tails of full chunks
+
+    static unordered_map<string, int32_t> mixedWeightIndex;
+    // Key: Raw bytes of the per-scenario weights, Value: Encoded offset of the weights in the pool
+
+    static mutex mixedWeightMutex;
+    // Guards mixedWeightIndex and the allocation of the pool
+
+    static int32_t mixedTag(uint32_t pool_offset)
+    {
+        return -2 - (int32_t)pool_offset;
+    }
+
+    static uint32_t poolOffset(int32_t tag)
+    {
+        return (uint32_t)(-2 - tag);
+    }
+
+    static int32_t* poolLanes(uint32_t pool_offset)
+    {
+        return mixedWeights[pool_offset >> MixedChunkBits].get() + (pool_offset & (MixedChunkLanes - 1));
     }
 
-    void update(const Vector& v_in1, const Vector& v_in2)
+    // Room for the given lanes in the pool (mixedWeightMutex must be held)
+    static uint32_t allocateMixed(uint32_t lanes)
     {
-        for (uint32_t i = 0; i < VECTOR_WIDTH; ++i)
+        uint32_t chunk_offset = mixedWeightsSize & (MixedChunkLanes - 1);
+        if ((chunk_offset == 0) || ((chunk_offset + lanes) > MixedChunkLanes))
         {
-            if ((v_in2[i] != INT64_MAX) && (v_in1[i] + v_in2[i] > vec[i]))
+            uint32_t chunk = (mixedWeightsSize + MixedChunkLanes - 1) >> MixedChunkBits;
+            if (chunk >= MaxMixedChunks)
             {
-                vec[i] = v_in1[i] + v_in2[i];
+                CALIPERS_ERROR("Too many distinct edge weights");
             }
+            mixedWeights[chunk].reset(new int32_t[MixedChunkLanes]);
+            mixedWeightsSize = chunk << MixedChunkBits;
         }
+        uint32_t pool_offset = mixedWeightsSize;
+        mixedWeightsSize += lanes;
+        return pool_offset;
     }
 
-    void update(const Vector& v_in1, const Vector& v_in2, bool* mask, uint32_t width)
+    static int32_t narrow(int64_t val)
     {
-        if (width != VECTOR_WIDTH)
+        if (val == INT64_MAX)
         {
-            CALIPERS_ERROR("Invalid output mask width in vector update");
+            return ABSENT;
         }
-        for (uint32_t i = 0; i < VECTOR_WIDTH; ++i)
+        if ((val < INT32_MIN) || (val >= ABSENT))
         {
-            if ((v_in2[i] != INT64_MAX) && (v_in1[i] + v_in2[i] >= vec[i]))
+            CALIPERS_ERROR("Edge weight out of range: " << val);
+        }
+        return (int32_t)val;
+    }
+
+    // The lanes of mask for which the condition on a scalar weight holds
+    LaneMask scalarCondition(bool condition, LaneMask mask) const
+    {
+        if (!condition)
+        {
+            return 0;
+        }
+        return (tag == UNIFORM) ? mask : (mask & ((LaneMask)1 << tag));
+    }
+
+  public:
+    static constexpr int32_t ABSENT = numeric_limits<int32_t>::max();
+
+    EdgeWeight(int64_t val) : val(narrow(val)), tag(UNIFORM)
+    {}
+
+    EdgeWeight(int64_t val, uint32_t idx) : val(narrow(val)), tag(idx)
+    {
+        if (idx >= MAX_VECTOR_WIDTH)
+        {
+            CALIPERS_ERROR("Invalid index in edge weight init");
+        }
+    }
+
+    template <uint32_t W>
+    EdgeWeight(const WeightVector<W>& v)
+    {
+        uint32_t present = 0;
+        uint32_t present_idx = 0;
+        bool uniform = true;
+        for (uint32_t i = 0; i < W; ++i)
+        {
+            uniform = uniform && (v[i] == v[0]);
+            if (v[i] != ABSENT)
             {
-                vec[i] = v_in1[i] + v_in2[i];
-                mask[i] = true;
+                ++present;
+                present_idx = i;
             }
-            else
+        }
+
+        if (uniform)
+        {
+            val = v[0];
+            tag = UNIFORM;
+        }
+        else if (present == 1)
+        {
+            val = v[present_idx];
+            tag = present_idx;
+        }
+        else
+        {
+            string key((const char*)v.lanes(), W * sizeof(int32_t));
+            lock_guard<mutex> lock(mixedWeightMutex);
+            auto it = mixedWeightIndex.find(key);
+            if (it == mixedWeightIndex.end())
             {
-                mask[i] = false;
+                uint32_t pool_offset = allocateMixed(W);
+                copy(v.lanes(), v.lanes() + W, poolLanes(pool_offset));
+                it = mixedWeightIndex.emplace(key, mixedTag(pool_offset)).first;
             }
+            val = 0;
+            tag = it->second;
         }
     }
 
-    void maskedSet(const Vector& v_in, bool* mask, uint32_t width)
+    EdgeWeight() : EdgeWeight(0)
+    {}
+
+    // A weight of val in the given lanes, where the edge does not exist in the other lanes
+    template <uint32_t W>
+    static EdgeWeight inLanes(int64_t val, LaneMask lanes)
     {
-        if (width != VECTOR_WIDTH)
+        if (lanes == allLanes<W>())
         {
-            CALIPERS_ERROR("Invalid input mask width in vector maskedSet");
+            return EdgeWeight(val);
         }
-        for (uint32_t i = 0; i < VECTOR_WIDTH; ++i)
+        int32_t lane_val = narrow(val);
+        int32_t arr[W];
+        for (uint32_t i = 0; i < W; ++i)
         {
-            if (mask[i])
-            {
-                vec[i] = v_in[i];
-            }
+            arr[i] = ((lanes >> i) & 1) ? lane_val : ABSENT;
         }
+        return EdgeWeight(WeightVector<W>(arr, W));
     }
 
-    void maskedAdd(const Vector& v_in, bool* mask, uint32_t width)
+    // This weight plus offset (in the lanes where the edge exists)
+    template <uint32_t W>
+    EdgeWeight shifted(int64_t offset) const
     {
-        if (width != VECTOR_WIDTH)
+        if (!isMixed())
         {
-            CALIPERS_ERROR("Invalid input mask width in vector maskedAdd");
+            return (tag == UNIFORM) ? EdgeWeight(val + offset) : EdgeWeight(val + offset, tag);
         }
-        for (uint32_t i = 0; i < VECTOR_WIDTH; ++i)
+        int32_t arr[W];
+        const int32_t* lanes = mixedLanes();
+        for (uint32_t i = 0; i < W; ++i)
         {
-            if (mask[i])
-            {
-                vec[i] += v_in[i];
-            }
+            arr[i] = (lanes[i] == ABSENT) ? ABSENT : narrow(lanes[i] + offset);
         }
+        return EdgeWeight(WeightVector<W>(arr, W));
     }
 
-    void largerThan(int64_t val, bool* mask, bool* result, uint32_t width)
+    // The weight of one edge that replaces this edge and a parallel edge
+    // (the larger weight in the lanes where both edges exist)
+    template <uint32_t W>
+    EdgeWeight merged(const EdgeWeight& other) const
     {
-        if (width != VECTOR_WIDTH)
+        if (isUniform() && other.isUniform() && (val != ABSENT) && (other.val != ABSENT))
         {
-            CALIPERS_ERROR("Invalid mask/result width in vector largerThan");
+            return EdgeWeight(max(val, other.val));
         }
-        for (uint32_t i = 0; i < VECTOR_WIDTH; ++i)
+        int32_t arr[W];
+        for (uint32_t i = 0; i < W; ++i)
         {
-            if (mask[i] && (vec[i] > val))
-            {
-                result[i] = true;
-            }
-            else
-            {
-                result[i] = false;
-            }
+            int32_t w1 = (*this)[i];
+            int32_t w2 = other[i];
+            arr[i] = (w1 == ABSENT) ? w2 : ((w2 == ABSENT) ? w1 : max(w1, w2));
         }
+        return EdgeWeight(WeightVector<W>(arr, W));
     }
 
-    void smallerThanOrEqual(int64_t val, bool* mask, bool* result, uint32_t width)
+    // The lanes in which the edge exists
+    template <uint32_t W>
+    LaneMask presentLanes() const
     {
-        if (width != VECTOR_WIDTH)
+        if (tag == UNIFORM)
         {
-            CALIPERS_ERROR("Invalid mask/result width in vector smallerThanOrEqual");
+            return (val == ABSENT) ? 0 : allLanes<W>();
         }
-        for (uint32_t i = 0; i < VECTOR_WIDTH; ++i)
+        if (tag >= 0)
         {
-            if (mask[i] && (vec[i] <= val))
-            {
-                result[i] = true;
-            }
-            else
+            return (LaneMask)1 << tag;
+        }
+        LaneMask lanes = 0;
+        const int32_t* mixed = mixedLanes();
+        for (uint32_t i = 0; i < W; ++i)
+        {
+            if (mixed[i] != ABSENT)
             {
-                result[i] = false;
+                lanes |= (LaneMask)1 << i;
             }
         }
+        return lanes;
+    }
+
+    // The smallest weight in the lanes where the edge exists (ABSENT if none)
+    template <uint32_t W>
+    int32_t minimum() const
+    {
+        if (!isMixed())
+        {
+            return val;
+        }
+        int32_t result = ABSENT;
+        const int32_t* mixed = mixedLanes();
+        for (uint32_t i = 0; i < W; ++i)
+        {
+            result = min(result, mixed[i]);
+        }
+        return result;
     }
 
-    void between(int64_t val1, int64_t val2, bool* mask, bool* result, uint32_t width)
+    // The largest weight in the lanes where the edge exists (ABSENT if none)
+    template <uint32_t W>
+    int32_t maximum() const
     {
-        if (width != VECTOR_WIDTH)
+        if (!isMixed())
         {
-            CALIPERS_ERROR("Invalid mask/result width in vector between");
+            return val;
         }
-        for (uint32_t i = 0; i < VECTOR_WIDTH; ++i)
+        int32_t result = ABSENT;
+        const int32_t* mixed = mixedLanes();
+        for (uint32_t i = 0; i < W; ++i)
         {
-            if (mask[i] && (vec[i] > val1) && (vec[i] <= val2))
+            if ((mixed[i] != ABSENT) && ((result == ABSENT) || (mixed[i] > result)))
             {
-                result[i] = true;
+                result = mixed[i];
             }
-            else
+        }
+        return result;
+    }
+
+    // The lanes of mask in which a path of two edges with the given weights
+    // exists and is strictly longer than this edge
+    template <uint32_t W>
+    LaneMask shorterThanPath(const EdgeWeight& first, const EdgeWeight& second,
+                             LaneMask mask) const
+    {
+        LaneMask lanes = 0;
+        mask &= first.presentLanes<W>() & second.presentLanes<W>();
+        while (mask != 0)
+        {
+            uint32_t i = __builtin_ctzll(mask);
+            if ((int64_t)first[i] + second[i] > (*this)[i])
             {
-                result[i] = false;
+                lanes |= (LaneMask)1 << i;
             }
+            mask &= mask - 1;
         }
+        return lanes;
     }
 
-    string toString()
+    // A weight with the given per-lane values
+    template <uint32_t W>
+    static EdgeWeight fromLanes(const vector<uint32_t>& values)
     {
-        string s = "";
-        for (uint32_t i = 0; i < VECTOR_WIDTH; ++i)
+        if (values.size() != W)
         {
-            s.append(to_string(vec[i]) + " ");
+            CALIPERS_ERROR("Invalid number of lanes in edge weight init");
         }
-        return s;
+        int32_t arr[W];
+        for (uint32_t i = 0; i < W; ++i)
+        {
+            arr[i] = narrow(values[i]);
+        }
+        return EdgeWeight(WeightVector<W>(arr, W));
+    }
+
+    bool isUniform() const
+    {
+        return tag == UNIFORM;
+    }
+
+    bool isMixed() const
+    {
+        return tag < UNIFORM;
+    }
+
+    // Only valid for uniform and single-scenario weights
+    int32_t scalar() const
+    {
+        return val;
+    }
+
+    // Only valid for single-scenario weights
+    uint32_t lane() const
+    {
+        return (uint32_t)tag;
+    }
+
+    // Only valid for mixed weights
+    const int32_t* mixedLanes() const
+    {
+        return poolLanes(poolOffset(tag));
+    }
+
+    int32_t operator[](const uint32_t idx) const
+    {
+#ifdef CALIPERS_DEBUG
+        if (idx >= MAX_VECTOR_WIDTH)
+        {
+            CALIPERS_ERROR("Invalid index for edge weight element access");
+        }
+#endif
+        if (tag == UNIFORM)
+        {
+            return val;
+        }
+        else if (tag >= 0)
+        {
+            return ((uint32_t)tag == idx) ? val : ABSENT;
+        }
+        else
+        {
+            return mixedLanes()[idx];
+        }
+    }
+
+    template <uint32_t W>
+    WeightVector<W> toVector() const
+    {
+        if (tag == UNIFORM)
+        {
+            return WeightVector<W>(val);
+        }
+        else if (tag >= 0)
+        {
+            return WeightVector<W>(val, tag);
+        }
+        else
+        {
+            return WeightVector<W>((int32_t*)mixedLanes(), W);
+        }
+    }
+
+    template <uint32_t W>
+    LaneMask largerThan(int32_t threshold, LaneMask mask) const
+    {
+        if (isMixed())
+        {
+            return kernels::compareGreater<W>(mixedLanes(), threshold, mask);
+        }
+        return scalarCondition(val > threshold, mask);
+    }
+
+    template <uint32_t W>
+    LaneMask smallerThanOrEqual(int32_t threshold, LaneMask mask) const
+    {
+        if (isMixed())
+        {
+            return mask & ~kernels::compareGreater<W>(mixedLanes(), threshold, mask);
+        }
+        return scalarCondition(val <= threshold, mask);
+    }
+
+    template <uint32_t W>
+    LaneMask between(int32_t threshold1, int32_t threshold2, LaneMask mask) const
+    {
+        if (isMixed())
+        {
+            return kernels::compareGreater<W>(mixedLanes(), threshold1, mask) &
+                   ~kernels::compareGreater<W>(mixedLanes(), threshold2, mask);
+        }
+        return scalarCondition((val > threshold1) && (val <= threshold2), mask);
+    }
+
+    template <uint32_t W>
+    string toString() const
+    {
+        return toVector<W>().toString();
     }
 };
 
+typedef vector<pair<uint32_t, LaneMask>> LaneGroups;
+// The lanes grouped by the value of a per-scenario parameter
+// First: Parameter value, Second: The lanes with that value
+
+
+template <typename T, uint32_t W>
+inline LaneMask BasicVector<T, W>::update(const BasicVector& v_in, const EdgeWeight& weight)
+{
+    if (weight.isMixed())
+    {
+        return kernels::relaxMixed<W>(vec, v_in.vec, weight.mixedLanes(), EdgeWeight::ABSENT);
+    }
+
+    T w = weight.scalar();
+    if (w == EdgeWeight::ABSENT)
+    {
+        return 0;
+    }
+    if ((W == 1) || weight.isUniform())
+    {
+        // Fast path: no per-scenario weight lookup and no missing edges
+        // (a single-scenario weight is uniform if there is only one scenario)
+        return kernels::relaxUniform<W>(vec, v_in.vec, w);
+    }
+
+    uint32_t idx = weight.lane();
+    if (v_in.vec[idx] + w >= vec[idx])
+    {
+        vec[idx] = v_in.vec[idx] + w;
+        return (LaneMask)1 << idx;
+    }
+    return 0;
+}
+
+template <typename T, uint32_t W>
+inline void BasicVector<T, W>::maskedAdd(const EdgeWeight& weight, LaneMask mask)
+{
+    if (weight.isMixed())
+    {
+        kernels::addMasked<W>(vec, weight.mixedLanes(), mask);
+    }
+    else if ((W == 1) || weight.isUniform())
+    {
+        maskedAdd((T)weight.scalar(), mask);
+    }
+    else
+    {
+        maskedAdd((T)weight.scalar(), mask & ((LaneMask)1 << weight.lane()));
+    }
+}
+
 typedef struct VERTEX
 {
     int type; // From enum VertexType
@@ -257,7 +704,7 @@ typedef struct VERTEX
 } Vertex;
 
 /**
- * An INT64_MAX entry in the weight vector denotes the corresponding edge
+ * An ABSENT entry in the weight vector denotes the corresponding edge
  * does not exist in that specific scenraio. An edge migh exist in
  * one scenario and not exist in another scenraio. This may happen, e.g.,
  * for edges related to branch misprediction and structural hazards.
@@ -265,15 +712,17 @@ typedef struct VERTEX
 typedef struct OUTGOING_EDGE
 {
     Vertex child;
-    Vector weight;
+    EdgeWeight weight;
 
     OUTGOING_EDGE() : child(Vertex(0, 0)), weight(0)
     {}
 
-    OUTGOING_EDGE(Vertex child, Vector& v) : child(child)
-    {
-        weight = v;
-    }
+    template <uint32_t W>
+    OUTGOING_EDGE(Vertex child, const WeightVector<W>& v) : child(child), weight(v)
+    {}
+
+    OUTGOING_EDGE(Vertex child, const EdgeWeight& w) : child(child), weight(w)
+    {}
 
     OUTGOING_EDGE(Vertex child, int64_t val) : child(child), weight(val)
     {}
@@ -287,15 +736,17 @@ typedef struct OUTGOING_EDGE
 typedef struct INCOMING_EDGE
 {
     Vertex parent;
-    Vector weight;
+    EdgeWeight weight;
 
     INCOMING_EDGE() : parent(Vertex(0, 0)), weight(0)
     {}
 
-    INCOMING_EDGE(Vertex parent, Vector& v) : parent(parent)
-    {
-        weight = v;
-    }
+    template <uint32_t W>
+    INCOMING_EDGE(Vertex parent, const WeightVector<W>& v) : parent(parent), weight(v)
+    {}
+
+    INCOMING_EDGE(Vertex parent, const EdgeWeight& w) : parent(parent), weight(w)
+    {}
 
     INCOMING_EDGE(Vertex parent, int64_t val) : parent(parent), weight(val)
     {}
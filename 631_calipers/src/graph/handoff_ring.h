@@ -0,0 +1,100 @@
+/**
+ * Copyright (c) Microsoft Corporation.
+ * 
+ * MIT License
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef HANDOFF_RING_H
+#define HANDOFF_RING_H
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+
+/**
+ * A bounded lock-free queue between one producer thread and one consumer
+ * thread
+ * The items live in the ring and are filled in and read in place, so an
+ * item's buffers are reused and nothing is allocated once the ring is warm.
+ * A full ring makes the producer wait, which bounds how far it runs ahead.
+ */
+template <typename T>
+class HandoffRing
+{
+  private:
+    vector<T> items;
+    uint64_t capacity;
+
+    alignas(64) atomic<uint64_t> produced; // Written by the producer only
+    alignas(64) atomic<uint64_t> consumed; // Written by the consumer only
+
+  public:
+    HandoffRing() : capacity(0), produced(0), consumed(0) {}
+
+    void init(uint64_t size)
+    {
+        items.assign(size, T());
+        capacity = size;
+        produced.store(0, memory_order_relaxed);
+        consumed.store(0, memory_order_relaxed);
+    }
+
+    // Producer: the next item to fill in, once there is room for it
+    T& claim()
+    {
+        uint64_t n = produced.load(memory_order_relaxed);
+        while (n - consumed.load(memory_order_acquire) == capacity)
+        {
+            this_thread::yield();
+        }
+        return items[n % capacity];
+    }
+
+    // Producer: hands the claimed item over to the consumer
+    void publish()
+    {
+        produced.store(produced.load(memory_order_relaxed) + 1, memory_order_release);
+    }
+
+    // Consumer: the oldest published item, once there is one
+    T& front()
+    {
+        uint64_t n = consumed.load(memory_order_relaxed);
+        while (produced.load(memory_order_acquire) == n)
+        {
+            this_thread::yield();
+        }
+        return items[n % capacity];
+    }
+
+    // Consumer: returns the front item to the producer
+    void release()
+    {
+        consumed.store(consumed.load(memory_order_relaxed) + 1, memory_order_release);
+    }
+};
+
+
+#endif // HANDOFF_RING_H
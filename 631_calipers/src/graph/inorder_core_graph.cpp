@@ -25,18 +25,19 @@
 #include "graph_util.h"
 #include "inorder_core_graph.h"
 
-InorderCoreGraph::InorderCoreGraph(string trace_file_name,
+template <uint32_t W>
+InorderCoreGraph<W>::InorderCoreGraph(string trace_file_name,
                                    string result_file_name,
                                    InstructionStream* instr_stream,
-                                   uint32_t fetch_bandwidth,
-                                   uint32_t dispatch_bandwidth,
+                                   const vector<uint32_t>& fetch_bandwidth,
+                                   const vector<uint32_t>& dispatch_bandwidth,
                                    uint32_t issue_bandwidth,
-                                   uint32_t commit_bandwidth,
-                                   uint32_t decode_cycles,
-                                   uint32_t dispatch_cycles,
-                                   uint32_t execute_to_commit_cycles,
-                                   uint32_t prediction_cycles,
-                                   uint32_t misprediction_penalty,
+                                   const vector<uint32_t>& commit_bandwidth,
+                                   const vector<uint32_t>& decode_cycles,
+                                   const vector<uint32_t>& dispatch_cycles,
+                                   const vector<uint32_t>& execute_to_commit_cycles,
+                                   const vector<uint32_t>& prediction_cycles,
+                                   const vector<uint32_t>& misprediction_penalty,
                                    uint32_t mem_issue_bandwidth,
                                    uint32_t mem_commit_bandwidth,
                                    uint32_t max_mem_accesses,
@@ -47,22 +48,26 @@ InorderCoreGraph::InorderCoreGraph(string trace_file_name,
                                    uint32_t lsu_count,
                                    bool load_dependent_early_issue,
                                    bool load_early_issue) :
-                                   Graph(trace_file_name, result_file_name, instr_stream),
-                                   fetchBandwidth(fetch_bandwidth),
-                                   dispatchBandwidth(dispatch_bandwidth),
+                                   VectorGraph<W>(trace_file_name, result_file_name, instr_stream),
+                                   fetchBandwidth(groupLanes(fetch_bandwidth)),
+                                   dispatchBandwidth(groupLanes(dispatch_bandwidth)),
                                    issueBandwidth(issue_bandwidth),
-                                   commitBandwidth(commit_bandwidth),
-                                   decodeCycles(decode_cycles),
-                                   dispatchCycles(dispatch_cycles),
-                                   executeToCommitCycles(execute_to_commit_cycles),
-                                   predictionCycles(prediction_cycles),
-                                   mispredictionPenalty(misprediction_penalty),
+                                   commitBandwidth(groupLanes(commit_bandwidth)),
+                                   decodeCycles(EdgeWeight::fromLanes<W>(decode_cycles)),
+                                   dispatchCycles(EdgeWeight::fromLanes<W>(dispatch_cycles)),
+                                   executeToCommitCycles(
+                                       EdgeWeight::fromLanes<W>(execute_to_commit_cycles)),
+                                   predictionCycles(EdgeWeight::fromLanes<W>(prediction_cycles)),
+                                   mispredictionPenalty(EdgeWeight::fromLanes<W>(misprediction_penalty)),
                                    memIssueBandwidth(mem_issue_bandwidth),
                                    memCommitBandwidth(mem_commit_bandwidth),
                                    maxMemAccesses(max_mem_accesses),
                                    loadDependentEarlyIssue(load_dependent_early_issue),
                                    loadEarlyIssue(load_early_issue)
 {
+    inOrderDispatchLanes = lanesOtherThan(dispatchBandwidth, 1);
+    inOrderCommitLanes = lanesOtherThan(commitBandwidth, 1);
+
     // TODO: Parameterize the last three arguments of initResource
     // (i.e., total_cycles, source_independent_cycles, next_issue_cycles)
     scoreboard.initResource(Resource::RscIntAlu, int_alu_count, 3, 2, 1);
@@ -75,17 +80,18 @@ InorderCoreGraph::InorderCoreGraph(string trace_file_name,
 
     extraLoadLatency = 2; // TODO: Make this a parameter
     
-    ldStWindow = new pair<uint64_t, uint32_t>[maxMemAccesses];
+    bookkeeping.initLdStWindow(maxMemAccesses);
 
     initBookKeeping();
 }
 
-InorderCoreGraph::~InorderCoreGraph()
+template <uint32_t W>
+InorderCoreGraph<W>::~InorderCoreGraph()
 {
-    delete[] ldStWindow;
 }
 
-void InorderCoreGraph::run()
+template <uint32_t W>
+void InorderCoreGraph<W>::run()
 {
     CALIPERS_INFO("Running the graph-based modeler...");
 
@@ -112,6 +118,11 @@ void InorderCoreGraph::run()
     }
 
     my_time = chrono::system_clock::now();
+    Vertex last_vertex(VertexType::InstrCommit, instrCount - 1);
+    VertexState& last_state = vertexState[VertexHash()(last_vertex)];
+    length[last_vertex] = last_state.length;
+    criticalPathCycles[last_vertex] = last_state.cycles;
+    criticalPathInstructions[last_vertex] = last_state.instructions;
     recordStats(true, false);
     graphAnalysisTime += (chrono::system_clock::now() - my_time).count();
 
@@ -123,18 +134,13 @@ void InorderCoreGraph::run()
                   << (graphAnalysisTime / 1000000) << " ms" << endl);
 }
 
-void InorderCoreGraph::initBookKeeping()
+template <uint32_t W>
+void InorderCoreGraph<W>::initBookKeeping()
 {
-    lastMisprediction = UINT64_MAX;
-    previousInstrMispredicted = false;
-    ldStWindowPointer = 0;
-    lastMemLdSt = UINT64_MAX;
+    bookkeeping.reset();
     lastLdStCriticalNum = UINT64_MAX;
     lastLdStCriticalCycles = UINT32_MAX;
 
-    regLastWrittenBy.clear();
-    regLastWrittenByLoad.clear();
-
     scoreboard.initRecords();
 
     for (uint32_t i = 0; i < AnalysisWindow; ++i)
@@ -142,35 +148,9 @@ void InorderCoreGraph::initBookKeeping()
         neededRsc[i].first = -1;
     }
 
-    Vertex first_vertex(0, 0);
-    Vector zero_vector(0);
-    length[first_vertex] = zero_vector;
-    criticalPathCycles[first_vertex].goodFetchHitCycles = zero_vector;
-    criticalPathCycles[first_vertex].goodFetchMissCycles = zero_vector;
-    criticalPathCycles[first_vertex].badFetchHitCycles = zero_vector;
-    criticalPathCycles[first_vertex].badFetchMissCycles = zero_vector;
-    criticalPathCycles[first_vertex].decodeCycles = zero_vector;
-    criticalPathCycles[first_vertex].dispatchCycles = zero_vector;
-    criticalPathCycles[first_vertex].intCycles = zero_vector;
-    criticalPathCycles[first_vertex].fpCycles = zero_vector;
-    criticalPathCycles[first_vertex].lsCycles = zero_vector;
-    criticalPathCycles[first_vertex].loadL1HitCycles = zero_vector;
-    criticalPathCycles[first_vertex].loadL2HitCycles = zero_vector;
-    criticalPathCycles[first_vertex].loadMissCycles = zero_vector;
-    criticalPathCycles[first_vertex].storeL1HitCycles = zero_vector;
-    criticalPathCycles[first_vertex].storeL2HitCycles = zero_vector;
-    criticalPathCycles[first_vertex].storeMissCycles = zero_vector;
-    criticalPathCycles[first_vertex].branchCycles = zero_vector;
-    criticalPathCycles[first_vertex].syscallCycles = zero_vector;
-    criticalPathCycles[first_vertex].atomicCycles = zero_vector;
-    criticalPathCycles[first_vertex].otherCycles = zero_vector;
-    criticalPathCycles[first_vertex].commitCycles = zero_vector;
-    criticalPathInstructions[first_vertex].intInstructions = zero_vector;
-    criticalPathInstructions[first_vertex].fpInstructions = zero_vector;
-    criticalPathInstructions[first_vertex].loadInstructions = zero_vector;
-    criticalPathInstructions[first_vertex].storeInstructions = zero_vector;
-    criticalPathInstructions[first_vertex].branchInstructions = zero_vector;
-    criticalPathInstructions[first_vertex].otherInstructions = zero_vector;
+    // All lengths and breakdowns (including those of the first vertex) start at zero
+    vertexState.assign((uint64_t)AnalysisWindow * (VertexType::Last + 1), VertexState());
+    lengthBase = Vector<W>(0);
 
     for (int i = 0; i <= VertexType::Last; ++i)
     {
@@ -179,16 +159,12 @@ void InorderCoreGraph::initBookKeeping()
 
     for (uint32_t i = 0; i < AnalysisWindow; ++i)
     {
-        executionType[i] = -1;
-    }
-
-    for (uint32_t i = 0; i < maxMemAccesses; ++i)
-    {
-        ldStWindow[i].second = UINT32_MAX;
+        instrExecutionType[i] = -1;
     }
 }
 
-void InorderCoreGraph::model(Instruction* instr)
+template <uint32_t W>
+void InorderCoreGraph<W>::model(Instruction* instr)
 {
     sys_nanoseconds my_time = chrono::system_clock::now();
 
@@ -216,7 +192,7 @@ void InorderCoreGraph::model(Instruction* instr)
     // Keeping track of current execute_vertex's dependence to previous execute_vertex'es
     unordered_map<uint64_t, uint32_t> execute_parent; // Key: Instruction num, Value: Weight
 
-    executionType[instrCount % AnalysisWindow] = instr->executionType;
+    instrExecutionType[instrCount % AnalysisWindow] = instr->executionType;
 
     // 0: int, 1: fp, 2: load, 3: store, 4: branch, 5: other
     if (is_branch)
@@ -329,10 +305,9 @@ void InorderCoreGraph::model(Instruction* instr)
 
     if (is_load_store)
     {
-        lastMemLdSt = instrCount;
-        ldStWindow[ldStWindowPointer].first = instrCount;
-        ldStWindow[ldStWindowPointer].second = instr->lsCycles;
-        ldStWindowPointer = (ldStWindowPointer + 1) % maxMemAccesses;
+        bookkeeping.pushLdSt(instrCount, is_load ? instr->memLoadBase : instr->memStoreBase,
+                             is_load ? instr->memLoadLength : instr->memStoreLength,
+                             instr->lsCycles, is_load);
     }
 
     if (!loadEarlyIssue && (is_int || is_int_mul || is_int_div || is_fp))
@@ -344,29 +319,21 @@ void InorderCoreGraph::model(Instruction* instr)
             //lastLdStCriticalCycles += predictionCycles / 2;
     }
 
-    previousWasBranch = is_branch;
-    linearPC = instr->pc + instr->bytes;
+    bookkeeping.previousWasBranch = is_branch;
+    bookkeeping.linearPC = instr->pc + instr->bytes;
 
     for (uint32_t i = 0; i < instr->regWriteCount; ++i)
     {
         int reg_write = instr->regWrite[i];
-        regLastWrittenBy[reg_write].first = instrCount;
         if (is_load)
         {
-            if (loadDependentEarlyIssue)
-            {
-                regLastWrittenBy[reg_write].second = extraLoadLatency;
-            }
-            else
-            {
-                regLastWrittenBy[reg_write].second = instr->lsCycles;
-            }
-            regLastWrittenByLoad[reg_write] = true;
+            bookkeeping.setProducer(reg_write, instrCount,
+                                    loadDependentEarlyIssue ? extraLoadLatency : instr->lsCycles,
+                                    true);
         }
         else
         {
-            regLastWrittenBy[reg_write].second = execution_cycles;
-            regLastWrittenByLoad[reg_write] = false;
+            bookkeeping.setProducer(reg_write, instrCount, execution_cycles, false);
         }
     }
 
@@ -406,7 +373,8 @@ void InorderCoreGraph::model(Instruction* instr)
     graphAnalysisTime += (chrono::system_clock::now() - my_time).count();
 }
 
-void InorderCoreGraph::modelPipeline(Vertex& fetch_vertex, Vertex& dispatch_vertex,
+template <uint32_t W>
+void InorderCoreGraph<W>::modelPipeline(Vertex& fetch_vertex, Vertex& dispatch_vertex,
                                      Vertex& execute_vertex, Vertex& mem_vertex,
                                      Vertex& commit_vertex, Instruction* instr,
                                      uint32_t execution_cycles,
@@ -416,20 +384,20 @@ void InorderCoreGraph::modelPipeline(Vertex& fetch_vertex, Vertex& dispatch_vert
     uint32_t fetch_cycles = instr->fetchCycles;
     bool is_load_store = (instr->memLoadCount == 1) || (instr->memStoreCount == 1);
 
-    bool no_need_for_ino_dispatch = (instrCount == 0) || (dispatchBandwidth == 1);
+    LaneMask ino_dispatch_lanes = (instrCount == 0) ? 0 : inOrderDispatchLanes;
     bool no_need_for_ino_issue = (instrCount == 0) || (issueBandwidth == 1);
-    bool no_need_for_ino_commit = (instrCount == 0) || (commitBandwidth == 1);
+    LaneMask ino_commit_lanes = (instrCount == 0) ? 0 : inOrderCommitLanes;
 
-    mispredicted = previousInstrMispredicted;
-    previousInstrMispredicted = instr->mispredicted;
+    mispredicted = bookkeeping.previousInstrMispredicted;
+    bookkeeping.previousInstrMispredicted = instr->mispredicted;
 
     // Dispatch after fetch
-    OutgoingEdge fetch_after_dispatch(dispatch_vertex, (int64_t)decodeCycles);
+    OutgoingEdge fetch_after_dispatch(dispatch_vertex, decodeCycles);
     //cout << "Dispatch after fetch" << endl;
     addEdge(fetch_vertex, fetch_after_dispatch);
 
     // Execute after dispatch
-    OutgoingEdge execute_after_dispatch(execute_vertex, (int64_t)dispatchCycles);
+    OutgoingEdge execute_after_dispatch(execute_vertex, dispatchCycles);
     //cout << "Execute after dispatch" << endl;
     addEdge(dispatch_vertex, execute_after_dispatch);
 
@@ -443,7 +411,7 @@ void InorderCoreGraph::modelPipeline(Vertex& fetch_vertex, Vertex& dispatch_vert
 
         // Commit after execute
         OutgoingEdge commit_after_execute(commit_vertex,
-                                          (int64_t)(instr->lsCycles + executeToCommitCycles));
+                                          executeToCommitCycles.shifted<W>(instr->lsCycles));
         //cout << "Commit after memory execute" << endl;
         addEdge(mem_vertex, commit_after_execute);
     }
@@ -451,37 +419,46 @@ void InorderCoreGraph::modelPipeline(Vertex& fetch_vertex, Vertex& dispatch_vert
     {
         // Commit after execute
         OutgoingEdge commit_after_execute(commit_vertex,
-                                          (int64_t)(execution_cycles + executeToCommitCycles));
+                                          executeToCommitCycles.shifted<W>(execution_cycles));
         //cout << "Commit after execute" << endl;
         addEdge(execute_vertex, commit_after_execute);
     }
 
-    // Limited fetch bandwidth
-    if ((instrCount >= fetchBandwidth) &&
-        ((lastMisprediction == UINT64_MAX) || 
-         (instrCount - lastMisprediction > fetchBandwidth)))
+    // Limited fetch bandwidth (one edge per distinct bandwidth across the scenarios)
+    for (auto& group : fetchBandwidth)
     {
-        Vertex prev_fetch_vertex(VertexType::InstrFetch, instrCount - fetchBandwidth);
-        OutgoingEdge limited_fetch_bw(fetch_vertex, 1);
-        //cout << "Limited fetch bandwidth" << endl;
-        addEdge(prev_fetch_vertex, limited_fetch_bw);
+        uint32_t fetch_bandwidth = group.first;
+        if ((instrCount >= fetch_bandwidth) &&
+            ((bookkeeping.lastMisprediction == UINT64_MAX) || 
+             (instrCount - bookkeeping.lastMisprediction > fetch_bandwidth)))
+        {
+            Vertex prev_fetch_vertex(VertexType::InstrFetch, instrCount - fetch_bandwidth);
+            OutgoingEdge limited_fetch_bw(fetch_vertex, EdgeWeight::inLanes<W>(1, group.second));
+            //cout << "Limited fetch bandwidth" << endl;
+            addEdge(prev_fetch_vertex, limited_fetch_bw);
+        }
     }
 
     // Limited dispatch bandwidth
-    if ((instrCount >= dispatchBandwidth) &&
-        ((lastMisprediction == UINT64_MAX) ||
-        (instrCount - lastMisprediction > dispatchBandwidth)))
+    for (auto& group : dispatchBandwidth)
     {
-        Vertex prev_dispatch_vertex(VertexType::InstrDispatch, instrCount - dispatchBandwidth);
-        OutgoingEdge limited_dispatch_bw(dispatch_vertex, 1);
-        //cout << "Limited dispatch bandwidth" << endl;
-        addEdge(prev_dispatch_vertex, limited_dispatch_bw);
+        uint32_t dispatch_bandwidth = group.first;
+        if ((instrCount >= dispatch_bandwidth) &&
+            ((bookkeeping.lastMisprediction == UINT64_MAX) ||
+            (instrCount - bookkeeping.lastMisprediction > dispatch_bandwidth)))
+        {
+            Vertex prev_dispatch_vertex(VertexType::InstrDispatch, instrCount - dispatch_bandwidth);
+            OutgoingEdge limited_dispatch_bw(dispatch_vertex,
+                                             EdgeWeight::inLanes<W>(1, group.second));
+            //cout << "Limited dispatch bandwidth" << endl;
+            addEdge(prev_dispatch_vertex, limited_dispatch_bw);
+        }
     }
 
     // Limited issue bandwidth
     if ((instrCount >= issueBandwidth) &&
-        ((lastMisprediction == UINT64_MAX) ||
-         (instrCount - lastMisprediction > issueBandwidth)))
+        ((bookkeeping.lastMisprediction == UINT64_MAX) ||
+         (instrCount - bookkeeping.lastMisprediction > issueBandwidth)))
     {
         Vertex prev_execute_vertex(VertexType::InstrExecute, instrCount - issueBandwidth);
         OutgoingEdge limited_issue_bw(execute_vertex, 1);
@@ -492,46 +469,53 @@ void InorderCoreGraph::modelPipeline(Vertex& fetch_vertex, Vertex& dispatch_vert
     }
 
     // Limited memory issue bandwidth
-    if ((lastMemLdSt != UINT64_MAX) &&
-        (instrCount - lastMemLdSt <= memIssueBandwidth) &&
-        ((lastMisprediction == UINT64_MAX) ||
-         (instrCount - lastMisprediction > memIssueBandwidth)))
+    if ((bookkeeping.lastMemLdSt != UINT64_MAX) &&
+        (instrCount - bookkeeping.lastMemLdSt <= memIssueBandwidth) &&
+        ((bookkeeping.lastMisprediction == UINT64_MAX) ||
+         (instrCount - bookkeeping.lastMisprediction > memIssueBandwidth)))
     {
-        if (execute_parent[lastMemLdSt] < 1)
+        if (execute_parent[bookkeeping.lastMemLdSt] < 1)
         {
-            Vertex prev_execute_vertex(VertexType::InstrExecute, lastMemLdSt);
+            Vertex prev_execute_vertex(VertexType::InstrExecute, bookkeeping.lastMemLdSt);
             OutgoingEdge limited_mem_issue_bw(execute_vertex, 1);
             //cout << "Limited memory issue bandwidth" << endl;
             addEdge(prev_execute_vertex, limited_mem_issue_bw);
 
-            execute_parent[lastMemLdSt] = 1;
-            no_need_for_ino_issue = no_need_for_ino_issue || ((instrCount - lastMemLdSt) == 1);
+            execute_parent[bookkeeping.lastMemLdSt] = 1;
+            no_need_for_ino_issue = no_need_for_ino_issue || ((instrCount - bookkeeping.lastMemLdSt) == 1);
         }
     }
 
     // Limited commit bandwidth
-    if ((instrCount >= commitBandwidth) &&
-        ((lastMisprediction == UINT64_MAX) ||
-         (instrCount - lastMisprediction > commitBandwidth)))
+    for (auto& group : commitBandwidth)
     {
-        Vertex prev_commit_vertex(VertexType::InstrCommit, instrCount - commitBandwidth);
-        OutgoingEdge limited_commit_bw(commit_vertex, 1);
-        //cout << "Limited commit bandwidth" << endl;
-        addEdge(prev_commit_vertex, limited_commit_bw);
+        uint32_t commit_bandwidth = group.first;
+        if ((instrCount >= commit_bandwidth) &&
+            ((bookkeeping.lastMisprediction == UINT64_MAX) ||
+             (instrCount - bookkeeping.lastMisprediction > commit_bandwidth)))
+        {
+            Vertex prev_commit_vertex(VertexType::InstrCommit, instrCount - commit_bandwidth);
+            OutgoingEdge limited_commit_bw(commit_vertex, EdgeWeight::inLanes<W>(1, group.second));
+            //cout << "Limited commit bandwidth" << endl;
+            addEdge(prev_commit_vertex, limited_commit_bw);
+        }
     }
 
     // Limited memory commit bandwidth
-    if ((lastMemLdSt != UINT64_MAX) &&
-        (instrCount - lastMemLdSt <= memCommitBandwidth) &&
-        ((lastMisprediction == UINT64_MAX) ||
-         (instrCount - lastMisprediction > memCommitBandwidth)))
+    if ((bookkeeping.lastMemLdSt != UINT64_MAX) &&
+        (instrCount - bookkeeping.lastMemLdSt <= memCommitBandwidth) &&
+        ((bookkeeping.lastMisprediction == UINT64_MAX) ||
+         (instrCount - bookkeeping.lastMisprediction > memCommitBandwidth)))
     {
-        Vertex prev_commit_vertex(VertexType::InstrCommit, lastMemLdSt);
+        Vertex prev_commit_vertex(VertexType::InstrCommit, bookkeeping.lastMemLdSt);
         OutgoingEdge limited_mem_commit_bw(commit_vertex, 1);
         //cout << "Limited memory commit bandwidth" << endl;
         addEdge(prev_commit_vertex, limited_mem_commit_bw);
 
-        no_need_for_ino_commit = no_need_for_ino_commit || ((instrCount - lastMemLdSt) == 1);
+        if ((instrCount - bookkeeping.lastMemLdSt) == 1)
+        {
+            ino_commit_lanes = 0;
+        }
     }
 
     if (mispredicted)
@@ -541,38 +525,39 @@ void InorderCoreGraph::modelPipeline(Vertex& fetch_vertex, Vertex& dispatch_vert
         //                                (int64_t)(mispredictionPenalty + fetch_cycles));
         Vertex prev_branch_vertex(VertexType::InstrExecute, instrCount - 1);
         OutgoingEdge mispredicted_fetch(fetch_vertex,
-            (int64_t)(scoreboard.resourceTotalCycles(Resource::RscIntAlu) +
-                      mispredictionPenalty + fetch_cycles));
+            mispredictionPenalty.shifted<W>(
+                (int64_t)scoreboard.resourceTotalCycles(Resource::RscIntAlu) + fetch_cycles));
         //cout << "Bad fetch" << endl;
         addEdge(prev_branch_vertex, mispredicted_fetch);
-        lastMisprediction = instrCount - 1;
+        bookkeeping.lastMisprediction = instrCount - 1;
     }
     else
     {
         if (instrCount != 0)
         {
             // In-order fetch
-            uint32_t fetch_weight;
-            if (previousWasBranch && (instr->pc != linearPC)) // Correctly taken branch
+            EdgeWeight fetch_weight;
+            if (bookkeeping.previousWasBranch && (instr->pc != bookkeeping.linearPC)) // Correctly taken branch
             {
-                fetch_weight = predictionCycles + fetch_cycles;
+                fetch_weight = predictionCycles.shifted<W>(fetch_cycles);
             }
             else // No branch or correctly not taken branch
             {
-                fetch_weight = fetch_cycles;
+                fetch_weight = EdgeWeight(fetch_cycles);
             }
 
             Vertex prev_fetch_vertex(VertexType::InstrFetch, instrCount - 1);
-            OutgoingEdge in_order_fetch(fetch_vertex, (int64_t)fetch_weight);
+            OutgoingEdge in_order_fetch(fetch_vertex, fetch_weight);
             //cout << "Good fetch" << endl;
             addEdge(prev_fetch_vertex, in_order_fetch);
         }
 
         // In-order dispatch
-        if (!no_need_for_ino_dispatch)
+        if (ino_dispatch_lanes != 0)
         {
             Vertex prev_dispatch_vertex(VertexType::InstrDispatch, instrCount - 1);
-            OutgoingEdge in_order_dispatch(dispatch_vertex, 0);
+            OutgoingEdge in_order_dispatch(dispatch_vertex,
+                                           EdgeWeight::inLanes<W>(0, ino_dispatch_lanes));
             //cout << "In-order dispatch" << endl;
             addEdge(prev_dispatch_vertex, in_order_dispatch);
         }
@@ -587,25 +572,26 @@ void InorderCoreGraph::modelPipeline(Vertex& fetch_vertex, Vertex& dispatch_vert
         }
 
         // In-order commit
-        if (!no_need_for_ino_commit)
+        if (ino_commit_lanes != 0)
         {
             Vertex prev_commit_vertex(VertexType::InstrCommit, instrCount - 1);
-            OutgoingEdge in_order_commit(commit_vertex, 0);
+            OutgoingEdge in_order_commit(commit_vertex, EdgeWeight::inLanes<W>(0, ino_commit_lanes));
             //cout << "In-order commit" << endl;
             addEdge(prev_commit_vertex, in_order_commit);
         }
     }
 }
 
-void InorderCoreGraph::modelMemoryOrderConstraint(Vertex& mem_vertex, bool is_load, bool is_store)
+template <uint32_t W>
+void InorderCoreGraph<W>::modelMemoryOrderConstraint(Vertex& mem_vertex, bool is_load, bool is_store)
 {
     // For loads, add an edge from the earliest load/store in the load/store window
     if (is_load)
     {
-        pair<uint64_t, uint32_t> earliest_ld_st = ldStWindow[ldStWindowPointer % maxMemAccesses];
-        uint64_t earliest_ld_st_num = earliest_ld_st.first;
-        uint32_t earliest_ld_st_cycles = earliest_ld_st.second;
-        if (earliest_ld_st_cycles != UINT32_MAX)
+        const LdStEntry& earliest_ld_st = bookkeeping.ldStByAge(bookkeeping.ldStWindowSize() - 1);
+        uint64_t earliest_ld_st_num = earliest_ld_st.instrNum;
+        uint32_t earliest_ld_st_cycles = earliest_ld_st.cycles;
+        if (earliest_ld_st_num != UINT64_MAX)
         {
             Vertex prev_mem_vertex(VertexType::MemExecute, earliest_ld_st_num);
             OutgoingEdge limited_mem(mem_vertex, (int64_t)earliest_ld_st_cycles);
@@ -620,10 +606,10 @@ void InorderCoreGraph::modelMemoryOrderConstraint(Vertex& mem_vertex, bool is_lo
     {
         for (uint32_t i = 0; i < maxMemAccesses; ++i)
         {
-            pair<uint64_t, uint32_t> previous_ld_st = ldStWindow[i];
-            uint64_t previous_ld_st_num = previous_ld_st.first;
-            uint32_t previous_ld_st_cycles = previous_ld_st.second;
-            if (previous_ld_st_cycles != UINT32_MAX)
+            const LdStEntry& previous_ld_st = bookkeeping.ldStSlot(i);
+            uint64_t previous_ld_st_num = previous_ld_st.instrNum;
+            uint32_t previous_ld_st_cycles = previous_ld_st.cycles;
+            if (previous_ld_st_num != UINT64_MAX)
             {
                 Vertex prev_mem_vertex(VertexType::MemExecute, previous_ld_st_num);
                 OutgoingEdge limited_store(mem_vertex, (int64_t)previous_ld_st_cycles);
@@ -649,7 +635,8 @@ void InorderCoreGraph::modelMemoryOrderConstraint(Vertex& mem_vertex, bool is_lo
     }
 }
 
-void InorderCoreGraph::trackDataDependencies(Instruction* instr,
+template <uint32_t W>
+void InorderCoreGraph<W>::trackDataDependencies(Instruction* instr,
                                              uint32_t source_independent_cycles,
                                              Vertex& execute_vertex,
                                              unordered_map<uint64_t, uint32_t>& execute_parent)
@@ -657,15 +644,15 @@ void InorderCoreGraph::trackDataDependencies(Instruction* instr,
     // Check for data dependence through registers
     for (uint32_t i = 0; i < instr->regReadCount; ++i)
     {
-        int reg_read = instr->regRead[i];
-        if (regLastWrittenBy.count(reg_read) != 0)
+        const RegisterProducer& producer = bookkeeping.producer(instr->regRead[i]);
+        if (producer.instrNum != UINT64_MAX)
         {
             //cout << "Register data dependence: " << instrCount << " to "
-            //     << regLastWrittenBy[reg_read].first << endl;
+            //     << producer.instrNum << endl;
             uint32_t weight; // Not differentiating between address and value registers for stores
-            if (regLastWrittenByLoad[reg_read])
+            if (producer.isLoad)
             {
-                weight = regLastWrittenBy[reg_read].second;
+                weight = producer.cycles;
                 if (loadDependentEarlyIssue)
                 {
                     if (weight > source_independent_cycles)
@@ -677,20 +664,20 @@ void InorderCoreGraph::trackDataDependencies(Instruction* instr,
                         weight = 0;
                     }
 
-                    if ((instrCount - regLastWrittenBy[reg_read].first) / issueBandwidth < weight)
+                    if ((instrCount - producer.instrNum) / issueBandwidth < weight)
                     {
                         Vertex prev_mem_vertex(VertexType::MemExecute,
-                                               regLastWrittenBy[reg_read].first);
+                                               producer.instrNum);
                         OutgoingEdge dependence_edge(execute_vertex, (int64_t)weight);
                         addEdge(prev_mem_vertex, dependence_edge);
                     }
                 }
                 else
                 {
-                    if ((instrCount - regLastWrittenBy[reg_read].first) / issueBandwidth < weight)
+                    if ((instrCount - producer.instrNum) / issueBandwidth < weight)
                     {
                         Vertex prev_commit_vertex(VertexType::InstrCommit,
-                                                  regLastWrittenBy[reg_read].first);
+                                                  producer.instrNum);
                         OutgoingEdge dependence_edge(execute_vertex, 0);
                         addEdge(prev_commit_vertex, dependence_edge);
                     }
@@ -698,17 +685,17 @@ void InorderCoreGraph::trackDataDependencies(Instruction* instr,
             }
             else
             {
-                if (regLastWrittenBy[reg_read].second > source_independent_cycles)
+                if (producer.cycles > source_independent_cycles)
                 {
-                    weight = regLastWrittenBy[reg_read].second - source_independent_cycles;
+                    weight = producer.cycles - source_independent_cycles;
                 }
                 else
                 {
                     weight = 0;
                 }
-                if (execute_parent[regLastWrittenBy[reg_read].first] < weight)
+                if (execute_parent[producer.instrNum] < weight)
                 {
-                    execute_parent[regLastWrittenBy[reg_read].first] = weight;
+                    execute_parent[producer.instrNum] = weight;
                 }
             }
         }
@@ -724,7 +711,8 @@ void InorderCoreGraph::trackDataDependencies(Instruction* instr,
 // model the structural hazard related to the limited pipeline length of a resource.
 // However, in our experiments, we found that this more complex model just slightly
 // improves the accuracy (with gem5 as the baseline).
-void InorderCoreGraph::modelResourceDependenciesSimple(
+template <uint32_t W>
+void InorderCoreGraph<W>::modelResourceDependenciesSimple(
                           bool is_int, bool is_int_mul,
                           bool is_int_div, bool is_fp,
                           bool is_load_store, Vertex& execute_vertex,
@@ -800,7 +788,8 @@ void InorderCoreGraph::modelResourceDependenciesSimple(
     }
 }
 
-void InorderCoreGraph::addEdge(Vertex& parent, OutgoingEdge& e)
+template <uint32_t W>
+void InorderCoreGraph<W>::addEdge(Vertex& parent, OutgoingEdge& e)
 {
     // It may have been better to define this function with a
     // child vertex and an incoming edge. But in an earlier version
@@ -829,17 +818,45 @@ void InorderCoreGraph::addEdge(Vertex& parent, OutgoingEdge& e)
     parents[child_type] = parents_count;
 }
 
-void InorderCoreGraph::calculateInstructionCriticalPath()
+template <uint32_t W>
+void InorderCoreGraph<W>::calculateInstructionCriticalPath()
 {
+    // The parents of the current instruction's vertices are all in the window,
+    // so their states are found by direct indexing rather than in the maps
     for (int i = 0; i <= VertexType::Last; ++i)
     {
         Vertex child(i, instrCount);
+        VertexState& child_state = vertexState[VertexHash()(child)];
         for (uint32_t j = 0; j < parents[i]; ++j)
         {
-            Vertex& parent = miniGraph[i][j].parent;
-            OutgoingEdge e(child, miniGraph[i][j].weight);
-            updateCriticalPathCycles(parent, e);
+            IncomingEdge& e = miniGraph[i][j];
+            Vertex& parent = e.parent;
+            VertexState& parent_state = vertexState[VertexHash()(parent)];
+            LaneMask mask = child_state.length.update(parent_state.length, e.weight);
+            if (mask == 0)
+            {
+                continue;
+            }
+            copyBreakdown(child_state.cycles, parent_state.cycles,
+                          child_state.instructions, parent_state.instructions, mask);
+            classifyEdge(parent.type, i, instrExecutionType[parent.instrNum % AnalysisWindow],
+                         e.weight, mask, child_state.cycles, child_state.instructions);
         }
         parents[i] = 0;
     }
+
+    Vertex commit_vertex(VertexType::InstrCommit, instrCount);
+    LengthVector<W>& commit_length = vertexState[VertexHash()(commit_vertex)].length;
+    if (needsRebase(commit_length))
+    {
+        LengthVector<W> shift = commit_length;
+        for (auto& state : vertexState)
+        {
+            state.length.rebase(shift, -LENGTH_REBASE_THRESHOLD);
+        }
+        shiftLengthBase(shift);
+    }
 }
+
+#define INSTANTIATE_INORDER_CORE_GRAPH(w) template class InorderCoreGraph<w>;
+FOR_EACH_VECTOR_WIDTH(INSTANTIATE_INORDER_CORE_GRAPH)
@@ -27,26 +27,74 @@
 
 #include "graph.h"
 #include "scoreboard_simple.h"
+#include "pipeline_bookkeeping.h"
 
 /**
  * An in-order processor model based on gem5's MinorCPU
  * The current implementation requires that branch prediction
  * result and load/store cycles are provided in the trace.
  */
-class InorderCoreGraph : public Graph
+template <uint32_t W>
+class InorderCoreGraph : public VectorGraph<W>
 {
   private:
+    using Graph::AnalysisWindow;
+    using typename Graph::VertexHash;
+    using typename Graph::VertexEqual;
+    using typename Graph::ScheduleSet;
+    using Graph::instrStream;
+    using Graph::icache;
+    using Graph::dcache;
+    using Graph::bp;
+    using Graph::l1iThreshold;
+    using Graph::l2iThreshold;
+    using Graph::l1dThreshold;
+    using Graph::l2dThreshold;
+    using Graph::intAluTotalCycles;
+    using Graph::executionType;
+    using Graph::instructionMix;
+    using Graph::streamTime;
+    using Graph::graphConstructionTime;
+    using Graph::graphAnalysisTime;
+    using Graph::instrCount;
+    using Graph::analyzedWindows;
+    using Graph::l1iMisses;
+    using Graph::l2iMisses;
+    using Graph::l1dMisses;
+    using Graph::l2dMisses;
+    using Graph::bpMisses;
+    using Graph::branchCount;
+    using VectorGraph<W>::length;
+    using VectorGraph<W>::lengthBase;
+    using VectorGraph<W>::criticalPathCycles;
+    using VectorGraph<W>::criticalPathInstructions;
+    using VectorGraph<W>::lazyBreakdown;
+    using VectorGraph<W>::updateCriticalPathCycles;
+    using VectorGraph<W>::copyBreakdown;
+    using VectorGraph<W>::classifyEdge;
+    using VectorGraph<W>::resetPredecessorLog;
+    using VectorGraph<W>::rebaseLengths;
+    using VectorGraph<W>::needsRebase;
+    using VectorGraph<W>::shiftLengthBase;
+    using VectorGraph<W>::absoluteLength;
+    using VectorGraph<W>::recordStats;
+    using VectorGraph<W>::printEdge;
+    using VectorGraph<W>::groupLanes;
+    using VectorGraph<W>::lanesOtherThan;
+
     /*** Microarchitectural parameters ***/
 
-    uint32_t fetchBandwidth; // Bandwidth is in instructions per cycle
-    uint32_t dispatchBandwidth; // MinorCPU: decodeInputWidth
+    // Swept parameters are per-scenario (see O3CoreGraph)
+
+    LaneGroups fetchBandwidth; // Bandwidth is in instructions per cycle
+    LaneGroups dispatchBandwidth; // MinorCPU: decodeInputWidth
     uint32_t issueBandwidth; // MinorCPU: executeIssueLimit
-    uint32_t commitBandwidth; // MinorCPU: executeCommitLimit
-    uint32_t decodeCycles; // MinorCPU: fetch1ToFetch2ForwardDelay + fetch2ToDecodeForwardDelay
-    uint32_t dispatchCycles; // MinorCPU: decodeToExecuteForwardDelay
-    uint32_t executeToCommitCycles;
-    uint32_t predictionCycles;
-    uint32_t mispredictionPenalty;
+    LaneGroups commitBandwidth; // MinorCPU: executeCommitLimit
+    EdgeWeight decodeCycles; // MinorCPU: fetch1ToFetch2ForwardDelay + fetch2ToDecodeForwardDelay
+    EdgeWeight dispatchCycles; // MinorCPU: decodeToExecuteForwardDelay
+    EdgeWeight executeToCommitCycles;
+    EdgeWeight predictionCycles;
+    EdgeWeight mispredictionPenalty;
     uint32_t memIssueBandwidth;
     uint32_t memCommitBandwidth;
     uint32_t maxMemAccesses;
@@ -55,26 +103,19 @@ class InorderCoreGraph : public Graph
     uint32_t extraLoadLatency;
     ScoreboardSimple scoreboard;  // Also performs bookkeeping
 
+    LaneMask inOrderDispatchLanes; // The scenarios with a dispatch bandwidth of more than one
+    LaneMask inOrderCommitLanes; // The scenarios with a commit bandwidth of more than one
 
-    /*** Bookkeeping ***/
-
-    uint64_t lastMisprediction;
-    bool previousInstrMispredicted;
-    bool previousWasBranch;
-    uint64_t linearPC;
-
-    unordered_map<int, pair<uint64_t, uint32_t>> regLastWrittenBy;
-    // Key: Register, Value: <Instruction number, Execution cycles>
 
-    unordered_map<int, bool> regLastWrittenByLoad;
-    // Key: Register, Value: Whether it was written by a load
+    /*** Bookkeeping ***/
 
-    pair<uint64_t, uint32_t>* ldStWindow; // First: Load/store number, Second: Access cycles
-    uint32_t ldStWindowPointer;
-    uint64_t lastMemLdSt;
+    PipelineBookkeeping bookkeeping; // Register producers, the last maxMemAccesses loads/stores
     uint64_t lastLdStCriticalNum;
     uint32_t lastLdStCriticalCycles;
 
+    int instrExecutionType[INO_WINDOW];
+    // Key: Instruction number % INO_WINDOW, Value: ExecutionType (-1 for invalid)
+
     pair<int, uint32_t> neededRsc[INO_WINDOW];
     // Key: Instruction number % INO_WINDOW
     // Value.first: Type from enum Resource (-1 means don't care)
@@ -83,6 +124,18 @@ class InorderCoreGraph : public Graph
 
     /*** Graph-related data structures ***/
 
+    typedef struct VERTEX_STATE
+    {
+        LengthVector<W> length;
+        CycleTypes<W> cycles;
+        InstructionTypes<W> instructions;
+    } VertexState;
+
+    vector<VertexState> vertexState;
+    // Index: Window position of a vertex (see VertexHash), Value: Its length (relative
+    // to lengthBase) and breakdowns. The maps of VectorGraph are only filled in for
+    // the last vertex, when the stats are recorded.
+
     IncomingEdge miniGraph[VertexType::Last + 1][MAX_PARENTS];
     // miniGraph[i] = Incoming edges to current instruction's i'th vertex
 
@@ -113,15 +166,15 @@ class InorderCoreGraph : public Graph
     InorderCoreGraph(string trace_file_name,
                      string result_file_name,
                      InstructionStream* instr_stream,
-                     uint32_t fetch_bandwidth,
-                     uint32_t dispatch_bandwidth,
+                     const vector<uint32_t>& fetch_bandwidth,
+                     const vector<uint32_t>& dispatch_bandwidth,
                      uint32_t issue_bandwidth,
-                     uint32_t commit_bandwidth,
-                     uint32_t decode_cycles,
-                     uint32_t dispatch_cycles,
-                     uint32_t execute_to_commit_cycles,
-                     uint32_t prediction_cycles,
-                     uint32_t misprediction_penalty,
+                     const vector<uint32_t>& commit_bandwidth,
+                     const vector<uint32_t>& decode_cycles,
+                     const vector<uint32_t>& dispatch_cycles,
+                     const vector<uint32_t>& execute_to_commit_cycles,
+                     const vector<uint32_t>& prediction_cycles,
+                     const vector<uint32_t>& misprediction_penalty,
                      uint32_t mem_issue_bandwidth,
                      uint32_t mem_commit_bandwidth,
                      uint32_t max_mem_accesses,
@@ -0,0 +1,298 @@
+/**
+ * Copyright (c) Microsoft Corporation.
+ * 
+ * MIT License
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef LANE_SCOREBOARD_H
+#define LANE_SCOREBOARD_H
+
+#include <vector>
+
+#include "calipers_defs.h"
+#include "calipers_types.h"
+#include "graph_util.h"
+#include "scoreboard.h"
+
+
+/**
+ * A class for keeping track of the users of different execution units and
+ * queues in W scenarios at once
+ * This is the lane-vectorized counterpart of Scoreboard: the state is kept as
+ * [resource][unit][lane] arrays, and each call schedules an operation in all
+ * the given scenarios (lanes). The number of units of a resource (or entries
+ * of a queue) may differ across scenarios, but the latencies may not.
+ */
+template <uint32_t W>
+class LaneScoreboard
+{
+  private:
+    typedef struct RESOURCE_LANES
+    {
+        bool initialized;
+        uint32_t count[W];
+        uint32_t latency;
+        bool pipelined;
+        uint32_t nextAvailable[W];
+        vector<uint64_t> assignedInstrNum; // [unit * W + lane]
+        vector<int> assignedOp; // [unit * W + lane], for resources that do a mixture of operations
+    } ResourceLanes;
+
+
+    typedef struct QUEUE_LANES
+    {
+        bool initialized;
+        uint32_t size[W];
+        bool uniformSize; // Is the size the same in all scenarios?
+        uint32_t nextAvailable[W];
+        vector<uint64_t> assignedInstrNum; // [entry * W + lane]
+        vector<uint32_t> latency; // [entry * W + lane]
+    } QueueLanes;
+
+    ResourceLanes resources[Resource::RscLast + 1];
+    // Index: Resource type (from enum Resource)
+
+    pair<uint32_t, bool> mixedOperationSpec[Resource::RscLast + 1];
+    // Index: Operation type (from enum Resource)
+    // Value.first: Operation latency
+    // Value.second: Pipelined?
+
+    QueueLanes queues[QueueResource::RscQueueLast + 1];
+    // Index: Queue type (from enum QueueResource)
+
+  public:
+    LaneScoreboard()
+    {
+        for (int i = 0; i <= Resource::RscLast; ++i)
+        {
+            resources[i].initialized = false;
+            mixedOperationSpec[i] = pair<uint32_t, bool>(0, false);
+        }
+        for (int i = 0; i <= QueueResource::RscQueueLast; ++i)
+        {
+            queues[i].initialized = false;
+        }
+    }
+
+    void setMixedOperation(int operation_type, int resource_type,
+                           uint32_t latency, bool pipelined)
+    {
+        if ((executingResource(operation_type) != resource_type) ||
+            (operation_type == resource_type))
+        {
+            CALIPERS_ERROR("Invalid resource for the mixed operation");
+        }
+
+        if (!resources[resource_type].initialized)
+        {
+            CALIPERS_ERROR("Resource for the mixed operation not initialized yet");
+        }
+
+        if (resources[resource_type].assignedOp.empty())
+        {
+            resources[resource_type].assignedOp.assign(
+                resources[resource_type].assignedInstrNum.size(), -1);
+        }
+
+        mixedOperationSpec[operation_type].first = latency;
+        mixedOperationSpec[operation_type].second = pipelined;
+    }
+
+    void initResource(int resource_type, const vector<uint32_t>& count,
+                      uint32_t latency, bool pipelined)
+    {
+        if (resources[resource_type].initialized)
+        {
+            CALIPERS_ERROR("Resource already initialized");
+        }
+
+        uint32_t max_count = 0;
+        for (uint32_t i = 0; i < W; ++i)
+        {
+            resources[resource_type].count[i] = count[i];
+            max_count = max(max_count, count[i]);
+        }
+        resources[resource_type].initialized = true;
+        resources[resource_type].latency = latency;
+        resources[resource_type].pipelined = pipelined;
+        resources[resource_type].assignedInstrNum.resize(max_count * W);
+        resetResource(resource_type);
+    }
+
+    void resetResource(int resource_type)
+    {
+        for (uint32_t i = 0; i < W; ++i)
+        {
+            resources[resource_type].nextAvailable[i] = 0;
+        }
+        fill(resources[resource_type].assignedInstrNum.begin(),
+             resources[resource_type].assignedInstrNum.end(), UINT64_MAX);
+    }
+
+    void initQueue(int type, const vector<uint32_t>& size)
+    {
+        if (queues[type].initialized)
+        {
+            CALIPERS_ERROR("Queue already initialized");
+        }
+
+        uint32_t max_size = 0;
+        queues[type].uniformSize = true;
+        for (uint32_t i = 0; i < W; ++i)
+        {
+            queues[type].size[i] = size[i];
+            queues[type].uniformSize = queues[type].uniformSize && (size[i] == size[0]);
+            max_size = max(max_size, size[i]);
+        }
+        queues[type].initialized = true;
+        queues[type].assignedInstrNum.resize(max_size * W);
+        queues[type].latency.resize(max_size * W);
+        resetQueue(type);
+    }
+
+    void resetQueue(int type)
+    {
+        for (uint32_t i = 0; i < W; ++i)
+        {
+            queues[type].nextAvailable[i] = 0;
+        }
+        fill(queues[type].assignedInstrNum.begin(), queues[type].assignedInstrNum.end(), UINT64_MAX);
+        fill(queues[type].latency.begin(), queues[type].latency.end(), 0);
+    }
+
+    // Schedules operation_type[i] of instruction instr_num[i] in each scenario i of lanes.
+    // Returns the cycles to wait for the previous user of the assigned unit
+    // (ABSENT in the other scenarios), whose instruction number is put in
+    // previous_instr[i] (UINT64_MAX if none).
+    WeightVector<W> scheduleResource(const int* operation_type, const uint64_t* instr_num,
+                                     LaneMask lanes, uint64_t* previous_instr)
+    {
+        int32_t wait_cycles[W];
+
+        for (uint32_t i = 0; i < W; ++i)
+        {
+            if (((lanes >> i) & 1) == 0)
+            {
+                previous_instr[i] = UINT64_MAX;
+                wait_cycles[i] = WeightVector<W>::ABSENT;
+                continue;
+            }
+
+            int resource_type = executingResource(operation_type[i]);
+            ResourceLanes& resource = resources[resource_type];
+            uint32_t sample_num = resource.nextAvailable[i];
+            uint32_t unit = sample_num * W + i;
+            uint32_t latency = resource.latency;
+            bool pipelined = resource.pipelined;
+
+            if (resource_type != operation_type[i])
+            {
+                int previous_operation_type = resource.assignedOp[unit];
+                if (previous_operation_type != -1)
+                {
+                    latency = mixedOperationSpec[previous_operation_type].first;
+                    pipelined = mixedOperationSpec[previous_operation_type].second;
+                }
+                resource.assignedOp[unit] = operation_type[i];
+            }
+
+            previous_instr[i] = resource.assignedInstrNum[unit];
+            wait_cycles[i] = pipelined ? 1 : latency;
+
+            resource.assignedInstrNum[unit] = instr_num[i];
+            resource.nextAvailable[i] = (sample_num + 1) % resource.count[i];
+        }
+
+        return WeightVector<W>(wait_cycles, W);
+    }
+
+    // Same as above, for an operation type that is the same in all scenarios
+    WeightVector<W> scheduleResource(int operation_type, const uint64_t* instr_num,
+                                     LaneMask lanes, uint64_t* previous_instr)
+    {
+        int operation_types[W];
+        fill(operation_types, operation_types + W, operation_type);
+        return scheduleResource(operation_types, instr_num, lanes, previous_instr);
+    }
+
+    // Puts instruction instr_num[i], which stays in the queue type[i] for
+    // latency[i] cycles, in each scenario i of lanes (see scheduleResource).
+    WeightVector<W> scheduleQueue(const int* type, const uint64_t* instr_num, const uint32_t* latency,
+                                  LaneMask lanes, uint64_t* previous_instr)
+    {
+        int32_t wait_cycles[W];
+
+        for (uint32_t i = 0; i < W; ++i)
+        {
+            if (((lanes >> i) & 1) == 0)
+            {
+                previous_instr[i] = UINT64_MAX;
+                wait_cycles[i] = WeightVector<W>::ABSENT;
+                continue;
+            }
+
+            QueueLanes& queue = queues[type[i]];
+            uint32_t entry = queue.nextAvailable[i];
+            uint32_t slot = entry * W + i;
+            previous_instr[i] = queue.assignedInstrNum[slot];
+            wait_cycles[i] = queue.latency[slot];
+
+            queue.nextAvailable[i] = (entry + 1) % queue.size[i];
+            queue.assignedInstrNum[slot] = instr_num[i];
+            queue.latency[slot] = latency[i];
+        }
+
+        return WeightVector<W>(wait_cycles, W);
+    }
+
+    // Same as above, for a queue type that is the same in all scenarios
+    WeightVector<W> scheduleQueue(int type, const uint64_t* instr_num, const uint32_t* latency,
+                                  LaneMask lanes, uint64_t* previous_instr)
+    {
+        int types[W];
+        fill(types, types + W, type);
+        return scheduleQueue(types, instr_num, latency, lanes, previous_instr);
+    }
+
+    uint32_t getResourceLatency(int type)
+    {
+        if (executingResource(type) == type)
+        {
+            return resources[type].latency;
+        }
+        else
+        {
+            return mixedOperationSpec[type].first;
+        }
+    }
+
+    // Only for the queues whose size is the same in all scenarios
+    uint32_t getQueueSize(int type)
+    {
+        if (!queues[type].uniformSize)
+        {
+            CALIPERS_ERROR("Queue size differs across scenarios");
+        }
+        return queues[type].size[0];
+    }
+};
+
+#endif // LANE_SCOREBOARD_H
@@ -0,0 +1,124 @@
+/**
+ * Copyright (c) Microsoft Corporation.
+ * 
+ * MIT License
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef MODEL_POLICY_H
+#define MODEL_POLICY_H
+
+#include <cstdint>
+
+#include "calipers_defs.h"
+#include "calipers_types.h"
+#include "cache.h"
+#include "trace_cache.h"
+#include "branch_predictor.h"
+#include "trace_bp.h"
+
+using namespace std;
+
+
+/**
+ * The types of the instruction stream, the caches and the branch predictor
+ * that a core model is specialized for
+ * The stream is read with direct calls that can be inlined, and whether the
+ * cycles come from the trace is known at compile time. The modeled caches and
+ * predictors are the base classes (one virtual call, small next to the model).
+ */
+template <class S, class IC, class DC, class B>
+struct ModelPolicy
+{
+    typedef S Stream;
+    typedef IC ICache;
+    typedef DC DCache;
+    typedef B Bp;
+};
+
+typedef struct INSTRUCTION_TIMING
+{
+    uint32_t lsCycles; // Load/store cycles (loads and stores only)
+    bool mispredicted; // Whether the instruction was mispredicted
+    uint32_t fetchCycles;
+} InstructionTiming;
+
+
+/**
+ * Picks the instantiation of E::modelTrace (the loop that reads and models
+ * the instructions) for the configured caches and branch predictor
+ * Each of them either comes from the trace or is modeled, so there are eight
+ * instantiations, and the engine selects one at startup.
+ */
+template <class E, class S>
+class ModelPolicySelector
+{
+  public:
+    typedef void (E::*TraceModeler)();
+
+    static TraceModeler select(int icache_type, int dcache_type, int bp_type)
+    {
+        switch (icache_type)
+        {
+            case CacheType::TraceC:
+                return selectDcache<TraceCache>(dcache_type, bp_type);
+            case CacheType::IdealC:
+            case CacheType::StatisticalC:
+            case CacheType::RealC:
+                return selectDcache<Cache>(dcache_type, bp_type);
+            default:
+                CALIPERS_ERROR("Invalid I-cache model");
+        }
+    }
+
+  private:
+    template <class IC>
+    static TraceModeler selectDcache(int dcache_type, int bp_type)
+    {
+        switch (dcache_type)
+        {
+            case CacheType::TraceC:
+                return selectBp<IC, TraceCache>(bp_type);
+            case CacheType::IdealC:
+            case CacheType::StatisticalC:
+            case CacheType::RealC:
+                return selectBp<IC, Cache>(bp_type);
+            default:
+                CALIPERS_ERROR("Invalid D-cache model");
+        }
+    }
+
+    template <class IC, class DC>
+    static TraceModeler selectBp(int bp_type)
+    {
+        switch (bp_type)
+        {
+            case BranchPredictorType::TraceB:
+                return &E::template modelTrace<ModelPolicy<S, IC, DC, TraceBp>>;
+            case BranchPredictorType::StatisticalB:
+                return &E::template modelTrace<ModelPolicy<S, IC, DC, BranchPredictor>>;
+            default:
+                CALIPERS_ERROR("Invalid branch prediction model");
+        }
+    }
+};
+
+
+#endif // MODEL_POLICY_H
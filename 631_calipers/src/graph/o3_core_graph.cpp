@@ -32,28 +32,33 @@
 #include "real_cache.h"
 #include "branch_predictor.h"
 #include "statistical_bp.h"
+#include "riscv_stream.h"
 
-O3CoreGraph::O3CoreGraph(string trace_file_name,
+template <uint32_t W>
+const int32_t O3CoreGraph<W>::Unreachable;
+
+template <uint32_t W>
+O3CoreGraph<W>::O3CoreGraph(string trace_file_name,
                          string result_file_name, 
                          InstructionStream* instr_stream,
                          uint32_t instr_buffer_size,
-                         uint32_t instr_queue_size,
-                         uint32_t fetch_bandwidth,
-                         uint32_t dispatch_bandwidth,
-                         uint32_t issue_bandwidth,
-                         uint32_t commit_bandwidth,
-                         uint32_t decode_cycles,
-                         uint32_t dispatch_cycles,
-                         uint32_t execute_to_commit_cycles,
-                         uint32_t prediction_cycles,
-                         uint32_t misprediction_penalty,
+                         const vector<uint32_t>& instr_queue_size,
+                         const vector<uint32_t>& fetch_bandwidth,
+                         const vector<uint32_t>& dispatch_bandwidth,
+                         const vector<uint32_t>& issue_bandwidth,
+                         const vector<uint32_t>& commit_bandwidth,
+                         const vector<uint32_t>& decode_cycles,
+                         const vector<uint32_t>& dispatch_cycles,
+                         const vector<uint32_t>& execute_to_commit_cycles,
+                         const vector<uint32_t>& prediction_cycles,
+                         const vector<uint32_t>& misprediction_penalty,
                          uint32_t mem_issue_bandwidth,
                          uint32_t mem_commit_bandwidth,
-                         uint32_t int_alu_count,
-                         uint32_t int_mul_div_count,
-                         uint32_t fp_alu_count,
-                         uint32_t fp_mul_div_count,
-                         uint32_t lsu_count,
+                         const vector<uint32_t>& int_alu_count,
+                         const vector<uint32_t>& int_mul_div_count,
+                         const vector<uint32_t>& fp_alu_count,
+                         const vector<uint32_t>& fp_mul_div_count,
+                         const vector<uint32_t>& lsu_count,
                          uint32_t lq_size,
                          uint32_t sq_size,
                          int bp_type,
@@ -61,21 +66,62 @@ O3CoreGraph::O3CoreGraph(string trace_file_name,
                          int icache_type,
                          string icache_config,
                          int dcache_type,
-                         string dcache_config) :
-                         Graph(trace_file_name, result_file_name, instr_stream),
+                         string dcache_config,
+                         bool lazy_breakdown,
+                         uint32_t analysis_threads,
+                         string spill_file_name,
+                         bool overlap_windows) :
+                         VectorGraph<W>(trace_file_name, result_file_name, instr_stream),
                          instrBufferSize(instr_buffer_size),
-                         fetchBandwidth(fetch_bandwidth),
-                         dispatchBandwidth(dispatch_bandwidth),
-                         issueBandwidth(issue_bandwidth),
-                         commitBandwidth(commit_bandwidth),
-                         decodeCycles(decode_cycles),
-                         dispatchCycles(dispatch_cycles),
-                         executeToCommitCycles(execute_to_commit_cycles),
-                         predictionCycles(prediction_cycles),
-                         mispredictionPenalty(misprediction_penalty),
+                         fetchBandwidth(groupLanes(fetch_bandwidth)),
+                         dispatchBandwidth(groupLanes(dispatch_bandwidth)),
+                         commitBandwidth(groupLanes(commit_bandwidth)),
+                         decodeCycles(EdgeWeight::fromLanes<W>(decode_cycles)),
+                         dispatchCycles(EdgeWeight::fromLanes<W>(dispatch_cycles)),
+                         executeToCommitCycles(EdgeWeight::fromLanes<W>(execute_to_commit_cycles)),
+                         predictionCycles(EdgeWeight::fromLanes<W>(prediction_cycles)),
+                         mispredictionPenalty(EdgeWeight::fromLanes<W>(misprediction_penalty)),
                          memIssueBandwidth(mem_issue_bandwidth),
-                         memCommitBandwidth(mem_commit_bandwidth)
+                         memCommitBandwidth(mem_commit_bandwidth),
+                         addedEdges(0),
+                         addedResourceEdges(0),
+                         removedEdges(0),
+                         lanePool(analysis_threads),
+                         overlapWindows(overlap_windows),
+                         pendingWindow(false),
+                         windowEnd(0),
+                         functionalBegin(0),
+                         detailedBegin(0),
+                         shardBegin(0),
+                         shardEnd(UINT64_MAX)
 {
+    // The whole window is kept in the graph, so the critical path can be walked backwards
+    lazyBreakdown = lazy_breakdown;
+    if ((lanePool.size() > 1) && !lazyBreakdown)
+    {
+        // The eager breakdowns of all scenarios of a vertex are stored together,
+        // and the segments of a scenario are not analyzed in order
+        CALIPERS_INFO("Critical path breakdowns are calculated lazily with multiple threads");
+        lazyBreakdown = true;
+    }
+
+    if (!spill_file_name.empty())
+    {
+        spilledEdges.open(spill_file_name);
+        CALIPERS_INFO("The graph is spilled to " << spill_file_name);
+    }
+
+    if (overlapWindows && spilledEdges.isOpen())
+    {
+        // All windows are spilled to the same file
+        CALIPERS_INFO("Windows are not overlapped when the graph is spilled");
+        overlapWindows = false;
+    }
+
+    // The in-order dispatch/commit edges are redundant with a bandwidth of one
+    inOrderDispatchLanes = lanesOtherThan(dispatchBandwidth, 1);
+    inOrderCommitLanes = lanesOtherThan(commitBandwidth, 1);
+
     switch (bp_type)
     {
         case BranchPredictorType::TraceB:
@@ -124,73 +170,127 @@ O3CoreGraph::O3CoreGraph(string trace_file_name,
             CALIPERS_ERROR("Invalid D-cache model");
     }
 
-    for (uint32_t i = 0; i < VECTOR_WIDTH; ++i)
-    {
-        // TODO: Parameterize the last two arguments of initResource and setMixedOperation
-        // (i.e., latency and pipelined)
-        //scoreboard[i].initResource(Resource::RscFetch, fetch_bandwidth, 1, true);
-        //scoreboard[i].initResource(Resource::RscDispatch, dispatch_bandwidth, 1, true);
-        scoreboard[i].initResource(Resource::RscIssue, issue_bandwidth, 1, true);
-        //scoreboard[i].initResource(Resource::RscMemIssue, mem_issue_bandwidth, 1, true);
-        //scoreboard[i].initResource(Resource::RscCommit, commit_bandwidth, 1, true);
-        //scoreboard[i].initResource(Resource::RscMemCommit, mem_commit_bandwidth, 1, true);
-        scoreboard[i].initResource(Resource::RscIntAlu, int_alu_count, 1, true);
-        scoreboard[i].initResource(Resource::RscIntMulDiv, int_mul_div_count, 0, false);
-        scoreboard[i].setMixedOperation(Resource::RscIntMul, Resource::RscIntMulDiv, 3, true);
-        scoreboard[i].setMixedOperation(Resource::RscIntDiv, Resource::RscIntMulDiv, 20, false);
-        scoreboard[i].initResource(Resource::RscFpAlu, fp_alu_count, 2, true);
-        scoreboard[i].initResource(Resource::RscFpMulDiv, fp_mul_div_count, 0, false);
-        scoreboard[i].setMixedOperation(Resource::RscFpMul, Resource::RscFpMulDiv, 4, true);
-        scoreboard[i].setMixedOperation(Resource::RscFpDiv, Resource::RscFpMulDiv, 12, false);
-        scoreboard[i].initResource(Resource::RscLsu, lsu_count, 1, true);
-
-        scoreboard[i].initQueue(QueueResource::RscInstrQ, instr_queue_size);
-        scoreboard[i].initQueue(QueueResource::RscLQ, lq_size);
-        scoreboard[i].initQueue(QueueResource::RscSQ, sq_size);
-    }
-
-    intAluTotalCycles = scoreboard[0].getResourceLatency(Resource::RscIntAlu);
-
-    ldStWindow = new pair<uint64_t, pair<uint64_t, uint32_t>>[lq_size + sq_size];
-    ldStWindowType = new bool[lq_size + sq_size];
+    // The trace is read by a RiscvStream (the only supported ISA)
+    traceModeler = ModelPolicySelector<O3CoreGraph<W>, RiscvStream>::select(
+        icache_type, dcache_type, bp_type);
+
+    // TODO: Parameterize the last two arguments of initResource and setMixedOperation
+    // (i.e., latency and pipelined)
+    //scoreboard.initResource(Resource::RscFetch, fetch_bandwidth, 1, true);
+    //scoreboard.initResource(Resource::RscDispatch, dispatch_bandwidth, 1, true);
+    scoreboard.initResource(Resource::RscIssue, issue_bandwidth, 1, true);
+    //scoreboard.initResource(Resource::RscMemIssue, mem_issue_bandwidth, 1, true);
+    //scoreboard.initResource(Resource::RscCommit, commit_bandwidth, 1, true);
+    //scoreboard.initResource(Resource::RscMemCommit, mem_commit_bandwidth, 1, true);
+    scoreboard.initResource(Resource::RscIntAlu, int_alu_count, 1, true);
+    scoreboard.initResource(Resource::RscIntMulDiv, int_mul_div_count, 0, false);
+    scoreboard.setMixedOperation(Resource::RscIntMul, Resource::RscIntMulDiv, 3, true);
+    scoreboard.setMixedOperation(Resource::RscIntDiv, Resource::RscIntMulDiv, 20, false);
+    scoreboard.initResource(Resource::RscFpAlu, fp_alu_count, 2, true);
+    scoreboard.initResource(Resource::RscFpMulDiv, fp_mul_div_count, 0, false);
+    scoreboard.setMixedOperation(Resource::RscFpMul, Resource::RscFpMulDiv, 4, true);
+    scoreboard.setMixedOperation(Resource::RscFpDiv, Resource::RscFpMulDiv, 12, false);
+    scoreboard.initResource(Resource::RscLsu, lsu_count, 1, true);
+
+    scoreboard.initQueue(QueueResource::RscInstrQ, instr_queue_size);
+    scoreboard.initQueue(QueueResource::RscLQ, vector<uint32_t>(W, lq_size));
+    scoreboard.initQueue(QueueResource::RscSQ, vector<uint32_t>(W, sq_size));
+
+    intAluTotalCycles = scoreboard.getResourceLatency(Resource::RscIntAlu);
+
+    bookkeeping.initLdStWindow(lq_size + sq_size, true);
 
     initBookKeeping();
 }
 
-O3CoreGraph::~O3CoreGraph()
+template <uint32_t W>
+O3CoreGraph<W>::~O3CoreGraph()
 {
-    delete[] ldStWindow;
-    delete[] ldStWindowType;
+    if (analysisThread.joinable())
+    {
+        analysisThread.join();
+    }
+}
+
+template <uint32_t W>
+uint64_t O3CoreGraph<W>::windowBytes(uint64_t window_instructions, bool overlap_windows,
+                                     bool spilled)
+{
+    // With overlapped windows, the next window is constructed while one is analyzed.
+    // The critical parents take 4 bytes per vertex and scenario (see criticalParent).
+    // A spilled window is not overlapped, and only its vertices are in the memory,
+    // with 4 more bytes for the sweeps (see sweepFinalCriticalPath). Its edges (about
+    // half of the 2 KB per instruction of instructionBytes) are in the spill file,
+    // whose pages the kernel can write back and reclaim, so they are not counted.
+    uint64_t parent_bytes = (VertexType::Last + 1) * W * sizeof(uint32_t);
+    if (spilled)
+    {
+        return (VectorGraph<W>::instructionBytes() - 1024 + 2 * parent_bytes) *
+               window_instructions;
+    }
+    return (VectorGraph<W>::instructionBytes() + parent_bytes) * window_instructions *
+           (overlap_windows ? 2 : 1);
 }
 
-void O3CoreGraph::run()
+template <uint32_t W>
+void O3CoreGraph<W>::run()
 {
     CALIPERS_INFO("Running the graph-based modeler...");
 
+    (this->*traceModeler)();
+
+    CALIPERS_INFO("Instruction stream time: "
+                  << (streamTime / 1000000) << " ms" << endl);
+    CALIPERS_INFO("Graph construction time: "
+                  << (graphConstructionTime / 1000000) << " ms" << endl);
+    CALIPERS_INFO("Graph analysis time:     "
+                  << (graphAnalysisTime / 1000000) << " ms" << endl);
+    CALIPERS_INFO("Compacted graph edges:   "
+                  << removedEdges << " of " << (addedEdges + addedResourceEdges)
+                  << " removed" << endl);
+}
+
+template <uint32_t W>
+template <class P>
+void O3CoreGraph<W>::modelTrace()
+{
+    typename P::Stream* stream = static_cast<typename P::Stream*>(instrStream);
     sys_nanoseconds my_time;
 
     while (true)
     {
         my_time = chrono::system_clock::now();
-        Instruction* instr = instrStream->next();
+        Instruction* instr = stream->next();
         streamTime += (chrono::system_clock::now() - my_time).count();
 
-        if ((instrCount > 0) && (instrCount % AnalysisWindow == 0))
+        if ((instrCount > functionalBegin) && (instrCount % AnalysisWindow == 0))
         {
-            anaylzeWindow();
+            // The windows of the detailed warmup are discarded
+            if (instrCount > shardBegin)
+            {
+                handOverWindow();
+            }
             initBookKeeping();
         }
 
-        if (instr == NULL)
+        if ((instr == NULL) || (instrCount == shardEnd))
         {
-            if (instrCount % AnalysisWindow != 0)
+            if ((instrCount > shardBegin) && (instrCount % AnalysisWindow != 0))
             {
-                anaylzeWindow();
+                handOverWindow();
             }
+            finishWindow();
             break;
         }
 
-        model(instr);
+        if (instrCount < detailedBegin)
+        {
+            warm<P>(instr);
+        }
+        else
+        {
+            model<P>(instr);
+        }
         ++instrCount;
 
         if (instrCount % 100000 == 0)
@@ -198,40 +298,61 @@ void O3CoreGraph::run()
             CALIPERS_INFO("*** " << instrCount << " instructions modeled" << endl);
         }
     }
-
-    CALIPERS_INFO("Instruction stream time: "
-                  << (streamTime / 1000000) << " ms" << endl);
-    CALIPERS_INFO("Graph construction time: "
-                  << (graphConstructionTime / 1000000) << " ms" << endl);
-    CALIPERS_INFO("Graph analysis time:     "
-                  << (graphAnalysisTime / 1000000) << " ms" << endl);
 }
 
-void O3CoreGraph::initBookKeeping()
+template <uint32_t W>
+void O3CoreGraph<W>::setShard(uint64_t functional_begin, uint64_t detailed_begin,
+                              uint64_t shard_begin, uint64_t shard_end)
 {
-    currentIcacheLine = UINT64_MAX;
-    lastMisprediction = UINT64_MAX;
-    lastBranch = UINT64_MAX;
-    previousInstrMispredicted = false;
-    previousWasBranch = false;
-    lastMemLdSt = UINT64_MAX;
-    ldStWindowPointer = 0;
-
-    regLastWrittenBy.clear();
-    regLastWrittenByLoad.clear();
-
-    uint32_t ld_st_window_size = scoreboard[0].getQueueSize(QueueResource::RscLQ) +
-                                 scoreboard[0].getQueueSize(QueueResource::RscSQ);
-    for (uint32_t i = 0; i < ld_st_window_size; ++i)
+    // A window only keeps the caches, the branch predictor, and the stream counters
+    // of the earlier windows (see initBookKeeping), so the shard starts at a window.
+    if ((functional_begin % AnalysisWindow != 0) || (detailed_begin % AnalysisWindow != 0) ||
+        (shard_begin % AnalysisWindow != 0) || (functional_begin > detailed_begin) ||
+        (detailed_begin > shard_begin) || (shard_begin >= shard_end))
     {
-        ldStWindow[i].first = UINT64_MAX;
+        CALIPERS_ERROR("Invalid shard: " << functional_begin << ", " << detailed_begin
+                       << ", " << shard_begin << ", " << shard_end);
     }
 
+    functionalBegin = functional_begin;
+    detailedBegin = detailed_begin;
+    shardBegin = shard_begin;
+    shardEnd = shard_end;
+    instrCount = functional_begin;
+    analyzedWindows = shard_begin / AnalysisWindow;
+}
+
+template <uint32_t W>
+void O3CoreGraph<W>::initBookKeeping()
+{
+    currentIcacheLine = UINT64_MAX;
+    bookkeeping.reset();
+
+    nextGraph.clear();
+    spilledEdges.clear();
+
+    // Only the modeled instructions of the window are looked up, so the entries
+    // are added as they are modeled (the window may be much longer than the trace).
+    // The maps keep their buckets across windows, and start with room for a
+    // few hundred thousand instructions rather than growing from empty
+    uint64_t initial_entries = min<uint64_t>(AnalysisWindow, 1 << 18);
+    nextExecutionType.clear();
+    nextExecutionType.reserve(initial_entries);
+    nextLsCycles.clear();
+    nextLsCycles.reserve(initial_entries);
+    nextExecutionCycles.clear();
+    nextExecutionCycles.reserve(initial_entries);
+}
+
+template <uint32_t W>
+void O3CoreGraph<W>::initAnalysis()
+{
     // Note that the hash of i and i + AnalysisWindow is the same for 
     // the maps indexed by a vertex.
     Vertex first_vertex(0, 0);
-    Vector zero_vector(0);
-    length[first_vertex] = zero_vector;
+    Vector<W> zero_vector(0);
+    length[first_vertex] = LengthVector<W>(0);
+    lengthBase = zero_vector;
     criticalPathCycles[first_vertex].goodFetchHitCycles = zero_vector;
     criticalPathCycles[first_vertex].goodFetchMissCycles = zero_vector;
     criticalPathCycles[first_vertex].badFetchHitCycles = zero_vector;
@@ -258,168 +379,307 @@ void O3CoreGraph::initBookKeeping()
     criticalPathInstructions[first_vertex].storeInstructions = zero_vector;
     criticalPathInstructions[first_vertex].branchInstructions = zero_vector;
     criticalPathInstructions[first_vertex].otherInstructions = zero_vector;
+    if (lazyBreakdown)
+    {
+        resetPredecessorLog(first_vertex);
+    }
 
-    graph.clear();
+    //scoreboard.resetResource(Resource::RscFetch);
+    //scoreboard.resetResource(Resource::RscDispatch);
+    scoreboard.resetResource(Resource::RscIssue);
+    //scoreboard.resetResource(Resource::RscMemIssue);
+    //scoreboard.resetResource(Resource::RscCommit);
+    //scoreboard.resetResource(Resource::RscMemCommit);
+    scoreboard.resetResource(Resource::RscIntAlu);
+    scoreboard.resetResource(Resource::RscIntMulDiv);
+    scoreboard.resetResource(Resource::RscFpAlu);
+    scoreboard.resetResource(Resource::RscFpMulDiv);
+    scoreboard.resetResource(Resource::RscLsu);
+
+    scoreboard.resetQueue(QueueResource::RscInstrQ);
+    scoreboard.resetQueue(QueueResource::RscLQ);
+    scoreboard.resetQueue(QueueResource::RscSQ);
+}
 
-    for (uint32_t i = 0; i < AnalysisWindow; ++i)
+template <uint32_t W>
+void O3CoreGraph<W>::handOverWindow()
+{
+    // The stats of the previous window are recorded before its analysis state is reset
+    finishWindow();
+
+    graph.swap(nextGraph);
+    executionType.swap(nextExecutionType);
+    lsCycles.swap(nextLsCycles);
+    executionCycles.swap(nextExecutionCycles);
+    windowEnd = instrCount;
+    windowCounters = {instrCount, {instructionMix[0], instructionMix[1], instructionMix[2],
+                                   instructionMix[3], instructionMix[4], instructionMix[5]},
+                      l1iMisses, l2iMisses, l1dMisses, l2dMisses, bpMisses, branchCount};
+    pendingWindow = true;
+
+    if (overlapWindows)
     {
-        executionType[i] = -1;
-        lsCycles[i] = UINT32_MAX;
-        executionCycles[i] = UINT32_MAX;
+        analysisThread = thread(&O3CoreGraph<W>::anaylzeWindow, this);
+        return;
     }
 
-    for (uint32_t i = 0; i < VECTOR_WIDTH; ++i)
-    {
-        //scoreboard[i].resetResource(Resource::RscFetch);
-        //scoreboard[i].resetResource(Resource::RscDispatch);
-        scoreboard[i].resetResource(Resource::RscIssue);
-        //scoreboard[i].resetResource(Resource::RscMemIssue);
-        //scoreboard[i].resetResource(Resource::RscCommit);
-        //scoreboard[i].resetResource(Resource::RscMemCommit);
-        scoreboard[i].resetResource(Resource::RscIntAlu);
-        scoreboard[i].resetResource(Resource::RscIntMulDiv);
-        scoreboard[i].resetResource(Resource::RscFpAlu);
-        scoreboard[i].resetResource(Resource::RscFpMulDiv);
-        scoreboard[i].resetResource(Resource::RscLsu);
+    anaylzeWindow();
+    finishWindow();
 
-        scoreboard[i].resetQueue(QueueResource::RscInstrQ);
-        scoreboard[i].resetQueue(QueueResource::RscLQ);
-        scoreboard[i].resetQueue(QueueResource::RscSQ);
-    }
+    // Only one set of the containers is kept, since the windows are not overlapped
+    graph.swap(nextGraph);
+    executionType.swap(nextExecutionType);
+    lsCycles.swap(nextLsCycles);
+    executionCycles.swap(nextExecutionCycles);
 }
 
-void O3CoreGraph::anaylzeWindow()
+template <uint32_t W>
+void O3CoreGraph<W>::finishWindow()
 {
+    if (!pendingWindow)
+    {
+        return;
+    }
+    if (analysisThread.joinable())
+    {
+        analysisThread.join();
+    }
+
     sys_nanoseconds my_time = chrono::system_clock::now();
 
-    calculateCriticalPathForScheduling();
-    //recordStats(false, true);
-    modelResourceDependencies();
-    calculateFinalCriticalPath();
+    // The construction of the next window has not started or is paused here
+    swapCounters();
     recordStats(true, true);
+    swapCounters();
 
     ++analyzedWindows;
+    pendingWindow = false;
 
     graphAnalysisTime += (chrono::system_clock::now() - my_time).count();
 }
 
-void O3CoreGraph::model(Instruction* instr)
+template <uint32_t W>
+void O3CoreGraph<W>::swapCounters()
 {
-    sys_nanoseconds my_time = chrono::system_clock::now();
-
-    Vertex fetch_vertex(VertexType::InstrFetch, instrCount);
-    Vertex dispatch_vertex(VertexType::InstrDispatch, instrCount);
-    Vertex execute_vertex(VertexType::InstrExecute, instrCount);
-    Vertex mem_vertex(VertexType::MemExecute, instrCount);
-    Vertex commit_vertex(VertexType::InstrCommit, instrCount);
+    swap(instrCount, windowCounters.instrCount);
+    for (int i = 0; i < 6; ++i)
+    {
+        swap(instructionMix[i], windowCounters.instructionMix[i]);
+    }
+    swap(l1iMisses, windowCounters.l1iMisses);
+    swap(l2iMisses, windowCounters.l2iMisses);
+    swap(l1dMisses, windowCounters.l1dMisses);
+    swap(l2dMisses, windowCounters.l2dMisses);
+    swap(bpMisses, windowCounters.bpMisses);
+    swap(branchCount, windowCounters.branchCount);
+}
 
-    uint32_t execution_cycles;
-    bool store_to_load_forwarding;
-    uint32_t ls_cycles;
+template <uint32_t W>
+void O3CoreGraph<W>::resetWindowVertices()
+{
+    // The vertices of this window share the map entries of the same positions
+    // in the earlier windows. Their lengths (and predecessor records, which
+    // refer to the log of their own window) would be kept by the relaxations
+    // that do not reach them, so all the vertices start from zero, as in the
+    // first window.
+    for (uint64_t i = analyzedWindows * AnalysisWindow; i < windowEnd; ++i)
+    {
+        for (int j = 0; j <= VertexType::Last; ++j)
+        {
+            Vertex v(j, i);
+            auto vertex_length = length.find(v);
+            if (vertex_length != length.end())
+            {
+                vertex_length->second = LengthVector<W>(0);
+            }
 
-    bool is_load = (instr->memLoadCount == 1); // Also covers atomic instructions
-    bool is_store = (instr->memStoreCount == 1); // Also covers atomic instructions
-    bool is_load_store = is_load || is_store;
-    bool is_branch = (instr->executionType == ExecutionType::BranchCond) || 
-                     (instr->executionType == ExecutionType::BranchUncond);
-    bool is_int = (instr->executionType == ExecutionType::IntBase) || is_branch;
-    bool is_int_mul = (instr->executionType == ExecutionType::IntMul);
-    bool is_int_div = (instr->executionType == ExecutionType::IntDiv);
-    bool is_fp = (instr->executionType == ExecutionType::FpBase);
-    bool is_fp_mul = (instr->executionType == ExecutionType::FpMul);
-    bool is_fp_div = (instr->executionType == ExecutionType::FpDiv);
+            auto predecessors = criticalPredecessors.find(v);
+            if (predecessors != criticalPredecessors.end())
+            {
+                for (uint32_t k = 0; k < W; ++k)
+                {
+                    predecessors->second.record[k] = 0;
+                }
+            }
+        }
+    }
+}
 
-    executionType[instrCount % AnalysisWindow] = instr->executionType;    
+template <uint32_t W>
+void O3CoreGraph<W>::anaylzeWindow()
+{
+    sys_nanoseconds my_time = chrono::system_clock::now();
 
-    // 0: int, 1: fp, 2: load, 3: store, 4: branch, 5: other
-    if (is_branch)
+    initAnalysis();
+    if (analyzedWindows > 0)
     {
-        ++instructionMix[4];
+        resetWindowVertices();
     }
-    else if (is_int || is_int_mul || is_int_div)
+
+    if (spilledEdges.isOpen())
     {
-        ++instructionMix[0];
+        sweepCriticalPathForScheduling();
+        modelResourceDependencies();
+        sweepFinalCriticalPath();
     }
-    else if (is_fp || is_fp_mul || is_fp_div)
+    else
     {
-        ++instructionMix[1];
+        compactGraph();
+        calculateCriticalPathForScheduling();
+        //recordStats(false, true);
+        modelResourceDependencies();
+        calculateFinalCriticalPath();
     }
-    else if (is_load)
+
+    graphAnalysisTime += (chrono::system_clock::now() - my_time).count();
+}
+
+template <uint32_t W>
+template <class P>
+void O3CoreGraph<W>::warm(Instruction* instr)
+{
+    sys_nanoseconds my_time = chrono::system_clock::now();
+    typename P::DCache* dcache_model = static_cast<typename P::DCache*>(dcache);
+
+    // Functional warmup: Only the state that the windows keep (see setShard) is
+    // updated, in the same order as model. Store-to-load forwarding is only
+    // found by the construction, so every load accesses the D-cache.
+    bool is_load = (instr->memLoadCount == 1);
+    bool is_store = (instr->memStoreCount == 1);
+    bool is_branch = (instr->executionType == ExecutionType::BranchCond) ||
+                     (instr->executionType == ExecutionType::BranchUncond);
+
+    countInstruction(instr);
+
+    if (is_load)
     {
-        ++instructionMix[2];
+        countDataMiss(P::DCache::fromTrace ? instr->lsCycles :
+                      dcache_model->loadCycles(instr->memLoadBase, instr->memLoadLength));
     }
     else if (is_store)
     {
-        ++instructionMix[3];
-    }
-    else
-    {
-        ++instructionMix[5];
+        countDataMiss(P::DCache::fromTrace ? instr->lsCycles :
+                      dcache_model->storeCycles(instr->memStoreBase, instr->memStoreLength));
     }
 
-    if (is_load_store)
+    predictBranch<P>(instr, is_branch);
+    fetchCycles<P>(instr);
+
+    graphConstructionTime += (chrono::system_clock::now() - my_time).count();
+}
+
+template <uint32_t W>
+template <class P>
+void O3CoreGraph<W>::model(Instruction* instr)
+{
+    sys_nanoseconds my_time = chrono::system_clock::now();
+    typename P::DCache* dcache_model = static_cast<typename P::DCache*>(dcache);
+
+    bool is_load = (instr->memLoadCount == 1); // Also covers atomic instructions
+    bool is_store = (instr->memStoreCount == 1); // Also covers atomic instructions
+    bool is_branch = (instr->executionType == ExecutionType::BranchCond) ||
+                     (instr->executionType == ExecutionType::BranchUncond);
+    InstructionTiming timing;
+
+    countInstruction(instr);
+
+    // The D-cache, the branch predictor and the I-cache are accessed in this
+    // order, which is the order in which the statistical models draw their
+    // random numbers. Store-to-load forwarding is found before the D-cache is
+    // accessed, so the memory order edges are added first.
+    timing.lsCycles = 0;
+    if (is_load || is_store)
     {
-        if (dcache == NULL)
+        if (P::DCache::fromTrace)
         {
-            store_to_load_forwarding = false;
+            timing.lsCycles = instr->lsCycles;
         }
         else
         {
-            store_to_load_forwarding = modelMemoryOrderConstraint(instr, mem_vertex);
+            Vertex mem_vertex(VertexType::MemExecute, instrCount);
+            bool store_to_load_forwarding = modelMemoryOrderConstraint(instr, mem_vertex);
+            if (is_load)
+            {
+                timing.lsCycles = store_to_load_forwarding ?
+                    0 : dcache_model->loadCycles(instr->memLoadBase, instr->memLoadLength);
+            }
+            else
+            {
+                timing.lsCycles =
+                    dcache_model->storeCycles(instr->memStoreBase, instr->memStoreLength);
+            }
         }
     }
+    timing.mispredicted = predictBranch<P>(instr, is_branch);
+    timing.fetchCycles = fetchCycles<P>(instr);
+
+    modelInstruction(instr, timing);
+
+    graphConstructionTime += (chrono::system_clock::now() - my_time).count();
+}
+
+template <uint32_t W>
+void O3CoreGraph<W>::modelInstruction(Instruction* instr, const InstructionTiming& timing)
+{
+    Vertex fetch_vertex(VertexType::InstrFetch, instrCount);
+    Vertex dispatch_vertex(VertexType::InstrDispatch, instrCount);
+    Vertex execute_vertex(VertexType::InstrExecute, instrCount);
+    Vertex mem_vertex(VertexType::MemExecute, instrCount);
+    Vertex commit_vertex(VertexType::InstrCommit, instrCount);
+
+    uint32_t execution_cycles;
+    uint32_t ls_cycles = 0; // Only set for loads and stores
+
+    bool is_load = (instr->memLoadCount == 1); // Also covers atomic instructions
+    bool is_store = (instr->memStoreCount == 1); // Also covers atomic instructions
+    bool is_load_store = is_load || is_store;
+    bool is_branch = (instr->executionType == ExecutionType::BranchCond) || 
+                     (instr->executionType == ExecutionType::BranchUncond);
+    bool is_int = (instr->executionType == ExecutionType::IntBase) || is_branch;
+    bool is_int_mul = (instr->executionType == ExecutionType::IntMul);
+    bool is_int_div = (instr->executionType == ExecutionType::IntDiv);
+    bool is_fp = (instr->executionType == ExecutionType::FpBase);
+    bool is_fp_mul = (instr->executionType == ExecutionType::FpMul);
+    bool is_fp_div = (instr->executionType == ExecutionType::FpDiv);
+
+    nextExecutionType[instrCount % AnalysisWindow] = instr->executionType;    
 
     if (is_load)
     {
-        if (dcache == NULL)
-        {
-            ls_cycles = instr->lsCycles;
-        }
-        else
-        {
-            ls_cycles = store_to_load_forwarding ?
-                0 : dcache->loadCycles(instr->memLoadBase, instr->memLoadLength);
-        }
-        execution_cycles = scoreboard[0].getResourceLatency(Resource::RscLsu) + ls_cycles;
-        lsCycles[instrCount % AnalysisWindow] = ls_cycles;
+        ls_cycles = timing.lsCycles;
+        execution_cycles = scoreboard.getResourceLatency(Resource::RscLsu) + ls_cycles;
+        nextLsCycles[instrCount % AnalysisWindow] = ls_cycles;
     }
     else if (is_store)
     {
-        if (dcache == NULL)
-        {
-            ls_cycles = instr->lsCycles;
-        }
-        else
-        {
-            ls_cycles = dcache->storeCycles(instr->memStoreBase, instr->memStoreLength);
-        }
+        ls_cycles = timing.lsCycles;
         // Stores quickly complete
-        execution_cycles = scoreboard[0].getResourceLatency(Resource::RscLsu);
-        lsCycles[instrCount % AnalysisWindow] = ls_cycles;
+        execution_cycles = scoreboard.getResourceLatency(Resource::RscLsu);
+        nextLsCycles[instrCount % AnalysisWindow] = ls_cycles;
     }
     else if (is_int)
     {
-        execution_cycles = scoreboard[0].getResourceLatency(Resource::RscIntAlu);
+        execution_cycles = scoreboard.getResourceLatency(Resource::RscIntAlu);
     }
     else if (is_int_mul)
     {
-        execution_cycles = scoreboard[0].getResourceLatency(Resource::RscIntMul);
+        execution_cycles = scoreboard.getResourceLatency(Resource::RscIntMul);
     }
     else if (is_int_div)
     {
-        execution_cycles = scoreboard[0].getResourceLatency(Resource::RscIntDiv);
+        execution_cycles = scoreboard.getResourceLatency(Resource::RscIntDiv);
     }
     else if (is_fp)
     {
-        execution_cycles = scoreboard[0].getResourceLatency(Resource::RscFpAlu);
+        execution_cycles = scoreboard.getResourceLatency(Resource::RscFpAlu);
     }
     else if (is_fp_mul)
     {
-        execution_cycles = scoreboard[0].getResourceLatency(Resource::RscFpMul);
+        execution_cycles = scoreboard.getResourceLatency(Resource::RscFpMul);
     }
     else if (is_fp_div)
     {
-        execution_cycles = scoreboard[0].getResourceLatency(Resource::RscFpDiv);
+        execution_cycles = scoreboard.getResourceLatency(Resource::RscFpDiv);
     }
     else
     {
@@ -429,18 +689,18 @@ void O3CoreGraph::model(Instruction* instr)
     /*
     if (is_load_store)
     {
-        executionCycles[instrCount % AnalysisWindow] =
-            scoreboard[0].getResourceLatency(Resource::RscLsu);
+        nextExecutionCycles[instrCount % AnalysisWindow] =
+            scoreboard.getResourceLatency(Resource::RscLsu);
     }
     else
     {
-        executionCycles[instrCount % AnalysisWindow] = execution_cycles;
+        nextExecutionCycles[instrCount % AnalysisWindow] = execution_cycles;
     }
     */
-    executionCycles[instrCount % AnalysisWindow] = execution_cycles;
+    nextExecutionCycles[instrCount % AnalysisWindow] = execution_cycles;
 
     modelPipeline(fetch_vertex, dispatch_vertex, execute_vertex,
-                  mem_vertex, commit_vertex, instr, execution_cycles);
+                  mem_vertex, commit_vertex, instr, execution_cycles, timing);
 
     trackDataDependencies(instr, execute_vertex, mem_vertex);
 
@@ -449,98 +709,105 @@ void O3CoreGraph::model(Instruction* instr)
 
     if (is_load_store)
     {
-        lastMemLdSt = instrCount;
-        ldStWindow[ldStWindowPointer].first = instrCount;
         if (is_load)
         {
-            ldStWindow[ldStWindowPointer].second.first = instr->memLoadBase;
-            ldStWindow[ldStWindowPointer].second.second = instr->memLoadLength;
-            ldStWindowType[ldStWindowPointer] = true;
+            bookkeeping.pushLdSt(instrCount, instr->memLoadBase, instr->memLoadLength,
+                                 ls_cycles, true);
         }
         else
         {
-            ldStWindow[ldStWindowPointer].second.first = instr->memStoreBase;
-            ldStWindow[ldStWindowPointer].second.second = instr->memStoreLength;
-            ldStWindowType[ldStWindowPointer] = false;
+            bookkeeping.pushLdSt(instrCount, instr->memStoreBase, instr->memStoreLength,
+                                 ls_cycles, false);
         }
-        ldStWindowPointer = (ldStWindowPointer + 1) %
-                            (scoreboard[0].getQueueSize(QueueResource::RscLQ) +
-                             scoreboard[0].getQueueSize(QueueResource::RscSQ));
 
-        if (ls_cycles > l2dThreshold)
-        {
-            ++l2dMisses;
-        }
-        else if (ls_cycles > l1dThreshold)
-        {
-            ++l1dMisses;
-        }
+        countDataMiss(ls_cycles);
     }
 
-    previousWasBranch = is_branch;
-    linearPC = instr->pc + instr->bytes;
+    bookkeeping.previousWasBranch = is_branch;
+    bookkeeping.linearPC = instr->pc + instr->bytes;
     if (is_branch)
     {
-        lastBranch = instrCount;
+        bookkeeping.lastBranch = instrCount;
     }
 
     for (uint32_t i = 0; i < instr->regWriteCount; ++i)
     {
-        int reg_write = instr->regWrite[i];
-        regLastWrittenBy[reg_write].first = instrCount;
-        if (is_load)
-        {
-            regLastWrittenBy[reg_write].second = ls_cycles;
-            regLastWrittenByLoad[reg_write] = true;
-        }
-        else
-        {
-            regLastWrittenBy[reg_write].second = execution_cycles;
-            regLastWrittenByLoad[reg_write] = false;
-        }
+        bookkeeping.setProducer(instr->regWrite[i], instrCount,
+                                is_load ? ls_cycles : execution_cycles, is_load);
     }
+}
 
-    graphConstructionTime += (chrono::system_clock::now() - my_time).count();
+template <uint32_t W>
+void O3CoreGraph<W>::countInstruction(Instruction* instr)
+{
+    bool is_branch = (instr->executionType == ExecutionType::BranchCond) || 
+                     (instr->executionType == ExecutionType::BranchUncond);
+    bool is_int = (instr->executionType == ExecutionType::IntBase) ||
+                  (instr->executionType == ExecutionType::IntMul) ||
+                  (instr->executionType == ExecutionType::IntDiv);
+    bool is_fp = (instr->executionType == ExecutionType::FpBase) ||
+                 (instr->executionType == ExecutionType::FpMul) ||
+                 (instr->executionType == ExecutionType::FpDiv);
+
+    // 0: int, 1: fp, 2: load, 3: store, 4: branch, 5: other
+    if (is_branch)
+    {
+        ++instructionMix[4];
+    }
+    else if (is_int)
+    {
+        ++instructionMix[0];
+    }
+    else if (is_fp)
+    {
+        ++instructionMix[1];
+    }
+    else if (instr->memLoadCount == 1)
+    {
+        ++instructionMix[2];
+    }
+    else if (instr->memStoreCount == 1)
+    {
+        ++instructionMix[3];
+    }
+    else
+    {
+        ++instructionMix[5];
+    }
 }
 
-void O3CoreGraph::modelPipeline(Vertex& fetch_vertex, Vertex& dispatch_vertex,
-                                Vertex& execute_vertex, Vertex& mem_vertex,
-                                Vertex& commit_vertex, Instruction* instr,
-                                uint32_t execution_cycles)
+template <uint32_t W>
+template <class P>
+bool O3CoreGraph<W>::predictBranch(Instruction* instr, bool is_branch)
 {
     bool mispredicted;
-    uint32_t fetch_cycles;
-    bool is_load_store = (instr->memLoadCount == 1) || 
-                         (instr->memStoreCount == 1);
-    bool is_branch = (instr->executionType == BranchCond) ||
-                     (instr->executionType == BranchUncond);
-    bool no_need_for_ino_dispatch = (instrCount % AnalysisWindow == 0) ||
-                                    (dispatchBandwidth == 1);
-    bool no_need_for_ino_commit = (instrCount % AnalysisWindow == 0) || 
-                                  (commitBandwidth == 1);
-
-    // Branch prediction
-    mispredicted = previousInstrMispredicted;
-    if (bp == NULL)
+    if (P::Bp::fromTrace)
     {
-        previousInstrMispredicted = instr->mispredicted;
+        mispredicted = instr->mispredicted;
     }
     else
     {
-        previousInstrMispredicted = is_branch ? bp->mispredicted(instr->pc) : false;
+        mispredicted = is_branch ?
+            static_cast<typename P::Bp*>(bp)->mispredicted(instr->pc) : false;
     }
 
     if (is_branch)
     {
         ++branchCount;
-        if (previousInstrMispredicted)
+        if (mispredicted)
         {
             ++bpMisses;
         }
     }
+    return mispredicted;
+}
 
-    // Fetch
-    if (icache == NULL)
+template <uint32_t W>
+template <class P>
+uint32_t O3CoreGraph<W>::fetchCycles(Instruction* instr)
+{
+    uint32_t fetch_cycles;
+    if (P::ICache::fromTrace)
     {
         fetch_cycles = instr->fetchCycles;
     }
@@ -548,7 +815,8 @@ void O3CoreGraph::modelPipeline(Vertex& fetch_vertex, Vertex& dispatch_vertex,
     {
         if (currentIcacheLine != (instr->pc & (UINT64_MAX << CACHE_ADDRESS_ZEROS)))
         {
-            fetch_cycles = icache->loadCycles(instr->pc, CACHE_LINE_BYTES);
+            fetch_cycles = static_cast<typename P::ICache*>(icache)->loadCycles(
+                instr->pc, CACHE_LINE_BYTES);
         }
         else
         {
@@ -566,14 +834,49 @@ void O3CoreGraph::modelPipeline(Vertex& fetch_vertex, Vertex& dispatch_vertex,
     {
         ++l1iMisses;
     }
+    return fetch_cycles;
+}
+
+template <uint32_t W>
+void O3CoreGraph<W>::countDataMiss(uint32_t ls_cycles)
+{
+    if (ls_cycles > l2dThreshold)
+    {
+        ++l2dMisses;
+    }
+    else if (ls_cycles > l1dThreshold)
+    {
+        ++l1dMisses;
+    }
+}
+
+template <uint32_t W>
+void O3CoreGraph<W>::modelPipeline(Vertex& fetch_vertex, Vertex& dispatch_vertex,
+                                Vertex& execute_vertex, Vertex& mem_vertex,
+                                Vertex& commit_vertex, Instruction* instr,
+                                uint32_t execution_cycles, const InstructionTiming& timing)
+{
+    bool mispredicted;
+    uint32_t fetch_cycles;
+    bool is_load_store = (instr->memLoadCount == 1) || 
+                         (instr->memStoreCount == 1);
+    LaneMask ino_dispatch_lanes = (instrCount % AnalysisWindow == 0) ? 0 : inOrderDispatchLanes;
+    LaneMask ino_commit_lanes = (instrCount % AnalysisWindow == 0) ? 0 : inOrderCommitLanes;
+
+    // Branch prediction
+    mispredicted = bookkeeping.previousInstrMispredicted;
+    bookkeeping.previousInstrMispredicted = timing.mispredicted;
+
+    // Fetch
+    fetch_cycles = timing.fetchCycles;
 
     // Dispatch after fetch
-    OutgoingEdge fetch_after_dispatch(dispatch_vertex, (int64_t)decodeCycles);
+    OutgoingEdge fetch_after_dispatch(dispatch_vertex, decodeCycles);
     //cout << "Dispatch after fetch" << endl;
     addEdge(fetch_vertex, fetch_after_dispatch);
 
     // Execute after dispatch
-    OutgoingEdge execute_after_dispatch(execute_vertex, (int64_t)dispatchCycles);
+    OutgoingEdge execute_after_dispatch(execute_vertex, dispatchCycles);
     //cout << "Execute after dispatch" << endl;
     addEdge(dispatch_vertex, execute_after_dispatch);
 
@@ -581,14 +884,14 @@ void O3CoreGraph::modelPipeline(Vertex& fetch_vertex, Vertex& dispatch_vertex,
     {
         // Memory execute (actual memory operation) after instruction execute (address calculation)
         OutgoingEdge mem_after_instr(mem_vertex,
-            (int64_t)scoreboard[0].getResourceLatency(Resource::RscLsu));
+            (int64_t)scoreboard.getResourceLatency(Resource::RscLsu));
         //cout << "Memory execute after instruction execute" << endl;
         addEdge(execute_vertex, mem_after_instr);
 
         // Commit after execute
         OutgoingEdge commit_after_execute(commit_vertex,
-            (int64_t)(execution_cycles - scoreboard[0].getResourceLatency(Resource::RscLsu) +
-                      executeToCommitCycles));
+            executeToCommitCycles.shifted<W>(
+                (int64_t)execution_cycles - scoreboard.getResourceLatency(Resource::RscLsu)));
         //cout << "Commit after memory execute" << endl;
         addEdge(mem_vertex, commit_after_execute);        
     }
@@ -596,104 +899,121 @@ void O3CoreGraph::modelPipeline(Vertex& fetch_vertex, Vertex& dispatch_vertex,
     {
         // Commit after execute
         OutgoingEdge commit_after_execute(commit_vertex,
-            (int64_t)(execution_cycles + executeToCommitCycles));
+            executeToCommitCycles.shifted<W>(execution_cycles));
         //cout << "Commit after execute" << endl;
         addEdge(execute_vertex, commit_after_execute);
     }
 
-    // Limited fetch bandwidth
-    if ((instrCount % AnalysisWindow >= fetchBandwidth) &&
-        ((lastMisprediction == UINT64_MAX) ||
-         (instrCount - lastMisprediction > fetchBandwidth)))
+    // Limited fetch bandwidth (one edge per distinct bandwidth across the scenarios)
+    for (auto& group : fetchBandwidth)
     {
-        Vertex prev_fetch_vertex(VertexType::InstrFetch, instrCount - fetchBandwidth);
-        OutgoingEdge limited_fetch_bw(fetch_vertex, 1);
-        //cout << "Limited fetch bandwidth" << endl;
-        addEdge(prev_fetch_vertex, limited_fetch_bw);
+        uint32_t fetch_bandwidth = group.first;
+        if ((instrCount % AnalysisWindow >= fetch_bandwidth) &&
+            ((bookkeeping.lastMisprediction == UINT64_MAX) ||
+             (instrCount - bookkeeping.lastMisprediction > fetch_bandwidth)))
+        {
+            Vertex prev_fetch_vertex(VertexType::InstrFetch, instrCount - fetch_bandwidth);
+            OutgoingEdge limited_fetch_bw(fetch_vertex, EdgeWeight::inLanes<W>(1, group.second));
+            //cout << "Limited fetch bandwidth" << endl;
+            addEdge(prev_fetch_vertex, limited_fetch_bw);
+        }
     }
 
     // Limited dispatch bandwidth
-    if ((instrCount % AnalysisWindow >= dispatchBandwidth) &&
-        ((lastMisprediction == UINT64_MAX) ||
-         (instrCount - lastMisprediction > dispatchBandwidth)))
+    for (auto& group : dispatchBandwidth)
     {
-        Vertex prev_dispatch_vertex(VertexType::InstrDispatch, instrCount - dispatchBandwidth);
-        OutgoingEdge limited_dispatch_bw(dispatch_vertex, 1);
-        //cout << "Limited dispatch bandwidth" << endl;
-        addEdge(prev_dispatch_vertex, limited_dispatch_bw);
+        uint32_t dispatch_bandwidth = group.first;
+        if ((instrCount % AnalysisWindow >= dispatch_bandwidth) &&
+            ((bookkeeping.lastMisprediction == UINT64_MAX) ||
+             (instrCount - bookkeeping.lastMisprediction > dispatch_bandwidth)))
+        {
+            Vertex prev_dispatch_vertex(VertexType::InstrDispatch, instrCount - dispatch_bandwidth);
+            OutgoingEdge limited_dispatch_bw(dispatch_vertex,
+                                             EdgeWeight::inLanes<W>(1, group.second));
+            //cout << "Limited dispatch bandwidth" << endl;
+            addEdge(prev_dispatch_vertex, limited_dispatch_bw);
+        }
     }
 
     // Limited commit bandwidth
-    if ((instrCount % AnalysisWindow >= commitBandwidth) &&
-        ((lastMisprediction == UINT64_MAX) ||
-         (instrCount - lastMisprediction > commitBandwidth)))
+    for (auto& group : commitBandwidth)
     {
-        Vertex prev_commit_vertex(VertexType::InstrCommit, instrCount - commitBandwidth);
-        OutgoingEdge limited_commit_bw(commit_vertex, 1);
-        //cout << "Limited commit bandwidth" << endl;
-        addEdge(prev_commit_vertex, limited_commit_bw);
+        uint32_t commit_bandwidth = group.first;
+        if ((instrCount % AnalysisWindow >= commit_bandwidth) &&
+            ((bookkeeping.lastMisprediction == UINT64_MAX) ||
+             (instrCount - bookkeeping.lastMisprediction > commit_bandwidth)))
+        {
+            Vertex prev_commit_vertex(VertexType::InstrCommit, instrCount - commit_bandwidth);
+            OutgoingEdge limited_commit_bw(commit_vertex, EdgeWeight::inLanes<W>(1, group.second));
+            //cout << "Limited commit bandwidth" << endl;
+            addEdge(prev_commit_vertex, limited_commit_bw);
+        }
     }
 
     // Limited memory commit bandwidth
-    if ((lastMemLdSt != UINT64_MAX) &&
-        (instrCount - lastMemLdSt == memCommitBandwidth) &&
-        ((lastMisprediction == UINT64_MAX) ||
-         (instrCount - lastMisprediction > memCommitBandwidth)))
+    if ((bookkeeping.lastMemLdSt != UINT64_MAX) &&
+        (instrCount - bookkeeping.lastMemLdSt == memCommitBandwidth) &&
+        ((bookkeeping.lastMisprediction == UINT64_MAX) ||
+         (instrCount - bookkeeping.lastMisprediction > memCommitBandwidth)))
     {
-        Vertex prev_commit_vertex(VertexType::InstrCommit, lastMemLdSt);
+        Vertex prev_commit_vertex(VertexType::InstrCommit, bookkeeping.lastMemLdSt);
         OutgoingEdge limited_mem_commit_bw(commit_vertex, 1);
         //cout << "Limited memory commit bandwidth" << endl;
         addEdge(prev_commit_vertex, limited_mem_commit_bw);
 
-        no_need_for_ino_commit = no_need_for_ino_commit || ((instrCount - lastMemLdSt) == 1);
+        if ((instrCount - bookkeeping.lastMemLdSt) == 1)
+        {
+            ino_commit_lanes = 0;
+        }
     }
 
     if (mispredicted)
     {
         Vertex prev_branch_vertex(VertexType::InstrExecute, instrCount - 1);
         OutgoingEdge mispredicted_fetch(fetch_vertex,
-            (int64_t)(scoreboard[0].getResourceLatency(Resource::RscIntAlu) +
-                      mispredictionPenalty + fetch_cycles));
+            mispredictionPenalty.shifted<W>(
+                (int64_t)scoreboard.getResourceLatency(Resource::RscIntAlu) + fetch_cycles));
         //cout << "Bad fetch" << endl;
         addEdge(prev_branch_vertex, mispredicted_fetch);
-        lastMisprediction = instrCount - 1;
+        bookkeeping.lastMisprediction = instrCount - 1;
     }
     else
     {
         if (instrCount % AnalysisWindow != 0)
         {
             // In-order fetch
-            uint32_t fetch_weight;
-            //if (previousWasBranch && (instr->pc != linearPC)) // Correctly taken branch
-            if (previousWasBranch)
+            EdgeWeight fetch_weight;
+            //if (bookkeeping.previousWasBranch && (instr->pc != bookkeeping.linearPC)) // Correctly taken branch
+            if (bookkeeping.previousWasBranch)
             {
-                fetch_weight = predictionCycles + fetch_cycles;
+                fetch_weight = predictionCycles.shifted<W>(fetch_cycles);
             }
             else // No branch or correctly not taken branch
             {
-                fetch_weight = fetch_cycles;
+                fetch_weight = EdgeWeight(fetch_cycles);
             }
 
             Vertex prev_fetch_vertex(VertexType::InstrFetch, instrCount - 1);
-            OutgoingEdge in_order_fetch(fetch_vertex, (int64_t)fetch_weight);
+            OutgoingEdge in_order_fetch(fetch_vertex, fetch_weight);
             //cout << "Good fetch" << endl;
             addEdge(prev_fetch_vertex, in_order_fetch);
         }
 
         // In-order dispatch
-        if (!no_need_for_ino_dispatch)
+        if (ino_dispatch_lanes != 0)
         {
             Vertex prev_dispatch_vertex(VertexType::InstrDispatch, instrCount - 1);
-            OutgoingEdge in_order_dispatch(dispatch_vertex, 0);
+            OutgoingEdge in_order_dispatch(dispatch_vertex,
+                                           EdgeWeight::inLanes<W>(0, ino_dispatch_lanes));
             //cout << "In-order dispatch" << endl;
             addEdge(prev_dispatch_vertex, in_order_dispatch);
         }
 
         // In-order commit
-        if (!no_need_for_ino_commit)
+        if (ino_commit_lanes != 0)
         {
             Vertex prev_commit_vertex(VertexType::InstrCommit, instrCount - 1);
-            OutgoingEdge in_order_commit(commit_vertex, 0);
+            OutgoingEdge in_order_commit(commit_vertex, EdgeWeight::inLanes<W>(0, ino_commit_lanes));
             //cout << "In-order commit" << endl;
             addEdge(prev_commit_vertex, in_order_commit);
         }
@@ -720,15 +1040,13 @@ void O3CoreGraph::modelPipeline(Vertex& fetch_vertex, Vertex& dispatch_vertex,
     */
 }
 
-bool O3CoreGraph::modelMemoryOrderConstraint(Instruction* instr, Vertex& mem_vertex)
+template <uint32_t W>
+bool O3CoreGraph<W>::modelMemoryOrderConstraint(Instruction* instr, Vertex& mem_vertex)
 {
     bool store_to_load_forwarding = false;
     uint64_t base;
     uint32_t length;
-    uint32_t index;
     bool is_load = (instr->memLoadCount != 0);
-    uint32_t lq_size = scoreboard[0].getQueueSize(QueueResource::RscLQ);
-    uint32_t sq_size = scoreboard[0].getQueueSize(QueueResource::RscSQ);
 
     if (is_load)
     {
@@ -742,8 +1060,7 @@ bool O3CoreGraph::modelMemoryOrderConstraint(Instruction* instr, Vertex& mem_ver
     }
 
     // Limited memory issue bandwidth
-    index = (ldStWindowPointer + lq_size + sq_size - memIssueBandwidth) % (lq_size + sq_size);
-    uint64_t previous_ld_st_num = ldStWindow[index].first;
+    uint64_t previous_ld_st_num = bookkeeping.ldStByAge(memIssueBandwidth - 1).instrNum;
     if (previous_ld_st_num != UINT64_MAX)
     {
         Vertex prev_mem_vertex(VertexType::MemExecute, previous_ld_st_num);
@@ -753,62 +1070,27 @@ bool O3CoreGraph::modelMemoryOrderConstraint(Instruction* instr, Vertex& mem_ver
         addEdge(prev_mem_vertex, limited_mem_issue_bw);
     }
 
-    // The following loop starts from the youngest load/store before this insturction.
-    // If this instruction is a load, it checks if a store-to-load forwarding edge is needed.
-    // If this instruction is a store, it checks if an edge from the youngest load/store
-    // with a common address is needed.
-    index = (ldStWindowPointer + lq_size + sq_size - 1) % (lq_size + sq_size);
-    for (uint32_t i = 0; i < lq_size + sq_size; ++i)
+    // If this instruction is a load, a store-to-load forwarding edge is needed from the
+    // youngest older store with a common address. If this instruction is a store, an edge
+    // is needed from the youngest older load/store with a common address.
+    const LdStEntry* previous_ld_st = bookkeeping.youngestSharingAddress(base, length, is_load);
+    if (previous_ld_st != NULL)
     {
-        uint64_t previous_ld_st_num = ldStWindow[index].first;
-        if (previous_ld_st_num == UINT64_MAX)
-        {
-            break;
-        }
-
-        pair<uint64_t, uint32_t> previous_ld_st_addr = ldStWindow[index].second;
-        uint64_t prev_base = previous_ld_st_addr.first;
-        uint64_t prev_length = previous_ld_st_addr.second;
-        bool is_prev_load = ldStWindowType[index];
-
-        bool common = ((base >= prev_base) && (base < prev_base + prev_length)) ||
-                      ((base + length > prev_base) && (base + length <= prev_base + prev_length));
-
-        bool needs_edge = false;
-
-        if (common && !is_prev_load && is_load)
-        {
-            needs_edge = true;
-            store_to_load_forwarding = true;
-            //cout << "Store to load forwarding: " << previous_ld_st_num
-            //     << " to " << instrCount << endl;
-        }
-
-        if (common && !is_load)
-        {
-            needs_edge = true;
-            //cout << "Store after load/store from/to same address: " << previous_ld_st_num
-            //     << " to " << instrCount << endl;
-        }
-
-        if (needs_edge)
-        {
-                Vertex prev_mem_vertex(VertexType::MemExecute, previous_ld_st_num);
-                OutgoingEdge limited_mem(mem_vertex, 0);
-                addEdge(prev_mem_vertex, limited_mem);
-                break;
-        }
-
-        index = (index + lq_size + sq_size - 1) % (lq_size + sq_size);
+        store_to_load_forwarding = is_load;
+        //cout << "Memory order (store to load forwarding for loads): "
+        //     << previous_ld_st->instrNum << " to " << instrCount << endl;
+        Vertex prev_mem_vertex(VertexType::MemExecute, previous_ld_st->instrNum);
+        OutgoingEdge limited_mem(mem_vertex, 0);
+        addEdge(prev_mem_vertex, limited_mem);
     }
 
     /*
     if (is_load)
     {
         // Additional constraint: load requests are only sent when they are non-speculative
-        if ((lastBranch != UINT64_MAX) && (instrCount - lastBranch < instrBufferSize))
+        if ((bookkeeping.lastBranch != UINT64_MAX) && (instrCount - bookkeeping.lastBranch < instrBufferSize))
         {
-            Vertex prev_br_vertex(VertexType::InstrCommit, lastBranch);
+            Vertex prev_br_vertex(VertexType::InstrCommit, bookkeeping.lastBranch);
             OutgoingEdge non_speculative_load(mem_vertex, 0);
             addEdge(prev_br_vertex, non_speculative_load);
         }
@@ -826,32 +1108,31 @@ bool O3CoreGraph::modelMemoryOrderConstraint(Instruction* instr, Vertex& mem_ver
     return store_to_load_forwarding;
 }
 
-void O3CoreGraph::trackDataDependencies(Instruction* instr,
+template <uint32_t W>
+void O3CoreGraph<W>::trackDataDependencies(Instruction* instr,
                                         Vertex& execute_vertex, Vertex& mem_vertex)
 {
     // Check for data dependence through registers
     for (uint32_t i = 0; i < instr->regReadCount; ++i)
     {
-        int reg_read = instr->regRead[i];
-        if ((regLastWrittenBy.count(reg_read) != 0) &&
-            (instrCount - regLastWrittenBy[reg_read].first < instrBufferSize))
+        const RegisterProducer& producer = bookkeeping.producer(instr->regRead[i]);
+        if ((producer.instrNum != UINT64_MAX) &&
+            (instrCount - producer.instrNum < instrBufferSize))
         {
             //cout << "Register data dependence: " << instrCount << " to "
-            //     << regLastWrittenBy[reg_read].first << endl;
+            //     << producer.instrNum << endl;
             uint32_t weight; // Not differentiating between address and value registers for stores
-            weight = regLastWrittenBy[reg_read].second;
+            weight = producer.cycles;
   
-            if (regLastWrittenByLoad[reg_read])
+            if (producer.isLoad)
             {
-                Vertex prev_mem_vertex(VertexType::MemExecute,
-                                       regLastWrittenBy[reg_read].first);
+                Vertex prev_mem_vertex(VertexType::MemExecute, producer.instrNum);
                 OutgoingEdge dependence_edge(execute_vertex, (int64_t)weight);
                 addEdge(prev_mem_vertex, dependence_edge);
             }
             else
             {
-                Vertex prev_execute_vertex(VertexType::InstrExecute,
-                                           regLastWrittenBy[reg_read].first);
+                Vertex prev_execute_vertex(VertexType::InstrExecute, producer.instrNum);
                 OutgoingEdge dependence_edge(execute_vertex, (int64_t)weight);
                 addEdge(prev_execute_vertex, dependence_edge);
             }
@@ -859,7 +1140,8 @@ void O3CoreGraph::trackDataDependencies(Instruction* instr,
     }
 }
 
-void O3CoreGraph::modelResourceDependencies()
+template <uint32_t W>
+void O3CoreGraph<W>::modelResourceDependencies()
 {
     // Note: It is OK if there are more than one edge from vertex v1 to
     // vertex v2 even if the edges have positive weights in a scenario.
@@ -867,215 +1149,1523 @@ void O3CoreGraph::modelResourceDependencies()
     // from v2 to v1. But at least one of the corresponing weights in a
     // scenario must be -1; otherwise, a loop is formed.
 
-    for (uint32_t i = 0; i < VECTOR_WIDTH; ++i)
+    // Each range of scenarios is scheduled in one pass (possibly in parallel
+    // with the other ranges), and its edges are added afterwards. Either way,
+    // the edges of each scenario are added in the order they are found.
+    lanePool.run(W, [this](uint32_t part, uint32_t parts)
+    {
+        uint32_t begin, end;
+        ThreadPool::partition(W, part, parts, begin, end);
+        scheduleLanes(begin, end, resourceEdges[part]);
+    });
+
+    VertexHash window_position;
+    uint64_t window_vertices = (windowEnd - analyzedWindows * AnalysisWindow) *
+                               (VertexType::Last + 1);
+    resourceParents.assign(window_vertices, false);
+    for (uint32_t i = 0; i < W; ++i)
+    {
+        laneResourceEdges[i].clear();
+    }
+
+    for (uint32_t i = 0; i < W; ++i)
+    {
+        for (ResourceEdge& resource_edge : resourceEdges[i])
+        {
+            uint32_t parent_position = window_position(resource_edge.parent);
+            if (spilledEdges.isOpen())
+            {
+                spilledResourceEdges.push_back({vertexNumber(resource_edge.parent),
+                                                vertexNumber(resource_edge.child),
+                                                EdgeWeight(resource_edge.weight)});
+            }
+            else
+            {
+                OutgoingEdge e(resource_edge.child, resource_edge.weight);
+                mergeEdge(resource_edge.parent, e);
+
+                uint32_t child_position = window_position(resource_edge.child);
+                for (uint32_t j = 0; j < W; ++j)
+                {
+                    if (resource_edge.weight[j] != WeightVector<W>::ABSENT)
+                    {
+                        laneResourceEdges[j].push_back(make_pair(parent_position, child_position));
+                    }
+                }
+            }
+            resourceParents[parent_position] = true;
+        }
+        resourceEdges[i].clear();
+    }
+
+    // The order in which sweepFinalCriticalPath merges them with the spilled edges
+    sort(spilledResourceEdges.begin(), spilledResourceEdges.end());
+}
+
+template <uint32_t W>
+void O3CoreGraph<W>::scheduleLanes(uint32_t begin, uint32_t end, vector<ResourceEdge>& edges)
+{
+    // All scenarios schedule the same instructions (in their own orders), so
+    // the schedule orders are walked in lockstep, and the scoreboard handles
+    // the i'th instruction of every scenario in one call.
+    // The bookkeeping maps are only read (with at()) here, since other
+    // scenarios may be scheduled at the same time.
+    typename ScheduleSet::iterator next[W];
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        next[i] = scheduleOrder[i].begin();
+    }
+
+    uint64_t curr_instr[W];
+    uint64_t prev_instr[W];
+    int operation_type[W];
+    int lsq_type[W];
+    uint32_t execution_cycles[W];
+    uint32_t ls_cycles[W];
+
+    for (uint64_t step = 0; step < scheduleOrder[begin].size(); ++step)
     {
-        for (auto j = scheduleOrder[i].begin(); j != scheduleOrder[i].end(); ++j)
+        LaneMask lanes = 0;
+
+        for (uint32_t i = begin; i < end; ++i)
         {
-            uint64_t curr_instr = j->first;
-            uint64_t prev_instr;
-            uint32_t wait_cycles;
+            curr_instr[i] = next[i]->first;
+            ++next[i];
 
-            int execution_type = executionType[curr_instr % AnalysisWindow];
-            int operation_type;
-            int lsq_type = -1;
-            switch (execution_type)
+            switch (executionType.at(curr_instr[i] % AnalysisWindow))
             {
                 case ExecutionType::IntBase:
                 case ExecutionType::BranchCond:
                 case ExecutionType::BranchUncond:
-                    operation_type = Resource::RscIntAlu;
+                    operation_type[i] = Resource::RscIntAlu;
                     break;
                 case ExecutionType::IntMul:
-                    operation_type = Resource::RscIntMul;
+                    operation_type[i] = Resource::RscIntMul;
                     break;
                 case ExecutionType::IntDiv:
-                    operation_type = Resource::RscIntDiv;
+                    operation_type[i] = Resource::RscIntDiv;
                     break;
                 case ExecutionType::FpBase:
-                    operation_type = Resource::RscFpAlu;
+                    operation_type[i] = Resource::RscFpAlu;
                     break;
                 case ExecutionType::FpMul:
-                    operation_type = Resource::RscFpMul;
+                    operation_type[i] = Resource::RscFpMul;
                     break;
                 case ExecutionType::FpDiv:
-                    operation_type = Resource::RscFpDiv;
+                    operation_type[i] = Resource::RscFpDiv;
                     break;
                 case ExecutionType::Load:
-                    lsq_type = QueueResource::RscLQ;
-                    operation_type = Resource::RscLsu;
-                    break;
                 case ExecutionType::Store:
-                    lsq_type = QueueResource::RscSQ;
-                    operation_type = Resource::RscLsu;
+                    operation_type[i] = Resource::RscLsu;
                     break;
                 default:
                     continue;
             }
+            lanes |= (LaneMask)1 << i;
 
-            Vertex curr_execute_vertex(VertexType::InstrExecute, curr_instr);
-    
-            // Limited issue bandwidth
-            scoreboard[i].scheduleResource(Resource::RscIssue, curr_instr,
-                                           prev_instr, wait_cycles);
-            if (prev_instr != UINT64_MAX)
+            execution_cycles[i] = executionCycles.at(curr_instr[i] % AnalysisWindow);
+            if (execution_cycles[i] == UINT32_MAX)
             {
-                Vertex prev_execute_vertex(VertexType::InstrExecute, prev_instr);
-                OutgoingEdge limited_issue_bw(curr_execute_vertex, (int64_t)wait_cycles, i);
-                //cout << "Limited issue bandwidth: " << prev_instr
-                //     << " to " << curr_instr << endl;
-                addEdge(prev_execute_vertex, limited_issue_bw);
+                CALIPERS_ERROR("Execution cycles not recorded properly");
             }
+        }
+
+        if (lanes == 0)
+        {
+            continue;
+        }
+
+        // Limited issue bandwidth
+        WeightVector<W> wait_cycles = scoreboard.scheduleResource(Resource::RscIssue, curr_instr,
+                                                                  lanes, prev_instr);
+        addResourceEdges(VertexType::InstrExecute, curr_instr, prev_instr, wait_cycles,
+                         lanes, false, edges);
+
+        // Limited instruction queue size
+        wait_cycles = scoreboard.scheduleQueue(QueueResource::RscInstrQ, curr_instr,
+                                               execution_cycles, lanes, prev_instr);
+        addResourceEdges(VertexType::InstrExecute, curr_instr, prev_instr, wait_cycles,
+                         lanes, false, edges);
+
+        // Limited execution units
+        wait_cycles = scoreboard.scheduleResource(operation_type, curr_instr, lanes, prev_instr);
+        addResourceEdges(VertexType::InstrExecute, curr_instr, prev_instr, wait_cycles,
+                         lanes, true, edges);
+        // TODO: Model structural hazards related to the limited pipeline
+        // length of an execution unit.
+    }
+
+    // Limited load/store queue size
+    // The loads and stores take their entries in the order of their MemExecute
+    // vertices, so every resource edge goes from a vertex to a vertex of the same
+    // type that is not shorter (before scheduling). Together with the edges that
+    // go forward in the window, this keeps the graph of each scenario acyclic.
+    LaneMask lsq_lanes = 0;
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        lsq_lanes |= (LaneMask)1 << i;
+        next[i] = memScheduleOrder[i].begin();
+    }
+
+    for (uint64_t step = 0; step < memScheduleOrder[begin].size(); ++step)
+    {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            curr_instr[i] = next[i]->first;
+            ++next[i];
 
-            // Limited instruction queue size
-            uint32_t execution_cycles = executionCycles[curr_instr % AnalysisWindow];
-            if (execution_cycles == UINT32_MAX)
+            bool is_load = (executionType.at(curr_instr[i] % AnalysisWindow) == ExecutionType::Load);
+            lsq_type[i] = is_load ? QueueResource::RscLQ : QueueResource::RscSQ;
+            ls_cycles[i] = lsCycles.at(curr_instr[i] % AnalysisWindow);
+            if (ls_cycles[i] == UINT32_MAX)
             {
-                CALIPERS_ERROR("Execution cycles not recorded properly");
+                CALIPERS_ERROR("Load/Store cycles not recorded properly");
+            }
+        }
+
+        WeightVector<W> wait_cycles = scoreboard.scheduleQueue(lsq_type, curr_instr, ls_cycles,
+                                                               lsq_lanes, prev_instr);
+        addResourceEdges(VertexType::MemExecute, curr_instr, prev_instr, wait_cycles,
+                         lsq_lanes, true, edges);
+    }
+
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        memScheduleOrder[i].clear();
+    }
+}
+
+template <uint32_t W>
+bool O3CoreGraph<W>::isLoadStore(uint64_t instr_num)
+{
+    int execution_type = executionType.at(instr_num % AnalysisWindow);
+    return (execution_type == ExecutionType::Load) || (execution_type == ExecutionType::Store);
+}
+
+template <uint32_t W>
+void O3CoreGraph<W>::addResourceEdges(int vertex_type, const uint64_t* curr_instr,
+                                      const uint64_t* prev_instr, const WeightVector<W>& wait_cycles,
+                                      LaneMask lanes, bool check_buffer, vector<ResourceEdge>& edges)
+{
+    // The scenarios where the instruction waits for the same previous
+    // instruction share one edge (with the wait cycles of each scenario).
+    LaneMask remaining = 0;
+    for (uint32_t i = 0; i < W; ++i)
+    {
+        if (((lanes >> i) & 1) && (prev_instr[i] != UINT64_MAX) &&
+            (!check_buffer || (unsigned_diff(curr_instr[i], prev_instr[i]) < instrBufferSize)))
+        {
+            remaining |= (LaneMask)1 << i;
+        }
+    }
+
+    while (remaining != 0)
+    {
+        uint32_t first = __builtin_ctzll(remaining);
+        int32_t weights[W];
+        for (uint32_t i = 0; i < W; ++i)
+        {
+            if (((remaining >> i) & 1) &&
+                (curr_instr[i] == curr_instr[first]) && (prev_instr[i] == prev_instr[first]))
+            {
+                weights[i] = wait_cycles[i];
+                remaining &= ~((LaneMask)1 << i);
             }
-            scoreboard[i].scheduleQueue(QueueResource::RscInstrQ, curr_instr, execution_cycles,
-                                        prev_instr, wait_cycles);
-            if (prev_instr != UINT64_MAX)
+            else
             {
-                Vertex prev_execute_vertex(VertexType::InstrExecute, prev_instr);
-                OutgoingEdge limited_instr_queue(curr_execute_vertex, (int64_t)wait_cycles, i);
-                //cout << "Limited instruction queue size: " << prev_instr
-                //     << " to " << curr_instr << endl;
-                addEdge(prev_execute_vertex, limited_instr_queue);
+                weights[i] = WeightVector<W>::ABSENT;
             }
+        }
+
+        //cout << "Resource dependence of " << curr_instr[first]
+        //     << " to " << prev_instr[first] << endl;
+        edges.push_back({Vertex(vertex_type, prev_instr[first]),
+                         Vertex(vertex_type, curr_instr[first]),
+                         WeightVector<W>(weights, W)});
+    }
+}
+
+template <uint32_t W>
+void O3CoreGraph<W>::addEdge(Vertex& parent, OutgoingEdge& e)
+{
+    //printEdge(parent, e);
+
+    ++addedEdges;
+    if (spilledEdges.isOpen())
+    {
+        spilledEdges.push_back({vertexNumber(parent), vertexNumber(e.child), e.weight});
+        return;
+    }
+
+    nextGraph[parent].push_back(e);
+
+    nextGraph[e.child]; // Just to be added to the graph if it is the last commit
+}
 
-            // Limited execution units
-            scoreboard[i].scheduleResource(operation_type, curr_instr,
-                                           prev_instr, wait_cycles);
+template <uint32_t W>
+void O3CoreGraph<W>::mergeEdge(Vertex& parent, OutgoingEdge& e)
+{
+    // Same as addEdge for the window being analyzed, but an edge to the same child
+    // is merged into the existing edge instead (see compactGraph)
+    VertexHash window_position;
+    VertexEqual same_vertex;
+    vector<OutgoingEdge>& edges = graph[parent];
+    windowChildren[window_position(parent)] = &edges;
+    for (OutgoingEdge& existing : edges)
+    {
+        if (same_vertex(existing.child, e.child))
+        {
+            existing.weight = existing.weight.template merged<W>(e.weight);
+            ++addedResourceEdges;
+            ++removedEdges;
+            return;
+        }
+    }
+
+    ++addedResourceEdges;
+    edges.push_back(e);
+    graph[e.child];
+}
+
+template <uint32_t W>
+void O3CoreGraph<W>::compactGraph()
+{
+    // Parallel edges are merged into one edge with the lane-wise maximum weight,
+    // and an edge u->v is dropped if a path u->x->v is strictly longer in every
+    // scenario the edge exists in. Edges are classified by the types of their
+    // endpoints, so a merged edge sets the same lengths and breakdowns, and a
+    // dropped edge could never set the length of its child. Ties are broken by
+    // the positions of the parents (see takesOver), so the order of the edges
+    // does not matter either.
+    // Linear fetch->dispatch chains are not contracted: a contracted edge would
+    // mix fetch and decode cycles in the breakdown, and few fetch vertices have
+    // a single parent and a single child.
+    VertexHash window_position;
+    VertexEqual same_vertex;
+    uint64_t window_vertices = (windowEnd - analyzedWindows * AnalysisWindow) *
+                               (VertexType::Last + 1);
+
+    windowChildren.assign(window_vertices, NULL);
+    for (auto& entry : graph)
+    {
+        uint64_t n = window_position(entry.first);
+        if (n < window_vertices)
+        {
+            windowChildren[n] = &entry.second;
+        }
+    }
 
-            if ((prev_instr != UINT64_MAX) &&
-                (unsigned_diff(curr_instr, prev_instr) < instrBufferSize))
+    // The in-order fetch edges form chains (broken by mispredictions), and the
+    // smallest weight of each edge bounds the path along a chain from below in
+    // all scenarios. This proves most of the limited fetch bandwidth edges
+    // dominated, which two-edge paths cannot.
+    uint64_t window_start = analyzedWindows * AnalysisWindow;
+    uint64_t window_instrs = window_vertices / (VertexType::Last + 1);
+    vector<int64_t> fetch_distance(window_instrs, 0);
+    vector<uint64_t> chain_start(window_instrs, 0);
+    for (uint64_t j = 1; j < window_instrs; ++j)
+    {
+        Vertex fetch_vertex(VertexType::InstrFetch, window_start + j);
+        vector<OutgoingEdge>* fetch_edges =
+            windowChildren[(j - 1) * (VertexType::Last + 1) + VertexType::InstrFetch];
+        chain_start[j] = j;
+        for (uint32_t k = 0; (fetch_edges != NULL) && (k < fetch_edges->size()); ++k)
+        {
+            OutgoingEdge& e = (*fetch_edges)[k];
+            if (same_vertex(e.child, fetch_vertex) &&
+                (e.weight.template presentLanes<W>() == allLanes<W>()))
             {
-                Vertex prev_execute_vertex(VertexType::InstrExecute, prev_instr);
-                OutgoingEdge limited_resource(curr_execute_vertex, (int64_t)wait_cycles, i);
-                //cout << "Resource dependence of " << curr_instr
-                //     << " to " << prev_instr << endl;
-                addEdge(prev_execute_vertex, limited_resource);
+                fetch_distance[j] = fetch_distance[j - 1] + e.weight.template minimum<W>();
+                chain_start[j] = chain_start[j - 1];
+                break;
             }
-            // TODO: Model structural hazards related to the limited pipeline
-            // length of an execution unit.
+        }
+    }
+
+    vector<bool> dominated;
+    regularEdgeCount.assign(window_vertices, 0);
+    regularInDegree.assign(window_vertices, 0);
+    for (uint64_t n = 0; n < window_vertices; ++n)
+    {
+        if (windowChildren[n] == NULL)
+        {
+            continue;
+        }
+        vector<OutgoingEdge>& edges = *windowChildren[n];
 
-            // Limited load/store queue size
-            if (lsq_type != -1)
+        uint32_t kept = 0;
+        for (uint32_t k = 0; k < edges.size(); ++k)
+        {
+            uint32_t j = 0;
+            while ((j < kept) && !same_vertex(edges[j].child, edges[k].child))
             {
-                uint32_t ls_cycles = lsCycles[curr_instr % AnalysisWindow];
-                if (ls_cycles == UINT32_MAX)
-                {
-                    CALIPERS_ERROR("Load/Store cycles not recorded properly");
-                }
-                scoreboard[i].scheduleQueue(lsq_type, curr_instr, ls_cycles,
-                                            prev_instr, wait_cycles);
-                if ((prev_instr != UINT64_MAX) &&
-                    (unsigned_diff(curr_instr, prev_instr) < instrBufferSize))
+                ++j;
+            }
+            if (j < kept)
+            {
+                OutgoingEdge parallel_edge = edges[j];
+                parallel_edge.weight = parallel_edge.weight.template merged<W>(edges[k].weight);
+                for (; j + 1 < kept; ++j)
                 {
-                    Vertex curr_mem_vertex(VertexType::MemExecute, curr_instr);
-                    Vertex prev_mem_vertex(VertexType::MemExecute, prev_instr);
-                    OutgoingEdge limited_lsq(curr_mem_vertex, (int64_t)wait_cycles, i);
-                    //cout << "Limited load/store queue size: " << prev_instr
-                    //     << " to " << curr_instr << endl;
-                    addEdge(prev_mem_vertex, limited_lsq);
+                    edges[j] = edges[j + 1];
                 }
+                edges[kept - 1] = parallel_edge;
+            }
+            else
+            {
+                edges[kept++] = edges[k];
             }
         }
-    }
-}
 
-void O3CoreGraph::addEdge(Vertex& parent, OutgoingEdge& e)
-{
-    //printEdge(parent, e);
+        // The paths through the other children of the vertex
+        dominated.assign(kept, false);
+        for (uint32_t k = 0; k < kept; ++k)
+        {
+            if ((n % (VertexType::Last + 1) == VertexType::InstrFetch) &&
+                (edges[k].child.type == VertexType::InstrFetch))
+            {
+                uint64_t first = n / (VertexType::Last + 1);
+                uint64_t last = edges[k].child.instrNum - window_start;
+                if ((last > first + 1) && (chain_start[last] <= first) &&
+                    (fetch_distance[last] - fetch_distance[first] >
+                     edges[k].weight.template maximum<W>()))
+                {
+                    dominated[k] = true;
+                    continue;
+                }
+            }
 
-    graph[parent].push_back(e);
+            LaneMask present = edges[k].weight.template presentLanes<W>();
+            LaneMask longer = 0;
+            for (uint32_t j = 0; (j < kept) && (longer != present); ++j)
+            {
+                vector<OutgoingEdge>* grandchildren = windowChildren[window_position(edges[j].child)];
+                if ((j == k) || (grandchildren == NULL))
+                {
+                    continue;
+                }
+                for (OutgoingEdge& e : *grandchildren)
+                {
+                    if (same_vertex(e.child, edges[k].child))
+                    {
+                        longer |= edges[k].weight.template shorterThanPath<W>(
+                            edges[j].weight, e.weight, present);
+                    }
+                }
+            }
+            dominated[k] = (present != 0) && (longer == present);
+        }
 
-    graph[e.child]; // Just to be added to the graph if it is the last commit
+        uint32_t remaining = 0;
+        for (uint32_t k = 0; k < kept; ++k)
+        {
+            if (!dominated[k])
+            {
+                ++regularInDegree[window_position(edges[k].child)];
+                edges[remaining++] = edges[k];
+            }
+        }
+        removedEdges += edges.size() - remaining;
+        edges.erase(edges.begin() + remaining, edges.end());
+        regularEdgeCount[n] = remaining;
+    }
 }
 
-void O3CoreGraph::calculateCriticalPathForScheduling()
+template <uint32_t W>
+void O3CoreGraph<W>::calculateCriticalPathForScheduling()
 {
     CALIPERS_INFO("Calculating critical path of window " << analyzedWindows 
                   << " for instrcution scheduling...");
 
-    // These two for-loops traverse vertices in an obvious topological order
-    for (uint64_t i = analyzedWindows * AnalysisWindow; i < instrCount; ++i)
+    // These two for-loops traverse vertices in an obvious topological order,
+    // relaxing the edges into each vertex in the order of their parents
+    uint64_t window_vertices = (windowEnd - analyzedWindows * AnalysisWindow) *
+                               (VertexType::Last + 1);
+    resetCriticalParents(window_vertices);
+    VertexHash window_position;
+    uint64_t n = 0;
+    for (uint64_t i = analyzedWindows * AnalysisWindow; i < windowEnd; ++i)
     {
-        for (int j = 0; j <= VertexType::Last; ++j)
+        for (int j = 0; j <= VertexType::Last; ++j, ++n)
         {
             Vertex parent(j, i);
 
             if (j == VertexType::InstrExecute)
             {
-                for (uint32_t k = 0; k < VECTOR_WIDTH; ++k)
+                for (uint32_t k = 0; k < W; ++k)
+                {
+                    scheduleOrder[k].insert(i, absoluteLength(parent, k));
+                }
+            }
+            else if ((j == VertexType::MemExecute) && isLoadStore(i))
+            {
+                for (uint32_t k = 0; k < W; ++k)
                 {
-                    scheduleOrder[k].emplace_hint(scheduleOrder[k].cend(),
-                                                  pair<uint64_t, int64_t>(i, length[parent][k]));
+                    memScheduleOrder[k].insert(i, absoluteLength(parent, k));
                 }
             }
-            // It is also possible to consider a different order for MemExecute vertices.
 
-            for (uint32_t k = 0; k < graph[parent].size(); ++k)
+            if (windowChildren[n] == NULL)
+            {
+                continue;
+            }
+            for (OutgoingEdge& e : *windowChildren[n])
             {
-                OutgoingEdge& e = graph[parent][k];
-                updateCriticalPathCycles(parent, e);
+                LaneMask lanes = updateCriticalPathCycles(parent, e);
+                recordCriticalParents(lanes, n, window_position(e.child));
             }
         }
     }
 }
 
-void O3CoreGraph::calculateFinalCriticalPath()
+template <uint32_t W>
+void O3CoreGraph<W>::calculateFinalCriticalPath()
 {
     CALIPERS_INFO("Calculating final critical path of window " << analyzedWindows << "...");
 
-    /*
-    // First, update critical path information of InstrExecute vertices
-    for (uint32_t i = 0; i < VECTOR_WIDTH; ++i)
+    // Scheduling only adds edges between InstrExecute (or MemExecute) vertices,
+    // but the new lengths can reach any later vertex. The vertices are visited
+    // in a topological order of each scenario, which makes one pass exact.
+    // The lengths are already final for the edges that existed before
+    // scheduling, so only the vertices that changed (got longer or took
+    // another critical parent) or have a resource edge need their edges relaxed.
+    // Ties are broken by the positions of the parents (see takesOver), so the
+    // lengths and breakdowns do not depend on the order of the edges, i.e., on
+    // compaction, on the other scenarios of a sweep, or on the threads.
+    uint64_t window_vertices = (windowEnd - analyzedWindows * AnalysisWindow) *
+                               (VertexType::Last + 1);
+    indexWindowEdges(window_vertices);
+
+    if (lanePool.size() > 1)
+    {
+        calculateFinalCriticalPathThreaded(window_vertices);
+        return;
+    }
+
+    uint64_t window_start = analyzedWindows * AnalysisWindow;
+    vector<uint32_t> order;
+    vector<bool> changed;
+    for (uint32_t i = 0; i < W; ++i)
     {
-        for (auto j = scheduleOrder[i].begin(); j != scheduleOrder[i].end(); ++j)
+        topologicalOrder(i, window_vertices, order);
+        changed.assign(window_vertices, false);
+        if (lazyBreakdown)
         {
-            Vertex parent(VertexType::InstrExecute, j->first);
-            for (uint32_t k = 0; k < graph[parent].size(); ++k)
+            firstPassRecord[i] = predecessorLog[i].size();
+        }
+        for (uint32_t n : order)
+        {
+            if (!changed[n] && !resourceParents[n])
+            {
+                continue;
+            }
+
+            // The entries of the parent are looked up once for all its edges
+            Vertex parent(n % (VertexType::Last + 1), window_start + n / (VertexType::Last + 1));
+            VertexEntries parent_entries = vertexEntries(parent);
+            int parent_execution_type = vertexExecutionType(parent);
+            for (uint32_t k = windowEdgeBegin[n]; k < windowEdgeBegin[n + 1]; ++k)
             {
-                OutgoingEdge& e = graph[parent][k];
-                updateCriticalPathCycles(parent, e);
+                OutgoingEdge& e = *windowEdges[k];
+                int32_t weight = e.weight[i];
+                if (weight == EdgeWeight::ABSENT)
+                {
+                    continue;
+                }
+
+                uint32_t child_position = windowEdgeChild[k];
+                VertexEntries child_entries = vertexEntries(e.child);
+                uint32_t child_record = lazyBreakdown ? child_entries.predecessors->record[i] : 0;
+                if (!takesOver((*parent_entries.length)[i] + weight, n, (*child_entries.length)[i],
+                               criticalParentOf(i, child_position, child_record)))
+                {
+                    continue;
+                }
+
+                if (W == 1)
+                {
+                    updateCriticalPathCycles(parent, e.child, parent_execution_type, e.weight,
+                                             parent_entries, child_entries);
+                }
+                else
+                {
+                    EdgeWeight lane_weight((int64_t)weight, i);
+                    updateCriticalPathCycles(parent, e.child, parent_execution_type, lane_weight,
+                                             parent_entries, child_entries);
+                }
+                recordCriticalParents((LaneMask)1 << i, n, child_position);
+                changed[child_position] = true;
             }
         }
         scheduleOrder[i].clear();
     }
+}
+
+template <uint32_t W>
+bool O3CoreGraph<W>::takesOver(int32_t length, uint32_t parent_position,
+                               int32_t child_length, int64_t critical_parent)
+{
+    // Whether a path of the given length through the parent at parent_position takes
+    // over a child of child_length, whose critical parent is at critical_parent.
+    // Longer paths win, and ties go to the parent latest in the window, which is
+    // the one that calculateCriticalPathForScheduling relaxes last.
+    return (length > child_length) ||
+           ((length == child_length) && ((int64_t)parent_position >= critical_parent));
+}
+
+template <uint32_t W>
+int64_t O3CoreGraph<W>::criticalParentOf(uint32_t idx, uint32_t position, uint32_t record)
+{
+    // The position of the critical parent of the vertex at position in scenario idx
+    // (-1 if none), given its record with lazy breakdowns
+    if (lazyBreakdown)
+    {
+        return (record == 0) ? -1 : (int64_t)position - predecessorLog[idx][record].parentDistance;
+    }
+    uint32_t parent_position = criticalParent[idx][position];
+    return (parent_position == UINT32_MAX) ? -1 : (int64_t)parent_position;
+}
+
+template <uint32_t W>
+void O3CoreGraph<W>::recordCriticalParents(LaneMask lanes, uint32_t parent_position,
+                                           uint32_t child_position)
+{
+    // The records of predecessorLog keep the critical parents with lazy breakdowns
+    for (; !lazyBreakdown && (lanes != 0); lanes &= lanes - 1)
+    {
+        criticalParent[__builtin_ctzll(lanes)][child_position] = parent_position;
+    }
+}
+
+template <uint32_t W>
+void O3CoreGraph<W>::resetCriticalParents(uint64_t window_vertices)
+{
+    for (uint32_t i = 0; !lazyBreakdown && (i < W); ++i)
+    {
+        criticalParent[i].assign(window_vertices, UINT32_MAX);
+    }
+}
+
+template <uint32_t W>
+void O3CoreGraph<W>::indexWindowEdges(uint64_t window_vertices)
+{
+    // The vertices are indexed by their positions in the window (their hashes)
+    VertexHash window_position;
+
+    windowEdgeBegin.assign(window_vertices + 1, 0);
+    for (uint64_t n = 0; n < window_vertices; ++n)
+    {
+        uint32_t edge_count = (windowChildren[n] == NULL) ? 0 : windowChildren[n]->size();
+        windowEdgeBegin[n + 1] = windowEdgeBegin[n] + edge_count;
+    }
 
-    // Then, update critical path information of MemExecute and InstrCommit vertices
-    for (uint64_t i = analyzedWindows * AnalysisWindow; i < instrCount; ++i)
+    windowEdges.resize(windowEdgeBegin[window_vertices]);
+    windowEdgeChild.resize(windowEdgeBegin[window_vertices]);
+    for (uint64_t n = 0; n < window_vertices; ++n)
     {
-        for (int j = VertexType::MemExecute; j <= VertexType::Last; ++j)
+        uint32_t k = windowEdgeBegin[n];
+        for (uint32_t e = 0; k < windowEdgeBegin[n + 1]; ++e, ++k)
         {
-            Vertex parent(j, i);
+            windowEdges[k] = &(*windowChildren[n])[e];
+            windowEdgeChild[k] = window_position(windowEdges[k]->child);
+        }
+    }
+}
+
+template <uint32_t W>
+void O3CoreGraph<W>::topologicalOrder(uint32_t idx, uint64_t window_vertices,
+                                      vector<uint32_t>& order)
+{
+    // Kahn's algorithm over the edges that existed before scheduling (in all
+    // scenarios, see regularInDegree) and the resource edges of scenario idx.
+    // The former are only read as child positions, without their weights.
+    // The resource edges are grouped by parent with a counting sort
+    vector<pair<uint32_t, uint32_t>>& resource_edges = laneResourceEdges[idx];
+    vector<uint32_t> in_degree(regularInDegree);
+    vector<uint32_t> resource_begin(window_vertices + 1, 0);
+    for (pair<uint32_t, uint32_t>& e : resource_edges)
+    {
+        ++resource_begin[e.first + 1];
+        ++in_degree[e.second];
+    }
+    for (uint32_t n = 0; n < window_vertices; ++n)
+    {
+        resource_begin[n + 1] += resource_begin[n];
+    }
+    vector<uint32_t> resource_child(resource_edges.size());
+    for (pair<uint32_t, uint32_t>& e : resource_edges)
+    {
+        resource_child[resource_begin[e.first]++] = e.second;
+    }
+    for (uint32_t n = window_vertices; n > 0; --n)
+    {
+        resource_begin[n] = resource_begin[n - 1];
+    }
+    resource_begin[0] = 0;
 
-            for (uint32_t k = 0; k < graph[parent].size(); ++k)
+    order.clear();
+    for (uint32_t n = 0; n < window_vertices; ++n)
+    {
+        if (in_degree[n] == 0)
+        {
+            order.push_back(n);
+        }
+    }
+    for (uint64_t head = 0; head < order.size(); ++head)
+    {
+        uint32_t n = order[head];
+        for (uint32_t k = windowEdgeBegin[n]; k < windowEdgeBegin[n] + regularEdgeCount[n]; ++k)
+        {
+            if (--in_degree[windowEdgeChild[k]] == 0)
+            {
+                order.push_back(windowEdgeChild[k]);
+            }
+        }
+        for (uint32_t r = resource_begin[n]; r < resource_begin[n + 1]; ++r)
+        {
+            if (--in_degree[resource_child[r]] == 0)
             {
-                OutgoingEdge& e = graph[parent][k];
-                updateCriticalPathCycles(parent, e);
+                order.push_back(resource_child[r]);
             }
         }
     }
-    */
 
-    // The following traversal may result in somewhat approximate updates.
-    // BTW, what was the problem of the above traversal?
-    for (uint32_t i = 0; i < VECTOR_WIDTH; ++i)
+    // The resource edges follow the lengths of their vertices (see scheduleLanes),
+    // so all the vertices are ordered
+    if (order.size() != window_vertices)
+    {
+        CALIPERS_ERROR("The graph of scenario " << idx << " has a cycle");
+    }
+}
+
+template <uint32_t W>
+void O3CoreGraph<W>::calculateFinalCriticalPathThreaded(uint64_t window_vertices)
+{
+    // Same traversal as calculateFinalCriticalPath (with lazy breakdowns),
+    // where the scenarios (or the segments of each scenario, if there are fewer
+    // scenarios than threads) are partitioned across the threads.
+    // The threads only look up the vertices and write to their own scenarios
+    for (uint64_t i = analyzedWindows * AnalysisWindow; i < windowEnd; ++i)
+    {
+        for (int j = 0; j <= VertexType::Last; ++j)
+        {
+            Vertex v(j, i);
+            length[v];
+            criticalPredecessors[v];
+        }
+    }
+
+    for (uint32_t i = 0; i < W; ++i)
+    {
+        laneLength[i].assign(window_vertices, 0);
+        laneRecord[i].assign(window_vertices, 0);
+    }
+    lanePool.run(lanePool.size(), [&](uint32_t part, uint32_t parts)
+    {
+        gatherLanes(part, parts, window_vertices);
+    });
+
+    if (W >= lanePool.size())
     {
-        for (auto j = scheduleOrder[i].begin(); j != scheduleOrder[i].end(); ++j)
+        lanePool.run(W, [&](uint32_t part, uint32_t parts)
         {
-            for (int k = VertexType::InstrExecute; k <= VertexType::Last; ++k)
+            uint32_t begin, end;
+            ThreadPool::partition(W, part, parts, begin, end);
+            for (uint32_t i = begin; i < end; ++i)
             {
-                Vertex parent(k, j->first);
-                for (uint32_t l = 0; l < graph[parent].size(); ++l)
-                {
-                    OutgoingEdge& e = graph[parent][l];
-                    updateCriticalPathCycles(parent, e);
-                }
+                calculateLaneCriticalPath(i, window_vertices);
             }
+        });
+    }
+    else
+    {
+        for (uint32_t i = 0; i < W; ++i)
+        {
+            calculateSegmentedCriticalPath(i, window_vertices);
         }
-        scheduleOrder[i].clear();
     }
+
+    lanePool.run(lanePool.size(), [&](uint32_t part, uint32_t parts)
+    {
+        scatterLanes(part, parts, window_vertices);
+    });
 }
+
+template <uint32_t W>
+void O3CoreGraph<W>::calculateLaneCriticalPath(uint32_t idx, uint64_t window_vertices)
+{
+    vector<int32_t>& lane_length = laneLength[idx];
+    vector<uint32_t>& lane_record = laneRecord[idx];
+
+    vector<uint32_t> order;
+    topologicalOrder(idx, window_vertices, order);
+    vector<bool> changed(window_vertices, false);
+    uint32_t first_record = predecessorLog[idx].size(); // See firstPassRecord
+    for (uint32_t n : order)
+    {
+        if (!changed[n] && !resourceParents[n])
+        {
+            continue;
+        }
+
+        for (uint32_t k = windowEdgeBegin[n]; k < windowEdgeBegin[n + 1]; ++k)
+        {
+            int32_t weight = windowEdges[k]->weight[idx];
+            if (weight == EdgeWeight::ABSENT)
+            {
+                continue;
+            }
+
+            uint32_t child_position = windowEdgeChild[k];
+            if (takesOver(lane_length[n] + weight, n, lane_length[child_position],
+                          criticalParentOf(idx, child_position, lane_record[child_position])))
+            {
+                changed[child_position] = true;
+                lane_length[child_position] = lane_length[n] + weight;
+
+                // Positions and vertex numbers differ by the same offset
+                PredecessorRecord record = {(int32_t)(child_position - n), lane_record[n], weight};
+                if (lane_record[child_position] >= first_record)
+                {
+                    predecessorLog[idx][lane_record[child_position]] = record;
+                    continue;
+                }
+                if (predecessorLog[idx].size() == UINT32_MAX)
+                {
+                    CALIPERS_ERROR("Predecessor log overflow");
+                }
+                lane_record[child_position] = predecessorLog[idx].size();
+                predecessorLog[idx].push_back(record);
+            }
+        }
+    }
+    scheduleOrder[idx].clear();
+}
+
+template <uint32_t W>
+void O3CoreGraph<W>::calculateSegmentedCriticalPath(uint32_t idx, uint64_t window_vertices)
+{
+    topologicalOrder(idx, window_vertices, segmentOrder);
+    segmentRank.resize(window_vertices);
+    for (uint32_t r = 0; r < segmentOrder.size(); ++r)
+    {
+        segmentRank[segmentOrder[r]] = r;
+    }
+    boundaryLength.resize(window_vertices);
+
+    uint32_t segments = lanePool.size();
+    windowSegments.assign(segments, WindowSegment());
+    for (uint32_t s = 0; s < segments; ++s)
+    {
+        ThreadPool::partition(segmentOrder.size(), s, segments,
+                              windowSegments[s].begin, windowSegments[s].end);
+    }
+
+    // Edges only go forward in the topological order, i.e., to later segments
+    lanePool.run(segments, [&](uint32_t part, uint32_t)
+    {
+        WindowSegment& segment = windowSegments[part];
+        for (uint32_t r = segment.begin; r < segment.end; ++r)
+        {
+            uint32_t n = segmentOrder[r];
+            for (uint32_t k = windowEdgeBegin[n]; k < windowEdgeBegin[n + 1]; ++k)
+            {
+                if ((windowEdges[k]->weight[idx] != EdgeWeight::ABSENT) &&
+                    (segmentRank[windowEdgeChild[k]] >= segment.end))
+                {
+                    segment.crossingEdges.push_back({n, k});
+                }
+            }
+        }
+    });
+
+    lanePool.run(segments, [&](uint32_t part, uint32_t)
+    {
+        summarizeSegment(idx, windowSegments[part]);
+    });
+
+    for (WindowSegment& segment : windowSegments)
+    {
+        combineSegment(idx, segment);
+    }
+
+    lanePool.run(segments, [&](uint32_t part, uint32_t)
+    {
+        fillSegment(idx, windowSegments[part]);
+    });
+
+    // The new records are appended to the log in the order of the segments
+    uint64_t records = predecessorLog[idx].size();
+    vector<uint32_t> first_record(segments);
+    for (uint32_t s = 0; s < segments; ++s)
+    {
+        first_record[s] = records;
+        records += windowSegments[s].records.size();
+    }
+    if (records > UINT32_MAX)
+    {
+        CALIPERS_ERROR("Predecessor log overflow");
+    }
+    predecessorLog[idx].resize(records);
+
+    lanePool.run(segments, [&](uint32_t part, uint32_t)
+    {
+        WindowSegment& segment = windowSegments[part];
+        for (uint32_t r = segment.begin; r < segment.end; ++r)
+        {
+            if (segment.renewed[r - segment.begin])
+            {
+                laneRecord[idx][segmentOrder[r]] += first_record[part];
+            }
+        }
+    });
+
+    lanePool.run(segments, [&](uint32_t part, uint32_t)
+    {
+        WindowSegment& segment = windowSegments[part];
+        for (uint32_t k = 0; k < segment.records.size(); ++k)
+        {
+            PredecessorRecord& record = segment.records[k];
+            record.parentRecord = laneRecord[idx][record.parentRecord];
+            predecessorLog[idx][first_record[part] + k] = record;
+        }
+    });
+
+    windowSegments.clear();
+    scheduleOrder[idx].clear();
+}
+
+template <uint32_t W>
+void O3CoreGraph<W>::summarizeSegment(uint32_t idx, WindowSegment& segment)
+{
+    // The edges into the segment are the edges out of the earlier segments into it
+    for (WindowSegment& other : windowSegments)
+    {
+        if (&other == &segment)
+        {
+            break;
+        }
+        for (const pair<uint32_t, uint32_t>& edge : other.crossingEdges)
+        {
+            uint32_t r = segmentRank[windowEdgeChild[edge.second]];
+            if ((r >= segment.begin) && (r < segment.end))
+            {
+                segment.incomingEdges.push_back(edge);
+                segment.columns.push_back(edge.first);
+            }
+        }
+    }
+    sort(segment.columns.begin(), segment.columns.end());
+    segment.columns.erase(unique(segment.columns.begin(), segment.columns.end()),
+                          segment.columns.end());
+    uint32_t width = segment.columns.size();
+
+    vector<pair<uint32_t, uint32_t>> entries;
+    // <Rank of the child, Index in incomingEdges>, sorted
+    for (uint32_t k = 0; k < segment.incomingEdges.size(); ++k)
+    {
+        entries.push_back({segmentRank[windowEdgeChild[segment.incomingEdges[k].second]], k});
+    }
+    sort(entries.begin(), entries.end());
+
+    // Each vertex has a row of the longest paths from the columns from when one of
+    // its parents (or the edges into the segment) reaches it until its edges are relaxed
+    vector<int32_t> local_length(segment.end - segment.begin);
+    vector<int32_t> row_of(segment.end - segment.begin, -1);
+    vector<int32_t> rows;
+    vector<int32_t> free_rows;
+    auto reach = [&](uint32_t offset)
+    {
+        if (row_of[offset] >= 0)
+        {
+            return;
+        }
+        if (free_rows.empty())
+        {
+            row_of[offset] = rows.size() / width;
+            rows.resize(rows.size() + width, Unreachable);
+        }
+        else
+        {
+            row_of[offset] = free_rows.back();
+            free_rows.pop_back();
+            fill(&rows[row_of[offset] * width], &rows[row_of[offset] * width] + width, Unreachable);
+        }
+    };
+
+    for (uint32_t r = segment.begin; r < segment.end; ++r)
+    {
+        local_length[r - segment.begin] = laneLength[idx][segmentOrder[r]];
+    }
+
+    uint32_t next_entry = 0;
+    for (uint32_t r = segment.begin; r < segment.end; ++r)
+    {
+        uint32_t n = segmentOrder[r];
+        uint32_t offset = r - segment.begin;
+
+        for (; (next_entry < entries.size()) && (entries[next_entry].first == r); ++next_entry)
+        {
+            const pair<uint32_t, uint32_t>& edge = segment.incomingEdges[entries[next_entry].second];
+            uint32_t column = lower_bound(segment.columns.begin(), segment.columns.end(),
+                                          edge.first) - segment.columns.begin();
+            reach(offset);
+            int32_t& path = rows[row_of[offset] * width + column];
+            path = max(path, (int32_t)windowEdges[edge.second]->weight[idx]);
+        }
+
+        bool leaves = false;
+        for (uint32_t k = windowEdgeBegin[n]; k < windowEdgeBegin[n + 1]; ++k)
+        {
+            int32_t weight = windowEdges[k]->weight[idx];
+            if (weight == EdgeWeight::ABSENT)
+            {
+                continue;
+            }
+
+            uint32_t child_rank = segmentRank[windowEdgeChild[k]];
+            if (child_rank >= segment.end)
+            {
+                leaves = true;
+                continue;
+            }
+
+            uint32_t child_offset = child_rank - segment.begin;
+            local_length[child_offset] = max(local_length[child_offset],
+                                             local_length[offset] + weight);
+            if (row_of[offset] >= 0)
+            {
+                reach(child_offset);
+                kernels::maxPlusRow(&rows[row_of[child_offset] * width],
+                                    &rows[row_of[offset] * width], weight, Unreachable, width);
+            }
+        }
+
+        if (leaves)
+        {
+            segment.outVertices.push_back(n);
+            segment.outLength.push_back(local_length[offset]);
+            if (row_of[offset] >= 0)
+            {
+                segment.summary.insert(segment.summary.end(), &rows[row_of[offset] * width],
+                                       &rows[row_of[offset] * width] + width);
+            }
+            else
+            {
+                segment.summary.insert(segment.summary.end(), width, Unreachable);
+            }
+        }
+        if (row_of[offset] >= 0)
+        {
+            free_rows.push_back(row_of[offset]);
+        }
+    }
+}
+
+template <uint32_t W>
+void O3CoreGraph<W>::combineSegment(uint32_t idx, WindowSegment& segment)
+{
+    // boundaryLength is final for the earlier segments, and laneLength still has
+    // the lengths from before this pass. The segments are combined in order: each
+    // takes a matrix-vector product of a few hundred rows and columns, while a
+    // parallel prefix would compose the matrices (a cubic product per step).
+    vector<int32_t>& lane_length = laneLength[idx];
+    uint32_t width = segment.columns.size();
+
+    for (uint32_t o = 0; o < segment.outVertices.size(); ++o)
+    {
+        int32_t out_length = segment.outLength[o];
+        const int32_t* row = segment.summary.data() + o * width;
+        for (uint32_t c = 0; c < width; ++c)
+        {
+            if (row[c] != Unreachable)
+            {
+                out_length = max(out_length, boundaryLength[segment.columns[c]] + row[c]);
+            }
+        }
+        boundaryLength[segment.outVertices[o]] = out_length;
+    }
+
+    // The edges into the segment are relaxed before the edges inside the segment.
+    // Whether their parents changed is only known once the earlier segments are
+    // filled, so all of them are relaxed, and each child keeps the best one if it
+    // takes over the child (see takesOver).
+    unordered_map<uint32_t, uint32_t> seed_of;
+    // Key: Child position, Value: Index in seeds
+    for (const pair<uint32_t, uint32_t>& edge : segment.incomingEdges)
+    {
+        uint32_t parent = edge.first;
+        uint32_t child = windowEdgeChild[edge.second];
+        int32_t weight = windowEdges[edge.second]->weight[idx];
+        SegmentSeed seed = {child, parent, weight, boundaryLength[parent] + weight};
+        auto previous = seed_of.find(child);
+        if (previous == seed_of.end())
+        {
+            if (takesOver(seed.length, parent, lane_length[child],
+                          criticalParentOf(idx, child, laneRecord[idx][child])))
+            {
+                seed_of[child] = segment.seeds.size();
+                segment.seeds.push_back(seed);
+            }
+        }
+        else if (takesOver(seed.length, parent, segment.seeds[previous->second].length,
+                           segment.seeds[previous->second].parent))
+        {
+            segment.seeds[previous->second] = seed;
+        }
+    }
+}
+
+template <uint32_t W>
+void O3CoreGraph<W>::fillSegment(uint32_t idx, WindowSegment& segment)
+{
+    vector<int32_t>& lane_length = laneLength[idx];
+    vector<uint32_t>& lane_record = laneRecord[idx];
+    vector<bool> changed(segment.end - segment.begin, false);
+    segment.renewed.assign(segment.end - segment.begin, false);
+
+    for (const SegmentSeed& seed : segment.seeds)
+    {
+        uint32_t offset = segmentRank[seed.child] - segment.begin;
+        changed[offset] = true;
+        lane_length[seed.child] = seed.length;
+        lane_record[seed.child] = segment.records.size();
+        segment.renewed[offset] = true;
+        segment.records.push_back({(int32_t)(seed.child - seed.parent), seed.parent, seed.weight});
+    }
+
+    // The same traversal as calculateLaneCriticalPath, over the edges inside the segment
+    for (uint32_t r = segment.begin; r < segment.end; ++r)
+    {
+        uint32_t n = segmentOrder[r];
+        if (!changed[r - segment.begin] && !resourceParents[n])
+        {
+            continue;
+        }
+
+        for (uint32_t k = windowEdgeBegin[n]; k < windowEdgeBegin[n + 1]; ++k)
+        {
+            int32_t weight = windowEdges[k]->weight[idx];
+            if (weight == EdgeWeight::ABSENT)
+            {
+                continue;
+            }
+
+            uint32_t child_position = windowEdgeChild[k];
+            uint32_t child_offset = segmentRank[child_position] - segment.begin;
+            if (segmentRank[child_position] >= segment.end)
+            {
+                continue; // See combineSegment
+            }
+            int64_t critical_parent = segment.renewed[child_offset] ?
+                (int64_t)child_position - segment.records[lane_record[child_position]].parentDistance :
+                criticalParentOf(idx, child_position, lane_record[child_position]);
+            if (takesOver(lane_length[n] + weight, n, lane_length[child_position], critical_parent))
+            {
+                changed[child_offset] = true;
+                lane_length[child_position] = lane_length[n] + weight;
+                PredecessorRecord record = {(int32_t)(child_position - n), n, weight};
+                if (segment.renewed[child_offset])
+                {
+                    segment.records[lane_record[child_position]] = record;
+                    continue;
+                }
+                lane_record[child_position] = segment.records.size();
+                segment.renewed[child_offset] = true;
+                segment.records.push_back(record);
+            }
+        }
+    }
+}
+
+template <uint32_t W>
+void O3CoreGraph<W>::gatherLanes(uint32_t part, uint32_t parts, uint64_t window_vertices)
+{
+    // Analysis windows start at a multiple of AnalysisWindow, so the hash of
+    // a vertex is its position in the window. Each thread reads all scenarios
+    // of the vertices in its range of buckets.
+    VertexHash window_position;
+    uint32_t begin, end;
+
+    ThreadPool::partition(length.bucket_count(), part, parts, begin, end);
+    for (uint32_t b = begin; b < end; ++b)
+    {
+        for (auto entry = length.begin(b); entry != length.end(b); ++entry)
+        {
+            uint64_t n = window_position(entry->first);
+            if (n < window_vertices)
+            {
+                for (uint32_t i = 0; i < W; ++i)
+                {
+                    laneLength[i][n] = entry->second[i];
+                }
+            }
+        }
+    }
+
+    ThreadPool::partition(criticalPredecessors.bucket_count(), part, parts, begin, end);
+    for (uint32_t b = begin; b < end; ++b)
+    {
+        for (auto entry = criticalPredecessors.begin(b); entry != criticalPredecessors.end(b); ++entry)
+        {
+            uint64_t n = window_position(entry->first);
+            if (n < window_vertices)
+            {
+                for (uint32_t i = 0; i < W; ++i)
+                {
+                    laneRecord[i][n] = entry->second.record[i];
+                }
+            }
+        }
+    }
+}
+
+template <uint32_t W>
+void O3CoreGraph<W>::scatterLanes(uint32_t part, uint32_t parts, uint64_t window_vertices)
+{
+    // Copies the per-scenario arrays back; each thread writes all scenarios
+    // of the vertices in its range of buckets.
+    VertexHash window_position;
+    uint32_t begin, end;
+
+    ThreadPool::partition(length.bucket_count(), part, parts, begin, end);
+    for (uint32_t b = begin; b < end; ++b)
+    {
+        for (auto entry = length.begin(b); entry != length.end(b); ++entry)
+        {
+            uint64_t n = window_position(entry->first);
+            if (n < window_vertices)
+            {
+                int32_t lanes[W];
+                for (uint32_t i = 0; i < W; ++i)
+                {
+                    lanes[i] = laneLength[i][n];
+                }
+                entry->second = LengthVector<W>(lanes, W);
+            }
+        }
+    }
+
+    ThreadPool::partition(criticalPredecessors.bucket_count(), part, parts, begin, end);
+    for (uint32_t b = begin; b < end; ++b)
+    {
+        for (auto entry = criticalPredecessors.begin(b); entry != criticalPredecessors.end(b); ++entry)
+        {
+            uint64_t n = window_position(entry->first);
+            if (n < window_vertices)
+            {
+                for (uint32_t i = 0; i < W; ++i)
+                {
+                    entry->second.record[i] = laneRecord[i][n];
+                }
+            }
+        }
+    }
+}
+
+template <uint32_t W>
+void O3CoreGraph<W>::sweepCriticalPathForScheduling()
+{
+    CALIPERS_INFO("Sweeping the spilled graph of window " << analyzedWindows
+                  << " for instrcution scheduling...");
+
+    // All the edges of an instruction are added while it is modeled, so the
+    // log is grouped by the instruction of the child. Each group is sorted
+    // (and its parallel edges merged) as the sweep reaches it, and each vertex
+    // then pulls its edges in the order of their parents, like the pushes of
+    // calculateCriticalPathForScheduling. The log is compacted in place.
+    uint64_t first_vertex = analyzedWindows * AnalysisWindow * (VertexType::Last + 1);
+    resetCriticalParents((windowEnd - analyzedWindows * AnalysisWindow) * (VertexType::Last + 1));
+    uint64_t edge_count = spilledEdges.size();
+    uint64_t read = 0;
+    uint64_t write = 0;
+    for (uint64_t i = analyzedWindows * AnalysisWindow; i < windowEnd; ++i)
+    {
+        uint64_t end = read;
+        while ((end < edge_count) && (spilledEdges[end].child / (VertexType::Last + 1) == i))
+        {
+            ++end;
+        }
+        sort(&spilledEdges[read], &spilledEdges[read] + (end - read));
+
+        uint64_t group = write;
+        for (; read < end; ++read)
+        {
+            SpilledEdge& e = spilledEdges[read];
+            if ((write > group) && (spilledEdges[write - 1].child == e.child) &&
+                (spilledEdges[write - 1].parent == e.parent))
+            {
+                spilledEdges[write - 1].weight =
+                    spilledEdges[write - 1].weight.template merged<W>(e.weight);
+                ++removedEdges;
+            }
+            else
+            {
+                spilledEdges[write++] = e;
+            }
+        }
+        spilledEdges.releaseBefore(group);
+
+        uint64_t k = group;
+        for (int j = 0; j <= VertexType::Last; ++j)
+        {
+            Vertex child(j, i);
+            for (; (k < write) && (spilledEdges[k].child == vertexNumber(child)); ++k)
+            {
+                uint64_t parent_num = spilledEdges[k].parent;
+                Vertex parent(parent_num % (VertexType::Last + 1),
+                              parent_num / (VertexType::Last + 1));
+                OutgoingEdge e(child, spilledEdges[k].weight);
+                LaneMask lanes = updateCriticalPathCycles(parent, e);
+                recordCriticalParents(lanes, parent_num - first_vertex,
+                                      vertexNumber(child) - first_vertex);
+            }
+
+            if (j == VertexType::InstrExecute)
+            {
+                for (uint32_t l = 0; l < W; ++l)
+                {
+                    scheduleOrder[l].insert(i, absoluteLength(child, l));
+                }
+            }
+            else if ((j == VertexType::MemExecute) && isLoadStore(i))
+            {
+                for (uint32_t l = 0; l < W; ++l)
+                {
+                    memScheduleOrder[l].insert(i, absoluteLength(child, l));
+                }
+            }
+        }
+    }
+    spilledEdges.resize(write);
+}
+
+template <uint32_t W>
+void O3CoreGraph<W>::sweepFinalCriticalPath()
+{
+    CALIPERS_INFO("Sweeping the spilled graph of window " << analyzedWindows
+                  << " for the final critical path...");
+
+    // Same as calculateFinalCriticalPath, but the instructions are visited in
+    // the order of the window, each vertex pulling its spilled and resource
+    // edges. A resource edge can point to an older instruction; when it changes
+    // its child, the instructions from the child on are swept again right away.
+    // These edges stay within the instruction buffer, so the edges of the recent
+    // instructions (kept in a ring) are still in the memory. Otherwise, the whole
+    // sweep is repeated. Ties are broken by the positions of the parents (see
+    // takesOver), so the sweeps end with the same lengths and breakdowns as the
+    // single pass over the graph in the memory, whatever order they relax the
+    // edges in. Each change of a vertex is numbered, so that an edge relaxed again
+    // only counts as a change if its parent changed since (its breakdown may
+    // differ), and the sweeps end.
+    uint64_t window_start = analyzedWindows * AnalysisWindow;
+    uint64_t window_vertices = (windowEnd - window_start) * (VertexType::Last + 1);
+    uint64_t ring_size = 2 * instrBufferSize;
+
+    vector<SpilledEdge> backward_edges; // Sorted by parent
+    for (SpilledEdge& e : spilledResourceEdges)
+    {
+        if (e.parent / (VertexType::Last + 1) > e.child / (VertexType::Last + 1))
+        {
+            backward_edges.push_back(e);
+        }
+    }
+    sort(backward_edges.begin(), backward_edges.end(),
+         [](const SpilledEdge& e1, const SpilledEdge& e2) { return e1.parent < e2.parent; });
+
+    vector<uint32_t> changes(window_vertices * W, 0); // The last change, 0 if none
+    uint32_t change_count = 0;
+    vector<uint64_t> spilled_begin(ring_size);
+    vector<uint64_t> resource_begin(ring_size);
+    bool repeat = true;
+    for (uint64_t sweep = 0; repeat; ++sweep)
+    {
+        if (sweep > backward_edges.size())
+        {
+            CALIPERS_ERROR("The graph of window " << analyzedWindows << " has a cycle");
+        }
+        repeat = false;
+
+        uint64_t spilled = 0;
+        uint64_t resource = 0;
+        uint64_t backward = 0;
+        for (uint64_t i = window_start; i < windowEnd; ++i)
+        {
+            spilledEdges.releaseBefore(spilled_begin[i % ring_size]);
+            spilled_begin[i % ring_size] = spilled;
+            resource_begin[i % ring_size] = resource;
+            while ((spilled < spilledEdges.size()) &&
+                   (spilledEdges[spilled].child / (VertexType::Last + 1) == i))
+            {
+                ++spilled;
+            }
+            while ((resource < spilledResourceEdges.size()) &&
+                   (spilledResourceEdges[resource].child / (VertexType::Last + 1) == i))
+            {
+                ++resource;
+            }
+
+            // [first, i] are swept, until no backward edge changes an instruction
+            uint64_t first = i;
+            while (first <= i)
+            {
+                uint64_t changed_instr = i + 1;
+                for (uint64_t j = first; j <= i; ++j)
+                {
+                    // The vertices of j pull their edges one after the other, so each
+                    // keeps one record per pull (the sweeps are not a topological order
+                    // as a whole, see firstPassRecord)
+                    for (uint32_t l = 0; lazyBreakdown && (l < W); ++l)
+                    {
+                        firstPassRecord[l] = predecessorLog[l].size();
+                    }
+                    uint64_t next = (j + 1) % ring_size;
+                    uint64_t s = spilled_begin[j % ring_size];
+                    uint64_t s_end = (j == i) ? spilled : spilled_begin[next];
+                    uint64_t r = resource_begin[j % ring_size];
+                    uint64_t r_end = (j == i) ? resource : resource_begin[next];
+                    while ((s < s_end) || (r < r_end))
+                    {
+                        if ((r == r_end) ||
+                            ((s < s_end) && !(spilledResourceEdges[r] < spilledEdges[s])))
+                        {
+                            relaxSpilledEdge(spilledEdges[s++], changes, change_count);
+                        }
+                        else
+                        {
+                            relaxSpilledEdge(spilledResourceEdges[r++], changes, change_count);
+                        }
+                    }
+                }
+
+                // The children of these children may already point to their records
+                for (uint32_t l = 0; lazyBreakdown && (l < W); ++l)
+                {
+                    firstPassRecord[l] = UINT32_MAX;
+                }
+                for (; (backward < backward_edges.size()) &&
+                       (backward_edges[backward].parent / (VertexType::Last + 1) <= i);
+                     ++backward)
+                {
+                    if (relaxSpilledEdge(backward_edges[backward], changes, change_count))
+                    {
+                        changed_instr = min(changed_instr, backward_edges[backward].child /
+                                                           (VertexType::Last + 1));
+                    }
+                }
+                if ((changed_instr <= i) && (i - changed_instr + 1 >= ring_size))
+                {
+                    repeat = true;
+                    break;
+                }
+                first = changed_instr;
+                backward = lower_bound(backward_edges.begin(), backward_edges.end(),
+                                       SpilledEdge{first * (VertexType::Last + 1), 0, 0},
+                                       [](const SpilledEdge& e1, const SpilledEdge& e2)
+                                       { return e1.parent < e2.parent; }) -
+                           backward_edges.begin();
+            }
+        }
+    }
+
+    spilledResourceEdges.clear();
+    for (uint32_t i = 0; i < W; ++i)
+    {
+        scheduleOrder[i].clear();
+    }
+}
+
+template <uint32_t W>
+bool O3CoreGraph<W>::relaxSpilledEdge(SpilledEdge& e, vector<uint32_t>& changes,
+                                      uint32_t& change_count)
+{
+    // Returns whether the child changed. Like calculateFinalCriticalPath,
+    // an edge is only relaxed in the scenarios where its parent changed
+    // (changes has an entry per vertex and scenario), or if its parent has a
+    // resource edge. The critical parent of the child only takes over again
+    // if it changed after the child.
+    uint64_t first_vertex = analyzedWindows * AnalysisWindow * (VertexType::Last + 1);
+    uint32_t parent_position = e.parent - first_vertex;
+    uint32_t child_position = e.child - first_vertex;
+
+    LaneMask lanes = 0;
+    if (resourceParents[parent_position])
+    {
+        lanes = allLanes<W>();
+    }
+    else
+    {
+        for (uint32_t i = 0; i < W; ++i)
+        {
+            if (changes[parent_position * W + i] != 0)
+            {
+                lanes |= (LaneMask)1 << i;
+            }
+        }
+    }
+    if (lanes == 0)
+    {
+        return false;
+    }
+
+    Vertex parent(e.parent % (VertexType::Last + 1), e.parent / (VertexType::Last + 1));
+    Vertex child(e.child % (VertexType::Last + 1), e.child / (VertexType::Last + 1));
+    VertexEntries parent_entries = vertexEntries(parent);
+    VertexEntries child_entries = vertexEntries(child);
+    LaneMask taken = 0;
+    for (uint32_t i = 0; i < W; ++i)
+    {
+        if (((lanes >> i) & 1) && (e.weight[i] != EdgeWeight::ABSENT))
+        {
+            int32_t length = (*parent_entries.length)[i] + e.weight[i];
+            int32_t child_length = (*child_entries.length)[i];
+            uint32_t child_record = lazyBreakdown ? child_entries.predecessors->record[i] : 0;
+            int64_t critical_parent = criticalParentOf(i, child_position, child_record);
+            if (takesOver(length, parent_position, child_length, critical_parent) &&
+                ((length != child_length) || (critical_parent != parent_position) ||
+                 (changes[parent_position * W + i] > changes[child_position * W + i])))
+            {
+                taken |= (LaneMask)1 << i;
+            }
+        }
+    }
+    if (taken == 0)
+    {
+        return false;
+    }
+
+    int parent_execution_type = vertexExecutionType(parent);
+    if (taken == e.weight.template presentLanes<W>())
+    {
+        updateCriticalPathCycles(parent, child, parent_execution_type, e.weight,
+                                 parent_entries, child_entries);
+    }
+    else
+    {
+        for (uint32_t i = 0; i < W; ++i)
+        {
+            if ((taken >> i) & 1)
+            {
+                EdgeWeight lane_weight((int64_t)e.weight[i], i);
+                updateCriticalPathCycles(parent, child, parent_execution_type, lane_weight,
+                                         parent_entries, child_entries);
+            }
+        }
+    }
+    recordCriticalParents(taken, parent_position, child_position);
+    for (uint32_t i = 0; i < W; ++i)
+    {
+        if ((taken >> i) & 1)
+        {
+            if (change_count == UINT32_MAX)
+            {
+                CALIPERS_ERROR("Too many changes in the graph of window " << analyzedWindows);
+            }
+            changes[child_position * W + i] = ++change_count;
+        }
+    }
+    return true;
+}
+
+#define INSTANTIATE_O3_CORE_GRAPH(w) template class O3CoreGraph<w>;
+FOR_EACH_VECTOR_WIDTH(INSTANTIATE_O3_CORE_GRAPH)
@@ -27,7 +27,11 @@
 
 #include "graph.h"
 #include "calipers_defs.h"
-#include "scoreboard.h"
+#include "lane_scoreboard.h"
+#include "thread_pool.h"
+#include "spill_log.h"
+#include "model_policy.h"
+#include "pipeline_bookkeeping.h"
 
 
 /**
@@ -36,22 +40,82 @@
  * if the number of instructions is greater than OOO_HOPPING_WINDOW,
  * the graph is separately constructed/analyzed for windows of size 
  * OOO_HOPPING_WINDOW (at most).
+ * The edges of a window can be spilled to a file and analyzed in sequential
+ * sweeps. The vertices (their lengths and breakdowns) stay in the memory.
+ * The next window can be constructed while a window is analyzed.
+ * A range of the windows can be simulated on its own, after warming up the
+ * caches and the branch predictor (see setShard).
+ * The loop over the instructions is specialized for the configured caches and
+ * branch predictor (see ModelPolicy).
  */
-class O3CoreGraph : public Graph
+template <uint32_t W>
+class O3CoreGraph : public VectorGraph<W>
 {
   private:
+    template <class E, class S> friend class ModelPolicySelector;
+
+    using Graph::AnalysisWindow;
+    using typename Graph::VertexHash;
+    using typename Graph::VertexEqual;
+    using typename Graph::ScheduleSet;
+    using Graph::instrStream;
+    using Graph::icache;
+    using Graph::dcache;
+    using Graph::bp;
+    using Graph::l1iThreshold;
+    using Graph::l2iThreshold;
+    using Graph::l1dThreshold;
+    using Graph::l2dThreshold;
+    using Graph::intAluTotalCycles;
+    using Graph::executionType;
+    using Graph::instructionMix;
+    using Graph::streamTime;
+    using Graph::graphConstructionTime;
+    using Graph::graphAnalysisTime;
+    using Graph::instrCount;
+    using Graph::analyzedWindows;
+    using Graph::l1iMisses;
+    using Graph::l2iMisses;
+    using Graph::l1dMisses;
+    using Graph::l2dMisses;
+    using Graph::bpMisses;
+    using Graph::branchCount;
+    using Graph::vertexNumber;
+    using Graph::vertexDistance;
+    using VectorGraph<W>::length;
+    using VectorGraph<W>::lengthBase;
+    using VectorGraph<W>::criticalPathCycles;
+    using VectorGraph<W>::criticalPathInstructions;
+    using VectorGraph<W>::lazyBreakdown;
+    using VectorGraph<W>::criticalPredecessors;
+    using VectorGraph<W>::predecessorLog;
+    using VectorGraph<W>::firstPassRecord;
+    using typename VectorGraph<W>::VertexEntries;
+    using VectorGraph<W>::vertexEntries;
+    using VectorGraph<W>::vertexExecutionType;
+    using VectorGraph<W>::updateCriticalPathCycles;
+    using VectorGraph<W>::resetPredecessorLog;
+    using VectorGraph<W>::rebaseLengths;
+    using VectorGraph<W>::absoluteLength;
+    using VectorGraph<W>::recordStats;
+    using VectorGraph<W>::printEdge;
+    using VectorGraph<W>::groupLanes;
+    using VectorGraph<W>::lanesOtherThan;
+
     /*** Microarchitectural parameters ***/
 
+    // Parameters that can differ across scenarios are kept as per-scenario
+    // edge weights (latencies) or lane groups (bandwidths).
+
     uint32_t instrBufferSize; // Bandwidth is in instructions per cycle
-    uint32_t fetchBandwidth;
-    uint32_t dispatchBandwidth;
-    uint32_t issueBandwidth;
-    uint32_t commitBandwidth;
-    uint32_t decodeCycles;
-    uint32_t dispatchCycles;
-    uint32_t executeToCommitCycles;
-    uint32_t predictionCycles;
-    uint32_t mispredictionPenalty;
+    LaneGroups fetchBandwidth;
+    LaneGroups dispatchBandwidth;
+    LaneGroups commitBandwidth;
+    EdgeWeight decodeCycles;
+    EdgeWeight dispatchCycles;
+    EdgeWeight executeToCommitCycles;
+    EdgeWeight predictionCycles;
+    EdgeWeight mispredictionPenalty;
     uint32_t memIssueBandwidth;
     uint32_t memCommitBandwidth;
     int bpType;
@@ -60,35 +124,25 @@ class O3CoreGraph : public Graph
     string icacheConfig;
     int dcacheType;
     string dcacheConfig;
-    Scoreboard scoreboard[VECTOR_WIDTH]; // Also performs bookkeeping
+    LaneScoreboard<W> scoreboard; // Also performs bookkeeping
 
+    void (O3CoreGraph::*traceModeler)();
+    // The instantiation of modelTrace for the configured caches and branch predictor
 
-    /*** Bookkeeping ***/
-
-    uint64_t currentIcacheLine;
-    uint64_t lastMisprediction;
-    uint64_t lastBranch;
-    bool previousInstrMispredicted;
-    bool previousWasBranch;
-    uint64_t linearPC;
-    uint64_t lastMemLdSt;
+    LaneMask inOrderDispatchLanes; // The scenarios with a dispatch bandwidth of more than one
+    LaneMask inOrderCommitLanes; // The scenarios with a commit bandwidth of more than one
 
-    unordered_map<int, pair<uint64_t, uint32_t>> regLastWrittenBy;
-    // Key: Register, Value: <Instruction number, Execution cycles>
 
-    unordered_map<int, bool> regLastWrittenByLoad;
-    // Key: Register, Value: Whether it was written by a load
+    /*** Bookkeeping ***/
 
-    pair<uint64_t,                              // First: Load/store number 
-         pair<uint64_t, uint32_t>>* ldStWindow; // Second: <Base, Length> of address
-    bool* ldStWindowType; // Is load?
-    uint32_t ldStWindowPointer;
+    uint64_t currentIcacheLine;
+    PipelineBookkeeping bookkeeping; // Register producers, loads/stores and branches
 
     unordered_map<uint64_t, uint32_t> lsCycles;
-    // Key: Instruction number % AnalysisWindow, Value: Load/store cycles (UINT32_MAX for invalid)
+    // Key: Instruction number % AnalysisWindow, Value: Load/store cycles (of loads and stores)
 
     unordered_map<uint64_t, uint32_t> executionCycles;
-    // Key: Instruction number % AnalysisWindow, Value: Execution cycles (UINT32_MAX for invalid)
+    // Key: Instruction number % AnalysisWindow, Value: Execution cycles
 
 
     /*** Graph-related data structures ***/
@@ -96,47 +150,260 @@ class O3CoreGraph : public Graph
     unordered_map<Vertex, vector<OutgoingEdge>, VertexHash, VertexEqual> graph;
     // graph[v] = Vector of children of Vertex v
 
-    ScheduleSet scheduleOrder[VECTOR_WIDTH];
+    unordered_map<Vertex, vector<OutgoingEdge>, VertexHash, VertexEqual> nextGraph;
+    unordered_map<uint64_t, int> nextExecutionType;
+    unordered_map<uint64_t, uint32_t> nextLsCycles;
+    unordered_map<uint64_t, uint32_t> nextExecutionCycles;
+    // The window is constructed in these, and they are swapped with graph, executionType,
+    // lsCycles, and executionCycles when the window is handed over to the analysis
+
+    ScheduleSet scheduleOrder[W];
     // The set(s) of <instruction number, critical path length> pairs sorted based on length
 
+    ScheduleSet memScheduleOrder[W];
+    // Same for the MemExecute vertices of the loads and stores, which take their
+    // load/store queue entries in this order (so that the resource edges between
+    // MemExecute vertices follow their lengths, like those between InstrExecute
+    // vertices follow scheduleOrder)
+
+    typedef struct RESOURCE_EDGE
+    {
+        Vertex parent;
+        Vertex child;
+        WeightVector<W> weight;
+    } ResourceEdge;
+
+    vector<ResourceEdge> resourceEdges[W];
+    // resourceEdges[i] = Edges found by scheduling the i'th range of scenarios,
+    // added to the graph in order once all scenarios are scheduled
+
+    vector<vector<OutgoingEdge>*> windowChildren;
+    // windowChildren[n] = The children of the n'th vertex of the window (NULL if none),
+    // set by compactGraph for the analysis of the window
+
+    vector<uint32_t> windowEdgeBegin;
+    vector<OutgoingEdge*> windowEdges;
+    vector<uint32_t> windowEdgeChild;
+    // The edges of the n'th vertex of the window (during the final critical path) are
+    // windowEdges[windowEdgeBegin[n]] to windowEdges[windowEdgeBegin[n + 1] - 1], and
+    // windowEdgeChild[k] = The position of the child of windowEdges[k] in the window
+
+    vector<bool> resourceParents;
+    // resourceParents[n] = Whether the n'th vertex of the window has a resource edge
+
+    vector<uint32_t> regularEdgeCount;
+    vector<uint32_t> regularInDegree;
+    // regularEdgeCount[n] = The number of edges of the n'th vertex of the window
+    // that compactGraph keeps (the resource edges are added after them), and
+    // regularInDegree[n] = The number of those edges into it. These edges go
+    // forward in the window, so they are counted in all scenarios.
+
+    vector<pair<uint32_t, uint32_t>> laneResourceEdges[W];
+    // laneResourceEdges[i] = <Parent position, Child position> of the resource
+    // edges of scenario i, recorded as they are added to the window
+
+    vector<uint32_t> criticalParent[W];
+    // criticalParent[i][n] = The position of the parent whose edge set the length of
+    // the n'th vertex of the window in scenario i (UINT32_MAX if none), which breaks
+    // the ties of the final critical path (see takesOver). Only kept without lazy
+    // breakdowns; the records of predecessorLog tell the same otherwise.
+
+    typedef struct SPILLED_EDGE
+    {
+        uint64_t parent; // Vertex number
+        uint64_t child; // Vertex number
+        EdgeWeight weight;
+
+        // The order of the sweeps: by child, then by parent
+        bool operator<(const SPILLED_EDGE& other) const
+        {
+            return (child < other.child) || ((child == other.child) && (parent < other.parent));
+        }
+    } SpilledEdge;
+
+    SpillLog<SpilledEdge> spilledEdges;
+    // If the graph is spilled to a file, the edges of the window instead of graph,
+    // in the order they are added (i.e., grouped by the instruction of the child)
+
+    vector<SpilledEdge> spilledResourceEdges;
+    // If the graph is spilled to a file, the resource edges of the window sorted by child
+
+    uint64_t addedEdges; // By the construction (over all windows)
+    uint64_t addedResourceEdges; // By modelResourceDependencies (over all windows)
+    uint64_t removedEdges; // By compactGraph and mergeEdge (over all windows)
+
+
+    /*** Multi-threaded analysis ***/
+
+    ThreadPool lanePool;
+    // Scenarios are partitioned into contiguous ranges, one per thread
+
+    vector<int32_t> laneLength[W];
+    vector<uint32_t> laneRecord[W];
+    // laneLength[i][n] and laneRecord[i][n] = Length and critical predecessor of
+    // the n'th vertex of the window in scenario i (during the final critical path).
+    // Each scenario has its own arrays, so that threads do not write to the same
+    // per-vertex vectors.
+
+    // With fewer scenarios than threads, the final critical path of a scenario is
+    // calculated over segments of its topological order: Each segment is summarized
+    // (in parallel) as a max-plus transfer matrix from the vertices that have edges
+    // into it to its vertices that have edges out of it, the summaries are applied
+    // in order (on one thread) to find the lengths at the segment boundaries, and then
+    // the lengths inside the segments are filled in (in parallel).
+
+    static const int32_t Unreachable = INT32_MIN / 4; // No path in a segment summary
+
+    typedef struct SEGMENT_SEED
+    {
+        uint32_t child; // Position in the window
+        uint32_t parent; // Position in the window (in an earlier segment)
+        int32_t weight;
+        int32_t length; // Of the child, through the parent
+    } SegmentSeed;
+
+    typedef struct WINDOW_SEGMENT
+    {
+        uint32_t begin;
+        uint32_t end;
+        // The segment is segmentOrder[begin] to segmentOrder[end - 1]
+
+        vector<pair<uint32_t, uint32_t>> crossingEdges;
+        // <Parent position, Index in windowEdges> of the edges out of the segment
+
+        vector<pair<uint32_t, uint32_t>> incomingEdges;
+        // Same for the edges into the segment, in the order they are relaxed
+
+        vector<uint32_t> columns; // The parents of incomingEdges (sorted)
+        vector<uint32_t> outVertices; // The parents of crossingEdges
+        vector<int32_t> outLength;
+        vector<int32_t> summary;
+        // outLength[o] = Length of outVertices[o] over the edges inside the segment, and
+        // summary[o * columns.size() + c] = Longest path from columns[c] to outVertices[o]
+        // through the segment (Unreachable if none)
+
+        vector<SegmentSeed> seeds;
+        // The winning incoming edges (from earlier segments) of the vertices of the segment
+
+        vector<PredecessorRecord> records;
+        vector<bool> renewed;
+        // The new records of the vertices of the segment (parentRecord is the position of
+        // the parent until the records are appended to predecessorLog), and renewed[r] =
+        // Whether segmentOrder[begin + r] has a new record
+    } WindowSegment;
+
+    vector<uint32_t> segmentOrder; // The topological order of the scenario
+    vector<uint32_t> segmentRank; // segmentRank[n] = Index of the n'th vertex in segmentOrder
+    vector<int32_t> boundaryLength; // Final lengths of the vertices in outVertices
+    vector<WindowSegment> windowSegments;
+
+
+    /*** Overlapped construction and analysis ***/
+
+    bool overlapWindows;
+    thread analysisThread; // Analyzes a window while the next one is constructed
+    bool pendingWindow; // Whether the stats of the last window handed over are not recorded yet
+    uint64_t windowEnd; // The instruction count at the end of the window being analyzed
+
+    typedef struct STREAM_COUNTERS
+    {
+        uint64_t instrCount;
+        uint64_t instructionMix[6];
+        uint64_t l1iMisses;
+        uint64_t l2iMisses;
+        uint64_t l1dMisses;
+        uint64_t l2dMisses;
+        uint64_t bpMisses;
+        uint64_t branchCount;
+    } StreamCounters;
+
+    StreamCounters windowCounters;
+    // The counters of the instruction stream at the end of the window being analyzed
+    // (the construction of the next window keeps counting in the members of Graph)
+
+
+    /*** Sharded simulation (see setShard) ***/
+
+    uint64_t functionalBegin; // The first instruction read from the trace
+    uint64_t detailedBegin; // The first instruction modeled (the earlier ones are only warmed)
+    uint64_t shardBegin; // The first instruction of the windows that are analyzed
+    uint64_t shardEnd; // The instruction after the last one of the windows that are analyzed
+
 
     void initBookKeeping();
+    void initAnalysis();
+    void resetWindowVertices();
+    void handOverWindow();
+    void finishWindow();
+    void swapCounters();
     void anaylzeWindow();
-    void model(Instruction* instr);
+    template <class P> void modelTrace();
+    template <class P> void warm(Instruction* instr);
+    template <class P> void model(Instruction* instr);
+    template <class P> bool predictBranch(Instruction* instr, bool is_branch);
+    template <class P> uint32_t fetchCycles(Instruction* instr);
+    void modelInstruction(Instruction* instr, const InstructionTiming& timing);
+    void countInstruction(Instruction* instr);
+    void countDataMiss(uint32_t ls_cycles);
     void modelPipeline(Vertex& fetch_vertex, Vertex& dispatch_vertex,
                        Vertex& execute_vertex, Vertex& mem_vertex,
                        Vertex& commit_vertex, Instruction* instr,
-                       uint32_t execution_cycles);
+                       uint32_t execution_cycles, const InstructionTiming& timing);
     bool modelMemoryOrderConstraint(Instruction* instr, Vertex& mem_vertex);
     void trackDataDependencies(Instruction* instr,
                                Vertex& execute_vertex, Vertex& mem_vertex);
     void modelResourceDependencies();
+    void scheduleLanes(uint32_t begin, uint32_t end, vector<ResourceEdge>& edges);
+    bool isLoadStore(uint64_t instr_num);
+    void addResourceEdges(int vertex_type, const uint64_t* curr_instr,
+                          const uint64_t* prev_instr, const WeightVector<W>& wait_cycles,
+                          LaneMask lanes, bool check_buffer, vector<ResourceEdge>& edges);
     void addEdge(Vertex& parent, OutgoingEdge& e);
+    void mergeEdge(Vertex& parent, OutgoingEdge& e);
+    void compactGraph();
     void calculateCriticalPathForScheduling();
     void calculateFinalCriticalPath();
+    void sweepCriticalPathForScheduling();
+    void sweepFinalCriticalPath();
+    bool relaxSpilledEdge(SpilledEdge& e, vector<uint32_t>& changes, uint32_t& change_count);
+    static bool takesOver(int32_t length, uint32_t parent_position,
+                          int32_t child_length, int64_t critical_parent);
+    int64_t criticalParentOf(uint32_t idx, uint32_t position, uint32_t record);
+    void recordCriticalParents(LaneMask lanes, uint32_t parent_position, uint32_t child_position);
+    void resetCriticalParents(uint64_t window_vertices);
+    void calculateFinalCriticalPathThreaded(uint64_t window_vertices);
+    void indexWindowEdges(uint64_t window_vertices);
+    void topologicalOrder(uint32_t idx, uint64_t window_vertices, vector<uint32_t>& order);
+    void calculateLaneCriticalPath(uint32_t idx, uint64_t window_vertices);
+    void calculateSegmentedCriticalPath(uint32_t idx, uint64_t window_vertices);
+    void summarizeSegment(uint32_t idx, WindowSegment& segment);
+    void combineSegment(uint32_t idx, WindowSegment& segment);
+    void fillSegment(uint32_t idx, WindowSegment& segment);
+    void gatherLanes(uint32_t part, uint32_t parts, uint64_t window_vertices);
+    void scatterLanes(uint32_t part, uint32_t parts, uint64_t window_vertices);
 
   public:
     O3CoreGraph(string trace_file_name,
                 string result_file_name,
                 InstructionStream* instr_stream,
                 uint32_t instr_buffer_size, 
-                uint32_t instr_queue_size, 
-                uint32_t fetch_bandwidth,
-                uint32_t dispatch_bandwidth,
-                uint32_t issue_bandwidth,
-                uint32_t commit_bandwidth,
-                uint32_t decode_cycles,
-                uint32_t dispatch_cycles,
-                uint32_t execute_to_commit_cycles,
-                uint32_t prediction_cycles,
-                uint32_t misprediction_penalty,
+                const vector<uint32_t>& instr_queue_size,
+                const vector<uint32_t>& fetch_bandwidth,
+                const vector<uint32_t>& dispatch_bandwidth,
+                const vector<uint32_t>& issue_bandwidth,
+                const vector<uint32_t>& commit_bandwidth,
+                const vector<uint32_t>& decode_cycles,
+                const vector<uint32_t>& dispatch_cycles,
+                const vector<uint32_t>& execute_to_commit_cycles,
+                const vector<uint32_t>& prediction_cycles,
+                const vector<uint32_t>& misprediction_penalty,
                 uint32_t mem_issue_bandwidth,
                 uint32_t mem_commit_bandwidth,
-                uint32_t int_alu_count,
-                uint32_t int_mul_div_count,
-                uint32_t fp_alu_count,
-                uint32_t fp_mul_div_count,
-                uint32_t lsu_count,
+                const vector<uint32_t>& int_alu_count,
+                const vector<uint32_t>& int_mul_div_count,
+                const vector<uint32_t>& fp_alu_count,
+                const vector<uint32_t>& fp_mul_div_count,
+                const vector<uint32_t>& lsu_count,
                 uint32_t lq_qize,
                 uint32_t sq_size,
                 int bp_type,
@@ -144,9 +411,18 @@ class O3CoreGraph : public Graph
                 int icache_type,
                 string icache_config,
                 int dcache_type,
-                string dcache_config);
+                string dcache_config,
+                bool lazy_breakdown,
+                uint32_t analysis_threads,
+                string spill_file_name,
+                bool overlap_windows);
     ~O3CoreGraph();
     void run();
+    void setShard(uint64_t functional_begin, uint64_t detailed_begin,
+                  uint64_t shard_begin, uint64_t shard_end);
+
+    static uint64_t windowBytes(uint64_t window_instructions, bool overlap_windows, bool spilled);
+    // The memory needed for windows of the given size (see main's select_engine)
 };
 
 
@@ -22,8 +22,6 @@
  * SOFTWARE.
  */
 
-#include <list>
-
 #include "calipers_defs.h"
 #include "calipers_types.h"
 #include "graph_util.h"
@@ -34,8 +32,10 @@
 #include "real_cache.h"
 #include "branch_predictor.h"
 #include "statistical_bp.h"
+#include "riscv_stream.h"
 
-O3CoreGraphAdvanced::O3CoreGraphAdvanced(string trace_file_name,
+template <uint32_t W>
+O3CoreGraphAdvanced<W>::O3CoreGraphAdvanced(string trace_file_name,
                                          string result_file_name, 
                                          InstructionStream* instr_stream,
                                          uint32_t instr_buffer_size,
@@ -64,7 +64,7 @@ O3CoreGraphAdvanced::O3CoreGraphAdvanced(string trace_file_name,
                                          string icache_config,
                                          int dcache_type,
                                          string dcache_config) :
-                                         Graph(trace_file_name, result_file_name, instr_stream),
+                                         VectorGraph<W>(trace_file_name, result_file_name, instr_stream),
                                          instrBufferSize(instr_buffer_size),
                                          fetchBandwidth(fetch_bandwidth),
                                          dispatchBandwidth(dispatch_bandwidth),
@@ -126,7 +126,11 @@ O3CoreGraphAdvanced::O3CoreGraphAdvanced(string trace_file_name,
             CALIPERS_ERROR("Invalid D-cache model");
     }
 
-    for (uint32_t i = 0; i < VECTOR_WIDTH; ++i)
+    // The trace is read by a RiscvStream (the only supported ISA)
+    traceModeler = ModelPolicySelector<O3CoreGraphAdvanced<W>, RiscvStream>::select(
+        icache_type, dcache_type, bp_type);
+
+    for (uint32_t i = 0; i < W; ++i)
     {
         // TODO: Parameterize the last two arguments of initResource and setMixedOperation
         // (i.e., latency and pipelined)
@@ -149,23 +153,48 @@ O3CoreGraphAdvanced::O3CoreGraphAdvanced(string trace_file_name,
         scoreboard[i].initQueue(QueueResource::RscInstrQ, instr_queue_size);
         scoreboard[i].initQueue(QueueResource::RscLQ, lq_size);
         scoreboard[i].initQueue(QueueResource::RscSQ, sq_size);
+
+        // A scheduled instruction is at most instrBufferSize after headScheduledInstr
+        alreadyScheduled[i].init(instrBufferSize + 1);
     }
 
     intAluTotalCycles = scoreboard[0].getResourceLatency(Resource::RscIntAlu);
 
-    ldStWindow = new pair<uint64_t, pair<uint64_t, uint32_t>>[lq_size + sq_size];
-    ldStWindowType = new bool[lq_size + sq_size];
+    bookkeeping.initLdStWindow(lq_size + sq_size, true);
+
+    // All per-vertex storage is sized for the analysis window up front
+    uint64_t window_vertices = (uint64_t)AnalysisWindow * (VertexType::Last + 1);
+    graphChildren.init(window_vertices);
+    graphParents.init(window_vertices);
+    length.reserve(window_vertices);
+    criticalPathCycles.reserve(window_vertices);
+    criticalPathInstructions.reserve(window_vertices);
+    updateQueued.assign(window_vertices, false);
+    for (uint32_t i = 0; i < W; ++i)
+    {
+        criticalParent[i].assign(window_vertices, 0);
+    }
+
+    // The producer waits while a refill (see modelResourceDependencies) is queued
+    bundles.init(AnalysisWindow / 4);
+    stagedBundle = NULL;
 
     initBookKeeping();
 }
 
-O3CoreGraphAdvanced::~O3CoreGraphAdvanced()
+template <uint32_t W>
+O3CoreGraphAdvanced<W>::~O3CoreGraphAdvanced()
+{
+}
+
+template <uint32_t W>
+uint64_t O3CoreGraphAdvanced<W>::windowBytes(uint64_t window_instructions)
 {
-    delete[] ldStWindow;
-    delete[] ldStWindowType;
+    return VectorGraph<W>::instructionBytes() * window_instructions;
 }
 
-void O3CoreGraphAdvanced::run()
+template <uint32_t W>
+void O3CoreGraphAdvanced<W>::run()
 {
     CALIPERS_INFO("Running the graph-based modeler...");
 
@@ -174,21 +203,12 @@ void O3CoreGraphAdvanced::run()
     uint32_t read_new = 0;
     sys_nanoseconds my_time;
 
+    // The instructions are modeled on their own thread and analyzed on this one
+    thread producer(traceModeler, this);
+
     for (uint32_t i = 0; i < AnalysisWindow; ++i)
     {
-        my_time = chrono::system_clock::now();
-        Instruction* instr = instrStream->next();
-        streamTime += (chrono::system_clock::now() - my_time).count();
-
-        if (instr != NULL)
-        {
-            model(instr);
-            my_time = chrono::system_clock::now();
-            calculateInstructionCriticalPath();
-            graphAnalysisTime += (chrono::system_clock::now() - my_time).count();
-            ++instrCount;
-        }
-        else
+        if (!consumeBundle())
         {
             instr_avail = false;
             break;
@@ -201,25 +221,7 @@ void O3CoreGraphAdvanced::run()
         {
             for (uint32_t i = 0; i < read_new; ++i)
             {
-                if (instrCount % 100000 == 0)
-                {
-                    CALIPERS_INFO("*** " << instrCount
-                                  << " instructions modeled/analyzed" << endl);
-                }
-
-                my_time = chrono::system_clock::now();
-                Instruction* instr = instrStream->next();
-                streamTime += (chrono::system_clock::now() - my_time).count();
-
-                if (instr != NULL)
-                {
-                    model(instr);
-                    my_time = chrono::system_clock::now();
-                    calculateInstructionCriticalPath();
-                    graphAnalysisTime += (chrono::system_clock::now() - my_time).count();
-                    ++instrCount;
-                }
-                else
+                if (!consumeBundle())
                 {
                     instr_avail = false;
                     break;
@@ -232,6 +234,8 @@ void O3CoreGraphAdvanced::run()
         all_scheduled = state.second;
     }
 
+    producer.join();
+
     my_time = chrono::system_clock::now();
     recordStats(true, false);
     graphAnalysisTime += (chrono::system_clock::now() - my_time).count();
@@ -244,28 +248,18 @@ void O3CoreGraphAdvanced::run()
                   << (graphAnalysisTime / 1000000) << " ms" << endl);
 }
 
-void O3CoreGraphAdvanced::initBookKeeping()
+template <uint32_t W>
+void O3CoreGraphAdvanced<W>::initBookKeeping()
 {
     currentIcacheLine = UINT64_MAX;
-    lastMisprediction = UINT64_MAX;
-    lastBranch = UINT64_MAX;
-    previousInstrMispredicted = false;
-    previousWasBranch = false;
-    lastMemLdSt = UINT64_MAX;
-    ldStWindowPointer = 0;
+    bookkeeping.reset();
     headInstr = AnalysisWindow;
     headScheduledInstr = 0;
-    
-    uint32_t ld_st_window_size = scoreboard[0].getQueueSize(QueueResource::RscLQ) +
-                                 scoreboard[0].getQueueSize(QueueResource::RscSQ);
-    for (uint32_t i = 0; i < ld_st_window_size; ++i)
-    {
-        ldStWindow[i].first = UINT64_MAX;
-    }
 
     Vertex first_vertex(0, 0);
-    Vector zero_vector(0);
-    length[first_vertex] = zero_vector;
+    Vector<W> zero_vector(0);
+    length[first_vertex] = LengthVector<W>(0);
+    lengthBase = zero_vector;
     criticalPathCycles[first_vertex].goodFetchHitCycles = zero_vector;
     criticalPathCycles[first_vertex].goodFetchMissCycles = zero_vector;
     criticalPathCycles[first_vertex].badFetchHitCycles = zero_vector;
@@ -301,10 +295,118 @@ void O3CoreGraphAdvanced::initBookKeeping()
     }
 }
 
-void O3CoreGraphAdvanced::model(Instruction* instr)
+template <uint32_t W>
+template <class P>
+void O3CoreGraphAdvanced<W>::model(Instruction* instr)
 {
     sys_nanoseconds my_time = chrono::system_clock::now();
+    typename P::DCache* dcache_model = static_cast<typename P::DCache*>(dcache);
+
+    bool is_load = (instr->memLoadCount == 1); // Also covers atomic instructions
+    bool is_store = (instr->memStoreCount == 1); // Also covers atomic instructions
+    bool is_branch = (instr->executionType == ExecutionType::BranchCond) ||
+                     (instr->executionType == ExecutionType::BranchUncond);
+    InstructionTiming timing;
+
+    // The memory order edges are staged before the D-cache is accessed (to
+    // find store-to-load forwarding), and the models are accessed in the
+    // same order as in O3CoreGraph.
+    timing.lsCycles = 0;
+    if (is_load || is_store)
+    {
+        if (P::DCache::fromTrace)
+        {
+            timing.lsCycles = instr->lsCycles;
+        }
+        else
+        {
+            Vertex mem_vertex(VertexType::MemExecute, instrCount);
+            bool store_to_load_forwarding = modelMemoryOrderConstraint(instr, mem_vertex);
+            if (is_load)
+            {
+                timing.lsCycles = store_to_load_forwarding ?
+                    0 : dcache_model->loadCycles(instr->memLoadBase, instr->memLoadLength);
+            }
+            else
+            {
+                timing.lsCycles =
+                    dcache_model->storeCycles(instr->memStoreBase, instr->memStoreLength);
+            }
+        }
+    }
+    timing.mispredicted = predictBranch<P>(instr, is_branch);
+    timing.fetchCycles = fetchCycles<P>(instr);
+
+    modelInstruction(instr, timing);
+
+    graphConstructionTime += (chrono::system_clock::now() - my_time).count();
+}
+
+template <uint32_t W>
+template <class P>
+bool O3CoreGraphAdvanced<W>::predictBranch(Instruction* instr, bool is_branch)
+{
+    bool mispredicted;
+    if (P::Bp::fromTrace)
+    {
+        mispredicted = instr->mispredicted;
+    }
+    else
+    {
+        mispredicted = is_branch ?
+            static_cast<typename P::Bp*>(bp)->mispredicted(instr->pc) : false;
+    }
+
+    if (is_branch)
+    {
+        ++branchCount;
+        if (mispredicted)
+        {
+            ++bpMisses;
+        }
+    }
+    return mispredicted;
+}
+
+template <uint32_t W>
+template <class P>
+uint32_t O3CoreGraphAdvanced<W>::fetchCycles(Instruction* instr)
+{
+    uint32_t fetch_cycles;
+    if (P::ICache::fromTrace)
+    {
+        fetch_cycles = instr->fetchCycles;
+    }
+    else
+    {
+        if (currentIcacheLine != (instr->pc & (UINT64_MAX << CACHE_ADDRESS_ZEROS)))
+        {
+            fetch_cycles = static_cast<typename P::ICache*>(icache)->loadCycles(
+                instr->pc, CACHE_LINE_BYTES);
+        }
+        else
+        {
+            fetch_cycles = 0;
+        }
+    }
+
+    currentIcacheLine = (instr->pc & (UINT64_MAX << CACHE_ADDRESS_ZEROS));
+
+    if (fetch_cycles > l2iThreshold)
+    {
+        ++l2iMisses;
+    }
+    else if (fetch_cycles > l1iThreshold)
+    {
+        ++l1iMisses;
+    }
+    return fetch_cycles;
+}
 
+template <uint32_t W>
+void O3CoreGraphAdvanced<W>::modelInstruction(Instruction* instr,
+                                              const InstructionTiming& timing)
+{
     Vertex fetch_vertex(VertexType::InstrFetch, instrCount);
     Vertex dispatch_vertex(VertexType::InstrDispatch, instrCount);
     Vertex execute_vertex(VertexType::InstrExecute, instrCount);
@@ -312,8 +414,7 @@ void O3CoreGraphAdvanced::model(Instruction* instr)
     Vertex commit_vertex(VertexType::InstrCommit, instrCount);
 
     uint32_t execution_cycles;
-    bool store_to_load_forwarding;
-    uint32_t ls_cycles;
+    uint32_t ls_cycles = 0; // Only set for loads and stores
 
     bool is_load = (instr->memLoadCount == 1); // Also covers atomic instructions
     bool is_store = (instr->memStoreCount == 1); // Also covers atomic instructions
@@ -327,7 +428,8 @@ void O3CoreGraphAdvanced::model(Instruction* instr)
     bool is_fp_mul = (instr->executionType == ExecutionType::FpMul);
     bool is_fp_div = (instr->executionType == ExecutionType::FpDiv);
 
-    executionType[instrCount % AnalysisWindow] = instr->executionType;    
+    stagedBundle->executionType = instr->executionType;
+    stagedBundle->lsCycles = UINT32_MAX;
 
     // 0: int, 1: fp, 2: load, 3: store, 4: branch, 5: other
     if (is_branch)
@@ -355,45 +457,18 @@ void O3CoreGraphAdvanced::model(Instruction* instr)
         ++instructionMix[5];
     }
 
-    if (is_load_store)
-    {
-        if (dcache == NULL)
-        {
-            store_to_load_forwarding = false;
-        }
-        else
-        {
-            store_to_load_forwarding = modelMemoryOrderConstraint(instr, mem_vertex);
-        }
-    }
-
     if (is_load)
     {
-        if (dcache == NULL)
-        {
-            ls_cycles = instr->lsCycles;
-        }
-        else
-        {
-            ls_cycles = store_to_load_forwarding ?
-                0 : dcache->loadCycles(instr->memLoadBase, instr->memLoadLength);
-        }
+        ls_cycles = timing.lsCycles;
         execution_cycles = scoreboard[0].getResourceLatency(Resource::RscLsu) + ls_cycles;
-        lsCycles[instrCount % AnalysisWindow] = ls_cycles;
+        stagedBundle->lsCycles = ls_cycles;
     }
     else if (is_store)
     {
-        if (dcache == NULL)
-        {
-            ls_cycles = instr->lsCycles;
-        }
-        else
-        {
-            ls_cycles = dcache->storeCycles(instr->memStoreBase, instr->memStoreLength);
-        }
+        ls_cycles = timing.lsCycles;
         // Stores quickly complete
         execution_cycles = scoreboard[0].getResourceLatency(Resource::RscLsu);
-        lsCycles[instrCount % AnalysisWindow] = ls_cycles;
+        stagedBundle->lsCycles = ls_cycles;
     }
     else if (is_int)
     {
@@ -435,10 +510,10 @@ void O3CoreGraphAdvanced::model(Instruction* instr)
         executionCycles[instrCount % AnalysisWindow] = execution_cycles;
     }
     */
-    executionCycles[instrCount % AnalysisWindow] = execution_cycles;
+    stagedBundle->executionCycles = execution_cycles;
 
     modelPipeline(fetch_vertex, dispatch_vertex, execute_vertex,
-                  mem_vertex, commit_vertex, instr, execution_cycles);
+                  mem_vertex, commit_vertex, instr, execution_cycles, timing);
 
     trackDataDependencies(instr, execute_vertex, mem_vertex);
 
@@ -447,23 +522,16 @@ void O3CoreGraphAdvanced::model(Instruction* instr)
 
     if (is_load_store)
     {
-        lastMemLdSt = instrCount;
-        ldStWindow[ldStWindowPointer].first = instrCount;
         if (is_load)
         {
-            ldStWindow[ldStWindowPointer].second.first = instr->memLoadBase;
-            ldStWindow[ldStWindowPointer].second.second = instr->memLoadLength;
-            ldStWindowType[ldStWindowPointer] = true;
+            bookkeeping.pushLdSt(instrCount, instr->memLoadBase, instr->memLoadLength,
+                                 ls_cycles, true);
         }
         else
         {
-            ldStWindow[ldStWindowPointer].second.first = instr->memStoreBase;
-            ldStWindow[ldStWindowPointer].second.second = instr->memStoreLength;
-            ldStWindowType[ldStWindowPointer] = false;
+            bookkeeping.pushLdSt(instrCount, instr->memStoreBase, instr->memStoreLength,
+                                 ls_cycles, false);
         }
-        ldStWindowPointer = (ldStWindowPointer + 1) %
-                            (scoreboard[0].getQueueSize(QueueResource::RscLQ) +
-                             scoreboard[0].getQueueSize(QueueResource::RscSQ));
 
         if (ls_cycles > l2dThreshold)
         {
@@ -475,105 +543,52 @@ void O3CoreGraphAdvanced::model(Instruction* instr)
         }
     }
 
-    previousWasBranch = is_branch;
-    linearPC = instr->pc + instr->bytes;
+    bookkeeping.previousWasBranch = is_branch;
+    bookkeeping.linearPC = instr->pc + instr->bytes;
     if (is_branch)
     {
-        lastBranch = instrCount;
+        bookkeeping.lastBranch = instrCount;
     }
 
     for (uint32_t i = 0; i < instr->regWriteCount; ++i)
     {
-        int reg_write = instr->regWrite[i];
-        regLastWrittenBy[reg_write].first = instrCount;
-        if (is_load)
-        {
-            regLastWrittenBy[reg_write].second = ls_cycles;
-            regLastWrittenByLoad[reg_write] = true;
-        }
-        else
-        {
-            regLastWrittenBy[reg_write].second = execution_cycles;
-            regLastWrittenByLoad[reg_write] = false;
-        }
+        bookkeeping.setProducer(instr->regWrite[i], instrCount,
+                                is_load ? ls_cycles : execution_cycles, is_load);
     }
-
-    graphConstructionTime += (chrono::system_clock::now() - my_time).count();
 }
 
-void O3CoreGraphAdvanced::modelPipeline(Vertex& fetch_vertex, Vertex& dispatch_vertex,
+template <uint32_t W>
+void O3CoreGraphAdvanced<W>::modelPipeline(Vertex& fetch_vertex, Vertex& dispatch_vertex,
                                         Vertex& execute_vertex, Vertex& mem_vertex,
                                         Vertex& commit_vertex, Instruction* instr,
-                                        uint32_t execution_cycles)
+                                        uint32_t execution_cycles,
+                                        const InstructionTiming& timing)
 {
     bool mispredicted;
     uint32_t fetch_cycles;
     bool is_load_store = (instr->memLoadCount == 1) || 
                          (instr->memStoreCount == 1);
-    bool is_branch = (instr->executionType == BranchCond) ||
-                     (instr->executionType == BranchUncond);
     bool no_need_for_ino_dispatch = (instrCount == 0) ||
                                     (dispatchBandwidth == 1);
     bool no_need_for_ino_commit = (instrCount == 0) || 
                                   (commitBandwidth == 1);
 
     // Branch prediction
-    mispredicted = previousInstrMispredicted;
-    if (bp == NULL)
-    {
-        previousInstrMispredicted = instr->mispredicted;
-    }
-    else
-    {
-        previousInstrMispredicted = is_branch ? bp->mispredicted(instr->pc) : false;
-    }
-
-    if (is_branch)
-    {
-        ++branchCount;
-        if (previousInstrMispredicted)
-        {
-            ++bpMisses;
-        }
-    }
+    mispredicted = bookkeeping.previousInstrMispredicted;
+    bookkeeping.previousInstrMispredicted = timing.mispredicted;
 
     // Fetch
-    if (icache == NULL)
-    {
-        fetch_cycles = instr->fetchCycles;
-    }
-    else
-    {
-        if (currentIcacheLine != (instr->pc & (UINT64_MAX << CACHE_ADDRESS_ZEROS)))
-        {
-            fetch_cycles = icache->loadCycles(instr->pc, CACHE_LINE_BYTES);
-        }
-        else
-        {
-            fetch_cycles = 0;
-        }
-    }
-
-    currentIcacheLine = (instr->pc & (UINT64_MAX << CACHE_ADDRESS_ZEROS));
-
-    if (fetch_cycles > l2iThreshold)
-    {
-        ++l2iMisses;
-    }
-    else if (fetch_cycles > l1iThreshold)
-    {
-        ++l1iMisses;
-    }
+    fetch_cycles = timing.fetchCycles;
 
     // Dispatch after fetch
     OutgoingEdge fetch_after_dispatch(dispatch_vertex, (int64_t)decodeCycles);
     //cout << "Dispatch after fetch" << endl;
-    addEdge(fetch_vertex, fetch_after_dispatch);
+    stageEdge(fetch_vertex, fetch_after_dispatch);
 
     // Execute after dispatch
     OutgoingEdge execute_after_dispatch(execute_vertex, (int64_t)dispatchCycles);
     //cout << "Execute after dispatch" << endl;
-    addEdge(dispatch_vertex, execute_after_dispatch);
+    stageEdge(dispatch_vertex, execute_after_dispatch);
 
     if (is_load_store)
     {
@@ -581,14 +596,14 @@ void O3CoreGraphAdvanced::modelPipeline(Vertex& fetch_vertex, Vertex& dispatch_v
         OutgoingEdge mem_after_instr(mem_vertex,
             (int64_t)scoreboard[0].getResourceLatency(Resource::RscLsu));
         //cout << "Memory execute after instruction execute" << endl;
-        addEdge(execute_vertex, mem_after_instr);
+        stageEdge(execute_vertex, mem_after_instr);
 
         // Commit after execute
         OutgoingEdge commit_after_execute(commit_vertex,
             (int64_t)(execution_cycles - scoreboard[0].getResourceLatency(Resource::RscLsu) +
                       executeToCommitCycles));
         //cout << "Commit after memory execute" << endl;
-        addEdge(mem_vertex, commit_after_execute);        
+        stageEdge(mem_vertex, commit_after_execute);        
     }
     else
     {
@@ -596,54 +611,54 @@ void O3CoreGraphAdvanced::modelPipeline(Vertex& fetch_vertex, Vertex& dispatch_v
         OutgoingEdge commit_after_execute(commit_vertex,
             (int64_t)(execution_cycles + executeToCommitCycles));
         //cout << "Commit after execute" << endl;
-        addEdge(execute_vertex, commit_after_execute);
+        stageEdge(execute_vertex, commit_after_execute);
     }
 
     // Limited fetch bandwidth
     if ((instrCount >= fetchBandwidth) &&
-        ((lastMisprediction == UINT64_MAX) ||
-         (instrCount - lastMisprediction > fetchBandwidth)))
+        ((bookkeeping.lastMisprediction == UINT64_MAX) ||
+         (instrCount - bookkeeping.lastMisprediction > fetchBandwidth)))
     {
         Vertex prev_fetch_vertex(VertexType::InstrFetch, instrCount - fetchBandwidth);
         OutgoingEdge limited_fetch_bw(fetch_vertex, 1);
         //cout << "Limited fetch bandwidth" << endl;
-        addEdge(prev_fetch_vertex, limited_fetch_bw);
+        stageEdge(prev_fetch_vertex, limited_fetch_bw);
     }
 
     // Limited dispatch bandwidth
     if ((instrCount >= dispatchBandwidth) &&
-        ((lastMisprediction == UINT64_MAX) ||
-         (instrCount - lastMisprediction > dispatchBandwidth)))
+        ((bookkeeping.lastMisprediction == UINT64_MAX) ||
+         (instrCount - bookkeeping.lastMisprediction > dispatchBandwidth)))
     {
         Vertex prev_dispatch_vertex(VertexType::InstrDispatch, instrCount - dispatchBandwidth);
         OutgoingEdge limited_dispatch_bw(dispatch_vertex, 1);
         //cout << "Limited dispatch bandwidth" << endl;
-        addEdge(prev_dispatch_vertex, limited_dispatch_bw);
+        stageEdge(prev_dispatch_vertex, limited_dispatch_bw);
     }
 
     // Limited commit bandwidth
     if ((instrCount >= commitBandwidth) &&
-        ((lastMisprediction == UINT64_MAX) ||
-         (instrCount - lastMisprediction > commitBandwidth)))
+        ((bookkeeping.lastMisprediction == UINT64_MAX) ||
+         (instrCount - bookkeeping.lastMisprediction > commitBandwidth)))
     {
         Vertex prev_commit_vertex(VertexType::InstrCommit, instrCount - commitBandwidth);
         OutgoingEdge limited_commit_bw(commit_vertex, 1);
         //cout << "Limited commit bandwidth" << endl;
-        addEdge(prev_commit_vertex, limited_commit_bw);
+        stageEdge(prev_commit_vertex, limited_commit_bw);
     }
 
     // Limited memory commit bandwidth
-    if ((lastMemLdSt != UINT64_MAX) &&
-        (instrCount - lastMemLdSt == memCommitBandwidth) &&
-        ((lastMisprediction == UINT64_MAX) ||
-         (instrCount - lastMisprediction > memCommitBandwidth)))
+    if ((bookkeeping.lastMemLdSt != UINT64_MAX) &&
+        (instrCount - bookkeeping.lastMemLdSt == memCommitBandwidth) &&
+        ((bookkeeping.lastMisprediction == UINT64_MAX) ||
+         (instrCount - bookkeeping.lastMisprediction > memCommitBandwidth)))
     {
-        Vertex prev_commit_vertex(VertexType::InstrCommit, lastMemLdSt);
+        Vertex prev_commit_vertex(VertexType::InstrCommit, bookkeeping.lastMemLdSt);
         OutgoingEdge limited_mem_commit_bw(commit_vertex, 1);
         //cout << "Limited memory commit bandwidth" << endl;
-        addEdge(prev_commit_vertex, limited_mem_commit_bw);
+        stageEdge(prev_commit_vertex, limited_mem_commit_bw);
 
-        no_need_for_ino_commit = no_need_for_ino_commit || ((instrCount - lastMemLdSt) == 1);
+        no_need_for_ino_commit = no_need_for_ino_commit || ((instrCount - bookkeeping.lastMemLdSt) == 1);
     }
 
     if (mispredicted)
@@ -653,8 +668,8 @@ void O3CoreGraphAdvanced::modelPipeline(Vertex& fetch_vertex, Vertex& dispatch_v
             (int64_t)(scoreboard[0].getResourceLatency(Resource::RscIntAlu) +
                       mispredictionPenalty + fetch_cycles));
         //cout << "Bad fetch" << endl;
-        addEdge(prev_branch_vertex, mispredicted_fetch);
-        lastMisprediction = instrCount - 1;
+        stageEdge(prev_branch_vertex, mispredicted_fetch);
+        bookkeeping.lastMisprediction = instrCount - 1;
     }
     else
     {
@@ -662,8 +677,8 @@ void O3CoreGraphAdvanced::modelPipeline(Vertex& fetch_vertex, Vertex& dispatch_v
         {
             // In-order fetch
             uint32_t fetch_weight;
-            //if (previousWasBranch && (instr->pc != linearPC)) // Correctly taken branch
-            if (previousWasBranch)
+            //if (bookkeeping.previousWasBranch && (instr->pc != bookkeeping.linearPC)) // Correctly taken branch
+            if (bookkeeping.previousWasBranch)
             {
                 fetch_weight = predictionCycles + fetch_cycles;
             }
@@ -675,7 +690,7 @@ void O3CoreGraphAdvanced::modelPipeline(Vertex& fetch_vertex, Vertex& dispatch_v
             Vertex prev_fetch_vertex(VertexType::InstrFetch, instrCount - 1);
             OutgoingEdge in_order_fetch(fetch_vertex, (int64_t)fetch_weight);
             //cout << "Good fetch" << endl;
-            addEdge(prev_fetch_vertex, in_order_fetch);
+            stageEdge(prev_fetch_vertex, in_order_fetch);
         }
 
         // In-order dispatch
@@ -684,7 +699,7 @@ void O3CoreGraphAdvanced::modelPipeline(Vertex& fetch_vertex, Vertex& dispatch_v
             Vertex prev_dispatch_vertex(VertexType::InstrDispatch, instrCount - 1);
             OutgoingEdge in_order_dispatch(dispatch_vertex, 0);
             //cout << "In-order dispatch" << endl;
-            addEdge(prev_dispatch_vertex, in_order_dispatch);
+            stageEdge(prev_dispatch_vertex, in_order_dispatch);
         }
 
         // In-order commit
@@ -693,7 +708,7 @@ void O3CoreGraphAdvanced::modelPipeline(Vertex& fetch_vertex, Vertex& dispatch_v
             Vertex prev_commit_vertex(VertexType::InstrCommit, instrCount - 1);
             OutgoingEdge in_order_commit(commit_vertex, 0);
             //cout << "In-order commit" << endl;
-            addEdge(prev_commit_vertex, in_order_commit);
+            stageEdge(prev_commit_vertex, in_order_commit);
         }
     }
 
@@ -703,7 +718,7 @@ void O3CoreGraphAdvanced::modelPipeline(Vertex& fetch_vertex, Vertex& dispatch_v
         Vertex prev_commit_vertex(VertexType::InstrCommit, instrCount - instrBufferSize);
         OutgoingEdge limited_instr_buffer(fetch_vertex, 0);
         //cout << "Limited instruction buffer size" << endl;
-        addEdge(prev_commit_vertex, limited_instr_buffer);
+        stageEdge(prev_commit_vertex, limited_instr_buffer);
     }
 
     // Limited instruction queue size (alternative modeling approach)
@@ -713,20 +728,18 @@ void O3CoreGraphAdvanced::modelPipeline(Vertex& fetch_vertex, Vertex& dispatch_v
         Vertex prev_execute_vertex(VertexType::InstrExecute, instrCount - instrQueueSize);
         OutgoingEdge limited_instr_queue(dispatch_vertex, 0);
         //cout << "Limited instruction queue size" << endl;
-        addEdge(prev_execute_vertex, limited_instr_queue);
+        stageEdge(prev_execute_vertex, limited_instr_queue);
     }
     */
 }
 
-bool O3CoreGraphAdvanced::modelMemoryOrderConstraint(Instruction* instr, Vertex& mem_vertex)
+template <uint32_t W>
+bool O3CoreGraphAdvanced<W>::modelMemoryOrderConstraint(Instruction* instr, Vertex& mem_vertex)
 {
     bool store_to_load_forwarding = false;
     uint64_t base;
     uint32_t length;
-    uint32_t index;
     bool is_load = (instr->memLoadCount != 0);
-    uint32_t lq_size = scoreboard[0].getQueueSize(QueueResource::RscLQ);
-    uint32_t sq_size = scoreboard[0].getQueueSize(QueueResource::RscSQ);
 
     if (is_load)
     {
@@ -740,75 +753,39 @@ bool O3CoreGraphAdvanced::modelMemoryOrderConstraint(Instruction* instr, Vertex&
     }
 
     // Limited memory issue bandwidth
-    index = (ldStWindowPointer + lq_size + sq_size - memIssueBandwidth) % (lq_size + sq_size);
-    uint64_t previous_ld_st_num = ldStWindow[index].first;
+    uint64_t previous_ld_st_num = bookkeeping.ldStByAge(memIssueBandwidth - 1).instrNum;
     if (previous_ld_st_num != UINT64_MAX)
     {
         Vertex prev_mem_vertex(VertexType::MemExecute, previous_ld_st_num);
         OutgoingEdge limited_mem_issue_bw(mem_vertex, 0);
         //cout << "Limited memory issue bandwidth: " << previous_ld_st_num
         //     << " to " << instrCount << endl;
-        addEdge(prev_mem_vertex, limited_mem_issue_bw);
+        stageEdge(prev_mem_vertex, limited_mem_issue_bw);
     }
 
-    // The following loop starts from the youngest load/store before this insturction.
-    // If this instruction is a load, it checks if a store-to-load forwarding edge is needed.
-    // If this instruction is a store, it checks if an edge from the youngest load/store
-    // with a common address is needed.
-    index = (ldStWindowPointer + lq_size + sq_size - 1) % (lq_size + sq_size);
-    for (uint32_t i = 0; i < lq_size + sq_size; ++i)
+    // If this instruction is a load, a store-to-load forwarding edge is needed from the
+    // youngest older store with a common address. If this instruction is a store, an edge
+    // is needed from the youngest older load/store with a common address.
+    const LdStEntry* previous_ld_st = bookkeeping.youngestSharingAddress(base, length, is_load);
+    if (previous_ld_st != NULL)
     {
-        uint64_t previous_ld_st_num = ldStWindow[index].first;
-        if (previous_ld_st_num == UINT64_MAX)
-        {
-            break;
-        }
-
-        pair<uint64_t, uint32_t> previous_ld_st_addr = ldStWindow[index].second;
-        uint64_t prev_base = previous_ld_st_addr.first;
-        uint64_t prev_length = previous_ld_st_addr.second;
-        bool is_prev_load = ldStWindowType[index];
-
-        bool common = ((base >= prev_base) && (base < prev_base + prev_length)) ||
-                      ((base + length > prev_base) && (base + length <= prev_base + prev_length));
-
-        bool needs_edge = false;
-
-        if (common && !is_prev_load && is_load)
-        {
-            needs_edge = true;
-            store_to_load_forwarding = true;
-            //cout << "Store to load forwarding: " << previous_ld_st_num
-            //     << " to " << instrCount << endl;
-        }
-
-        if (common && !is_load)
-        {
-            needs_edge = true;
-            //cout << "Store after load/store from/to same address: " << previous_ld_st_num
-            //     << " to " << instrCount << endl;
-        }
-
-        if (needs_edge)
-        {
-                Vertex prev_mem_vertex(VertexType::MemExecute, previous_ld_st_num);
-                OutgoingEdge limited_mem(mem_vertex, 0);
-                addEdge(prev_mem_vertex, limited_mem);
-                break;
-        }
-
-        index = (index + lq_size + sq_size - 1) % (lq_size + sq_size);
+        store_to_load_forwarding = is_load;
+        //cout << "Memory order (store to load forwarding for loads): "
+        //     << previous_ld_st->instrNum << " to " << instrCount << endl;
+        Vertex prev_mem_vertex(VertexType::MemExecute, previous_ld_st->instrNum);
+        OutgoingEdge limited_mem(mem_vertex, 0);
+        stageEdge(prev_mem_vertex, limited_mem);
     }
 
     /*
     if (is_load)
     {
         // Additional constraint: load requests are only sent when they are non-speculative
-        if ((lastBranch != UINT64_MAX) && (instrCount - lastBranch < instrBufferSize))
+        if ((bookkeeping.lastBranch != UINT64_MAX) && (instrCount - bookkeeping.lastBranch < instrBufferSize))
         {
-            Vertex prev_br_vertex(VertexType::InstrCommit, lastBranch);
+            Vertex prev_br_vertex(VertexType::InstrCommit, bookkeeping.lastBranch);
             OutgoingEdge non_speculative_load(mem_vertex, 0);
-            addEdge(prev_br_vertex, non_speculative_load);
+            stageEdge(prev_br_vertex, non_speculative_load);
         }
 
         // Additional constraint: load requests are only sent when they are at ROB head
@@ -816,7 +793,7 @@ bool O3CoreGraphAdvanced::modelMemoryOrderConstraint(Instruction* instr, Vertex&
         {
             Vertex prev_instr_vertex(VertexType::InstrCommit, instrCount - 1);
             OutgoingEdge head_load(mem_vertex, 0);
-            addEdge(prev_instr_vertex, head_load);
+            stageEdge(prev_instr_vertex, head_load);
         }
     }
     */
@@ -824,47 +801,47 @@ bool O3CoreGraphAdvanced::modelMemoryOrderConstraint(Instruction* instr, Vertex&
     return store_to_load_forwarding;
 }
 
-void O3CoreGraphAdvanced::trackDataDependencies(Instruction* instr,
+template <uint32_t W>
+void O3CoreGraphAdvanced<W>::trackDataDependencies(Instruction* instr,
                                                 Vertex& execute_vertex, Vertex& mem_vertex)
 {
     // Check for data dependence through registers
     for (uint32_t i = 0; i < instr->regReadCount; ++i)
     {
-        int reg_read = instr->regRead[i];
-        if ((regLastWrittenBy.count(reg_read) != 0) &&
-            (instrCount - regLastWrittenBy[reg_read].first < instrBufferSize))
+        const RegisterProducer& producer = bookkeeping.producer(instr->regRead[i]);
+        if ((producer.instrNum != UINT64_MAX) &&
+            (instrCount - producer.instrNum < instrBufferSize))
         {
             //cout << "Register data dependence: " << instrCount << " to "
-            //     << regLastWrittenBy[reg_read].first << endl;
+            //     << producer.instrNum << endl;
             uint32_t weight; // Not differentiating between address and value registers for stores
-            weight = regLastWrittenBy[reg_read].second;
+            weight = producer.cycles;
   
-            if (regLastWrittenByLoad[reg_read])
+            if (producer.isLoad)
             {
-                Vertex prev_mem_vertex(VertexType::MemExecute,
-                                       regLastWrittenBy[reg_read].first);
+                Vertex prev_mem_vertex(VertexType::MemExecute, producer.instrNum);
                 OutgoingEdge dependence_edge(execute_vertex, (int64_t)weight);
-                addEdge(prev_mem_vertex, dependence_edge);
+                stageEdge(prev_mem_vertex, dependence_edge);
             }
             else
             {
-                Vertex prev_execute_vertex(VertexType::InstrExecute,
-                                           regLastWrittenBy[reg_read].first);
+                Vertex prev_execute_vertex(VertexType::InstrExecute, producer.instrNum);
                 OutgoingEdge dependence_edge(execute_vertex, (int64_t)weight);
-                addEdge(prev_execute_vertex, dependence_edge);
+                stageEdge(prev_execute_vertex, dependence_edge);
             }
         }
     }
 }
 
-pair<uint32_t, bool> O3CoreGraphAdvanced::modelResourceDependencies()
+template <uint32_t W>
+pair<uint32_t, bool> O3CoreGraphAdvanced<W>::modelResourceDependencies()
 {
     sys_nanoseconds my_time = chrono::system_clock::now();
  
-    uint64_t orderly_scheduled_instr_count_vec[VECTOR_WIDTH] = {};
-    bool all_scheduled_vec[VECTOR_WIDTH] = {};
+    uint64_t orderly_scheduled_instr_count_vec[W] = {};
+    bool all_scheduled_vec[W] = {};
 
-    for (uint32_t i = 0; i < VECTOR_WIDTH; ++i)
+    for (uint32_t i = 0; i < W; ++i)
     {
         // All instructions before headScheduledInstr (in all configuration scenarios
         // represented by different vector elements) have already been scheduled. In
@@ -891,7 +868,7 @@ pair<uint32_t, bool> O3CoreGraphAdvanced::modelResourceDependencies()
                                << ", " << curr_instr);
             }
             scheduleOrder[i].erase(scheduleOrder[i].begin());
-            alreadyScheduled[i].emplace(curr_instr);
+            alreadyScheduled[i].set(curr_instr);
             if (maxSchedInstrNum[i] < curr_instr)
             {
                 maxSchedInstrNum[i] = curr_instr;
@@ -1037,22 +1014,8 @@ pair<uint32_t, bool> O3CoreGraphAdvanced::modelResourceDependencies()
             if (curr_instr == headScheduledInstr)
             {
                 scheduled_enough = true;
-                uint64_t current_head = headScheduledInstr;
-                auto it = alreadyScheduled[i].begin();
-                do
-                {
-                    if (*it - current_head == 0)
-                    {
-                        ++current_head;
-                        ++orderly_scheduled_instr_count_vec[i];
-                    }
-                    else
-                    {
-                        break;
-                    }
-                    ++it;
-                } while (it != alreadyScheduled[i].end());
-
+                orderly_scheduled_instr_count_vec[i] =
+                    alreadyScheduled[i].countRun(headScheduledInstr);
             }
             if (scheduleOrder[i].empty())
             {
@@ -1066,7 +1029,7 @@ pair<uint32_t, bool> O3CoreGraphAdvanced::modelResourceDependencies()
     // headScheduledInstr is incremented by that amount.
     uint64_t scheduled_instr_count = UINT64_MAX;
     bool all_scheduled = true;
-    for (uint32_t i = 0; i < VECTOR_WIDTH; ++i)
+    for (uint32_t i = 0; i < W; ++i)
     {
         if (scheduled_instr_count > orderly_scheduled_instr_count_vec[i])
         {
@@ -1078,12 +1041,9 @@ pair<uint32_t, bool> O3CoreGraphAdvanced::modelResourceDependencies()
         }
     }
 
-    for (uint32_t i = 0; i < VECTOR_WIDTH; ++i)
+    for (uint32_t i = 0; i < W; ++i)
     {
-        for (uint64_t j = 0; j < scheduled_instr_count; ++j)
-        {
-            alreadyScheduled[i].erase(alreadyScheduled[i].begin());
-        }
+        alreadyScheduled[i].clearRange(headScheduledInstr, scheduled_instr_count);
     }
 
     headScheduledInstr += scheduled_instr_count;
@@ -1111,8 +1071,8 @@ pair<uint32_t, bool> O3CoreGraphAdvanced::modelResourceDependencies()
         for (int j = 0; j <= VertexType::Last; ++j)
         {
             Vertex v(j, headInstr - AnalysisWindow + i);
-            graphChildren[v].clear();
-            graphParents[v].clear();
+            graphChildren.clear(slot(v));
+            graphParents.clear(slot(v));
             // Note that the hash of i and i + AnalysisWindow
             // is the same for the maps indexed by a vertex.
         }
@@ -1128,39 +1088,182 @@ pair<uint32_t, bool> O3CoreGraphAdvanced::modelResourceDependencies()
     return pair<uint32_t, bool>(read_new, all_scheduled);
 }
 
-void O3CoreGraphAdvanced::addEdge(Vertex& parent, OutgoingEdge& e)
+template <uint32_t W>
+template <class P>
+void O3CoreGraphAdvanced<W>::modelTrace()
+{
+    typename P::Stream* stream = static_cast<typename P::Stream*>(instrStream);
+    sys_nanoseconds my_time;
+
+    while (true)
+    {
+        if (instrCount % 100000 == 0)
+        {
+            CALIPERS_INFO("*** " << instrCount
+                          << " instructions modeled" << endl);
+        }
+
+        stagedBundle = &bundles.claim();
+        stagedBundle->instrNum = instrCount;
+        stagedBundle->edges.clear();
+
+        my_time = chrono::system_clock::now();
+        Instruction* instr = stream->next();
+        streamTime += (chrono::system_clock::now() - my_time).count();
+
+        stagedBundle->endOfTrace = (instr == NULL);
+        if (instr != NULL)
+        {
+            model<P>(instr);
+        }
+        bundles.publish();
+
+        if (instr == NULL)
+        {
+            break;
+        }
+        ++instrCount;
+    }
+}
+
+template <uint32_t W>
+bool O3CoreGraphAdvanced<W>::consumeBundle()
+{
+    EdgeBundle& bundle = bundles.front();
+    if (bundle.endOfTrace)
+    {
+        bundles.release();
+        return false;
+    }
+
+    sys_nanoseconds my_time = chrono::system_clock::now();
+
+    uint64_t position = bundle.instrNum % AnalysisWindow;
+    executionType[position] = bundle.executionType;
+    executionCycles[position] = bundle.executionCycles;
+    if (bundle.lsCycles != UINT32_MAX)
+    {
+        lsCycles[position] = bundle.lsCycles;
+    }
+
+    for (auto& edge : bundle.edges)
+    {
+        addEdge(edge.first, edge.second);
+    }
+    calculateInstructionCriticalPath(bundle.instrNum);
+
+    bundles.release();
+
+    graphAnalysisTime += (chrono::system_clock::now() - my_time).count();
+
+    return true;
+}
+
+template <uint32_t W>
+void O3CoreGraphAdvanced<W>::stageEdge(Vertex& parent, OutgoingEdge& e)
+{
+    stagedBundle->edges.emplace_back(parent, e);
+}
+
+template <uint32_t W>
+void O3CoreGraphAdvanced<W>::addEdge(Vertex& parent, OutgoingEdge& e)
 {
     //printEdge(parent, e);
 
-    graphChildren[parent].push_back(e);
+    graphChildren.push_back(slot(parent), e);
     Vertex& child = e.child;
     IncomingEdge to_child_edge(parent, e.weight);
-    graphParents[child].push_back(to_child_edge);
+    graphParents.push_back(slot(child), to_child_edge);
 }
 
-void O3CoreGraphAdvanced::calculateInstructionCriticalPath()
+template <uint32_t W>
+void O3CoreGraphAdvanced<W>::calculateInstructionCriticalPath(uint64_t instr_num)
 {
     for (int i = 0; i <= VertexType::Last; ++i)
     {
-        Vertex child(i, instrCount);
-        for (uint32_t j = 0; j < graphParents[child].size(); ++j)
+        Vertex child(i, instr_num);
+        uint64_t child_slot = slot(child);
+        for (uint32_t k = 0; k < W; ++k)
         {
-            Vertex& parent = graphParents[child][j].parent;
-            OutgoingEdge e(child, graphParents[child][j].weight);
-            updateCriticalPathCycles(parent, e);
+            criticalParent[k][child_slot] = 0; // Any parent takes over
+        }
+        for (uint32_t j = 0; j < graphParents.size(child_slot); ++j)
+        {
+            IncomingEdge& parent_edge = graphParents.at(child_slot, j);
+            Vertex& parent = parent_edge.parent;
+            OutgoingEdge e(child, parent_edge.weight);
+            relaxEdge(parent, e);
         }
         if (i == VertexType::InstrExecute)
         {
-            for (uint32_t k = 0; k < VECTOR_WIDTH; ++k)
+            for (uint32_t k = 0; k < W; ++k)
+            {
+                scheduleOrder[k].insert(instr_num, absoluteLength(child, k));
+            }
+        }
+    }
+
+    Vertex commit_vertex(VertexType::InstrCommit, instr_num);
+    rebaseLengths(commit_vertex);
+}
+
+template <uint32_t W>
+LaneMask O3CoreGraphAdvanced<W>::relaxEdge(Vertex& parent, OutgoingEdge& e)
+{
+    // Relaxes e like updateCriticalPathCycles, but a path as long as the one to the
+    // child only takes it over from a parent with a smaller vertex number (or the
+    // same one), like O3CoreGraph::takesOver. The breakdowns of tied paths then do
+    // not depend on the order in which the edges are relaxed. Returns the scenarios
+    // where the child took the path, i.e., where its length or breakdown may change.
+    Vertex& child = e.child;
+    VertexEntries parent_entries = vertexEntries(parent);
+    VertexEntries child_entries = vertexEntries(child);
+    uint64_t parent_number = vertexNumber(parent);
+    uint64_t child_slot = slot(child);
+    LaneMask taken = 0;
+    for (uint32_t i = 0; i < W; ++i)
+    {
+        if (e.weight[i] == EdgeWeight::ABSENT)
+        {
+            continue;
+        }
+        int32_t path_length = (*parent_entries.length)[i] + e.weight[i];
+        int32_t child_length = (*child_entries.length)[i];
+        if ((path_length > child_length) ||
+            ((path_length == child_length) && (parent_number >= criticalParent[i][child_slot])))
+        {
+            taken |= (LaneMask)1 << i;
+        }
+    }
+    if (taken == 0)
+    {
+        return 0;
+    }
+
+    int parent_execution_type = vertexExecutionType(parent);
+    if (taken == e.weight.template presentLanes<W>())
+    {
+        updateCriticalPathCycles(parent, child, parent_execution_type, e.weight,
+                                 parent_entries, child_entries);
+    }
+    for (uint32_t i = 0; i < W; ++i)
+    {
+        if ((taken >> i) & 1)
+        {
+            if (taken != e.weight.template presentLanes<W>())
             {
-                scheduleOrder[k].emplace_hint(scheduleOrder[k].cend(),
-                    pair<uint64_t, int64_t>(instrCount, length[child][k]));
+                EdgeWeight lane_weight((int64_t)e.weight[i], i);
+                updateCriticalPathCycles(parent, child, parent_execution_type, lane_weight,
+                                         parent_entries, child_entries);
             }
+            criticalParent[i][child_slot] = parent_number;
         }
     }
+    return taken;
 }
 
-void O3CoreGraphAdvanced::updateCriticalPath(uint32_t idx,
+template <uint32_t W>
+void O3CoreGraphAdvanced<W>::updateCriticalPath(uint32_t idx,
                                              Vertex* parent1, OutgoingEdge* e1,
                                              Vertex* parent2, OutgoingEdge* e2,
                                              Vertex* parent3, OutgoingEdge* e3)
@@ -1170,89 +1273,73 @@ void O3CoreGraphAdvanced::updateCriticalPath(uint32_t idx,
         return;
     }
 
+    // The child changes if it takes the path of one of the new edges (a longer
+    // one, or a tied one from a later parent; see relaxEdge), which may change
+    // the breakdowns of its descendants even if their lengths stay the same
     Vertex child;
-    int64_t prev_length;
-    bool length_changed = false;
+    bool child_changed = false;
 
     if (parent1 != NULL)
     {
         child = e1->child; // Should be the same as e2->child or e3->child
-        prev_length = length[child][idx];
-        updateCriticalPathCycles(*parent1, *e1);
-        if (prev_length != length[child][idx])
-        {
-            length_changed = true;
-        }
+        child_changed |= (relaxEdge(*parent1, *e1) >> idx) & 1;
     }
     if (parent2 != NULL)
     {
         child = e2->child; // Should be the same as e1->child or e3->child
-        prev_length = length[child][idx];
-        updateCriticalPathCycles(*parent2, *e2);
-        if (prev_length != length[child][idx])
-        {
-            length_changed = true;
-        }
+        child_changed |= (relaxEdge(*parent2, *e2) >> idx) & 1;
     }
     if (parent3 != NULL)
     {
         child = e3->child; // Should be the same as e1->child or e2->child
-        prev_length = length[child][idx];
-        updateCriticalPathCycles(*parent3, *e3);
-        if (prev_length != length[child][idx])
-        {
-            length_changed = true;
-        }
+        child_changed |= (relaxEdge(*parent3, *e3) >> idx) & 1;
     }
 
-    if (length_changed)
+    if (child_changed)
     {
         // Approach 1:
-        // Update the corresponding children and descendants in the scheduling list
-        list<Vertex> update_list;
-        update_list.push_back(child);
-        while (!update_list.empty())
+        // Update the corresponding children and descendants in the scheduling list.
+        // Vertices are visited in (instruction number, type) order, so almost all
+        // of them have their final length when visited and are relaxed only once.
+        // A resource edge may lead to an older instruction, though, so a vertex
+        // leaves the queue when visited and can be queued again.
+        uint64_t child_number = vertexNumber(child);
+        updateQueue.push(child_number);
+        updateQueued[VertexHash()(child)] = true;
+        while (!updateQueue.empty())
         {
-            Vertex& current_parent = update_list.front();
-            for (uint32_t i = 0; i < graphChildren[current_parent].size(); ++i)
+            uint64_t number = updateQueue.top();
+            updateQueue.pop();
+            Vertex current_parent(number % (VertexType::Last + 1),
+                                  number / (VertexType::Last + 1));
+            updateQueued[VertexHash()(current_parent)] = false;
+
+            if ((current_parent.type == VertexType::InstrExecute) && (number != child_number))
+            {
+                // Update current_parent for scheduling (once for all of its new lengths):
+                auto it = scheduleOrder[idx].find(current_parent.instrNum);
+                if (it == scheduleOrder[idx].end())
+                {
+                    CALIPERS_ERROR(
+                        "Child with outdated length not found in the scheduling list");
+                }
+                scheduleOrder[idx].erase(it);
+                scheduleOrder[idx].insert(current_parent.instrNum,
+                                          absoluteLength(current_parent, idx));
+            }
+
+            uint64_t parent_slot = slot(current_parent);
+            for (uint32_t i = 0; i < graphChildren.size(parent_slot); ++i)
             {
-                OutgoingEdge& e = graphChildren[current_parent][i];
+                OutgoingEdge& e = graphChildren.at(parent_slot, i);
                 Vertex& current_child = e.child;
-                prev_length = length[current_child][idx];
-                updateCriticalPathCycles(current_parent, e);
-                if (prev_length != length[current_child][idx])
+                if (((relaxEdge(current_parent, e) >> idx) & 1) &&
+                    !updateQueued[VertexHash()(current_child)])
                 {
-                    if (current_child.type == VertexType::InstrExecute)
-                    {
-                        // Update current_child for scheduling:
-                        auto it = scheduleOrder[idx].find(pair<uint64_t, int64_t>(
-                            current_child.instrNum, prev_length));
-                        if (it == scheduleOrder[idx].end())
-                        {
-                            //printEdge(current_parent, e);
-                            //it = scheduleOrder[idx].begin();
-                            //uint64_t count = 0;
-                            //while ((count < 10) && (it != scheduleOrder[idx].end()))
-                            //{
-                            //    count << it->first << " " << it->second << endl;
-                            //    ++it;
-                            //    ++count;
-                            //}
-
-                            CALIPERS_ERROR(
-                                "Child with outdated length not found in the scheduling list");
-                        }
-                        scheduleOrder[idx].erase(it);
-                        scheduleOrder[idx].emplace(pair<uint64_t, int64_t>(
-                            current_child.instrNum, length[current_child][idx]));
-                    }
-                    //if (current_child.type != VertexType::InstrCommit)
-                    {
-                        update_list.push_back(current_child);
-                    }
+                    updateQueue.push(vertexNumber(current_child));
+                    updateQueued[VertexHash()(current_child)] = true;
                 }
             }
-            update_list.erase(update_list.begin());
         }
 
         /*
@@ -1261,21 +1348,24 @@ void O3CoreGraphAdvanced::updateCriticalPath(uint32_t idx,
         for (int i = VertexType::InstrExecute; i <= VertexType::MemExecute; ++i)
         {
             Vertex parent(i, child.instrNum);
-            for (uint32_t j = 0; j < graphChildren[parent].size(); ++j)
+            for (uint32_t j = 0; j < graphChildren.size(slot(parent)); ++j)
             {
-                OutgoingEdge& e = graphChildren[parent][j];
+                OutgoingEdge& e = graphChildren.at(slot(parent), j);
                 updateCriticalPathCycles(parent, e);
             }
         }
         for (uint64_t i = child.instrNum; i < maxSchedInstrNum[idx]; ++i)
         {
             Vertex parent(VertexType::InstrCommit, i);
-            for (uint32_t j = 0; j < graphChildren[parent].size(); ++j)
+            for (uint32_t j = 0; j < graphChildren.size(slot(parent)); ++j)
             {
-                OutgoingEdge& e = graphChildren[parent][j];
+                OutgoingEdge& e = graphChildren.at(slot(parent), j);
                 updateCriticalPathCycles(parent, e);
             }
         }
         */
     }
 }
+
+#define INSTANTIATE_O3_CORE_GRAPH_ADVANCED(w) template class O3CoreGraphAdvanced<w>;
+FOR_EACH_VECTOR_WIDTH(INSTANTIATE_O3_CORE_GRAPH_ADVANCED)
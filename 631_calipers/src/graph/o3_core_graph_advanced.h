@@ -25,9 +25,17 @@
 #ifndef O3_CORE_GRAPH_ADVANCED
 #define O3_CORE_GRAPH_ADVANCED
 
+#include <queue>
+#include <thread>
+
 #include "graph.h"
 #include "calipers_defs.h"
 #include "scoreboard.h"
+#include "bit_ring.h"
+#include "vertex_slots.h"
+#include "handoff_ring.h"
+#include "model_policy.h"
+#include "pipeline_bookkeeping.h"
 
 /**
  * An out-of-order processor model based on gem5's DerivO3CPU
@@ -35,11 +43,59 @@
  * "sliding-window" analysis, i.e., graph construction and analysis
  * are done (simultaneosly) on a window of size OOO_SLIDIING_WINDOW
  * that slides from the beginning to the end of instructions in the
- * trace.
+ * trace. A producer thread models the instructions and hands the
+ * edges of each one over to the analysis (scheduling and critical
+ * path updates), which owns the graph. The producer is specialized for
+ * the configured caches and branch predictor (see ModelPolicy).
  */
-class O3CoreGraphAdvanced : public Graph
+template <uint32_t W>
+class O3CoreGraphAdvanced : public VectorGraph<W>
 {
   private:
+    template <class E, class S> friend class ModelPolicySelector;
+
+    using Graph::AnalysisWindow;
+    using typename Graph::VertexHash;
+    using typename Graph::VertexEqual;
+    using typename Graph::ScheduleSet;
+    using Graph::instrStream;
+    using Graph::icache;
+    using Graph::dcache;
+    using Graph::bp;
+    using Graph::l1iThreshold;
+    using Graph::l2iThreshold;
+    using Graph::l1dThreshold;
+    using Graph::l2dThreshold;
+    using Graph::intAluTotalCycles;
+    using Graph::executionType;
+    using Graph::instructionMix;
+    using Graph::streamTime;
+    using Graph::graphConstructionTime;
+    using Graph::graphAnalysisTime;
+    using Graph::instrCount;
+    using Graph::analyzedWindows;
+    using Graph::l1iMisses;
+    using Graph::l2iMisses;
+    using Graph::l1dMisses;
+    using Graph::l2dMisses;
+    using Graph::bpMisses;
+    using Graph::branchCount;
+    using Graph::vertexNumber;
+    using VectorGraph<W>::length;
+    using VectorGraph<W>::lengthBase;
+    using VectorGraph<W>::criticalPathCycles;
+    using VectorGraph<W>::criticalPathInstructions;
+    using VectorGraph<W>::lazyBreakdown;
+    using typename VectorGraph<W>::VertexEntries;
+    using VectorGraph<W>::updateCriticalPathCycles;
+    using VectorGraph<W>::vertexEntries;
+    using VectorGraph<W>::vertexExecutionType;
+    using VectorGraph<W>::resetPredecessorLog;
+    using VectorGraph<W>::rebaseLengths;
+    using VectorGraph<W>::absoluteLength;
+    using VectorGraph<W>::recordStats;
+    using VectorGraph<W>::printEdge;
+
     /*** Microarchitectural parameters ***/
 
     uint32_t instrBufferSize; // Bandwidth is in instructions per cycle
@@ -60,30 +116,18 @@ class O3CoreGraphAdvanced : public Graph
     string icacheConfig;
     int dcacheType;
     string dcacheConfig;
-    Scoreboard scoreboard[VECTOR_WIDTH]; // Also performs bookkeeping
+    Scoreboard scoreboard[W]; // Also performs bookkeeping
+
+    void (O3CoreGraphAdvanced::*traceModeler)();
+    // The instantiation of modelTrace (the producer) for the configured caches
+    // and branch predictor
 
 
     /*** Bookkeeping ***/
 
     uint64_t currentIcacheLine;
-    uint64_t lastMisprediction;
-    uint64_t lastBranch;
-    bool previousInstrMispredicted;
-    bool previousWasBranch;
-    uint64_t linearPC;
-    uint64_t lastMemLdSt;
     uint32_t prevExecutionCycles;
-
-    unordered_map<int, pair<uint64_t, uint32_t>> regLastWrittenBy;
-    // Key: Register, Value: <Instruction number, Execution cycles>
-
-    unordered_map<int, bool> regLastWrittenByLoad;
-    // Key: Register, Value: Whether it was written by a load
-
-    pair<uint64_t,                              // First: Load/store number 
-         pair<uint64_t, uint32_t>>* ldStWindow; // Second: <Base, Length> of address
-    bool* ldStWindowType; // Is load?
-    uint32_t ldStWindowPointer;
+    PipelineBookkeeping bookkeeping; // Register producers, loads/stores and branches
 
     unordered_map<uint64_t, uint32_t> lsCycles;
     // Key: Instruction number % AnalysisWindow, Value: Load/store cycles (UINT32_MAX for invalid)
@@ -94,13 +138,13 @@ class O3CoreGraphAdvanced : public Graph
 
     /*** Graph-related data structures ***/
 
-    unordered_map<Vertex, vector<OutgoingEdge>, VertexHash, VertexEqual> graphChildren;
-    // graphChildren[v] = Vector of children of Vertex v
+    VertexSlots<OutgoingEdge, 4> graphChildren;
+    // The children of Vertex v are in slot(v)
 
-    unordered_map<Vertex, vector<IncomingEdge>, VertexHash, VertexEqual> graphParents;
-    // graphParents[v] = Vector of parents of Vertex v
+    VertexSlots<IncomingEdge, 4> graphParents;
+    // The parents of Vertex v are in slot(v)
 
-    ScheduleSet scheduleOrder[VECTOR_WIDTH];
+    ScheduleSet scheduleOrder[W];
     // The set(s) of <instruction number, critical path length> pairs sorted based on length
 
     uint64_t headInstr;
@@ -109,26 +153,70 @@ class O3CoreGraphAdvanced : public Graph
     uint64_t headScheduledInstr;
     // All intructions before headScheduledInstr have been scheduled.
 
-    set<uint64_t> alreadyScheduled[VECTOR_WIDTH];
-    // The set(s) of instructions (starting from headScheduledInstr) that have been scheduled
+    BitRing alreadyScheduled[W];
+    // The instructions (starting from headScheduledInstr) that have been scheduled,
+    // one bit per instruction
 
-    uint64_t maxSchedInstrNum[VECTOR_WIDTH];
+    uint64_t maxSchedInstrNum[W];
     // The instruction(s) with the greatest number that has been scheduled
 
+    priority_queue<uint64_t, vector<uint64_t>, greater<uint64_t>> updateQueue;
+    // The vertices (by vertex number) whose children must be updated after a
+    // length change, smallest first
+
+    vector<bool> updateQueued;
+    // Index: Window position of a vertex (see VertexHash), Value: Whether it is in updateQueue
+
+    vector<uint64_t> criticalParent[W];
+    // Index: Window position of a vertex, Value: The vertex number of the parent whose
+    // edge set the length (and breakdown) of the vertex in scenario i (see relaxEdge)
+
+
+    /*** Modeling/analysis pipeline ***/
+
+    typedef struct EDGE_BUNDLE
+    {
+        uint64_t instrNum;
+        bool endOfTrace; // No instruction, the producer has reached the end of the trace
+        int executionType;
+        uint32_t executionCycles;
+        uint32_t lsCycles; // UINT32_MAX for instructions other than loads/stores
+        vector<pair<Vertex, OutgoingEdge>> edges; // <Parent, Edge>
+    } EdgeBundle;
+
+    HandoffRing<EdgeBundle> bundles;
+    // The modeled instructions not yet brought into the analysis window. It holds
+    // AnalysisWindow / 4 bundles, i.e., the producer runs at most one refill ahead.
+
+    EdgeBundle* stagedBundle;
+    // The bundle of the instruction being modeled (producer only)
+
+
+    uint64_t slot(const Vertex& v)
+    {
+        return VertexHash()(v);
+    }
 
     void initBookKeeping();
     void initScoreboard();
-    void model(Instruction* instr);
+    template <class P> void modelTrace();
+    template <class P> void model(Instruction* instr);
+    template <class P> bool predictBranch(Instruction* instr, bool is_branch);
+    template <class P> uint32_t fetchCycles(Instruction* instr);
+    void modelInstruction(Instruction* instr, const InstructionTiming& timing);
     void modelPipeline(Vertex& fetch_vertex, Vertex& dispatch_vertex,
                        Vertex& execute_vertex, Vertex& mem_vertex,
                        Vertex& commit_vertex, Instruction* instr,
-                       uint32_t execution_cycles);
+                       uint32_t execution_cycles, const InstructionTiming& timing);
     bool modelMemoryOrderConstraint(Instruction* instr, Vertex& mem_vertex);
     void trackDataDependencies(Instruction* instr,
                                Vertex& execute_vertex, Vertex& mem_vertex);
     pair<uint32_t, bool> modelResourceDependencies();
+    void stageEdge(Vertex& parent, OutgoingEdge& e);
     void addEdge(Vertex& parent, OutgoingEdge& e);
-    void calculateInstructionCriticalPath();
+    bool consumeBundle();
+    void calculateInstructionCriticalPath(uint64_t instr_num);
+    LaneMask relaxEdge(Vertex& parent, OutgoingEdge& e);
     void updateCriticalPath(uint32_t idx,
                             Vertex* parent1, OutgoingEdge* e1,
                             Vertex* parent2, OutgoingEdge* e2,
@@ -166,6 +254,9 @@ class O3CoreGraphAdvanced : public Graph
                         string dcache_config);
     ~O3CoreGraphAdvanced();
     void run();
+
+    static uint64_t windowBytes(uint64_t window_instructions);
+    // The memory needed for a window of the given size (see main's select_engine)
 };
 
 
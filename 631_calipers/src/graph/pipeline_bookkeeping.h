@@ -0,0 +1,376 @@
+/**
+ * Copyright (c) Microsoft Corporation.
+ * 
+ * MIT License
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PIPELINE_BOOKKEEPING_H
+#define PIPELINE_BOOKKEEPING_H
+
+#include <cstdint>
+#include <vector>
+
+#include "calipers_defs.h"
+
+using namespace std;
+
+
+typedef struct REGISTER_PRODUCER
+{
+    uint64_t instrNum; // UINT64_MAX if the register has not been written
+    uint32_t cycles; // The cycles after which the value can be used
+    bool isLoad; // Whether the register was written by a load
+} RegisterProducer;
+
+typedef struct LD_ST_ENTRY
+{
+    uint64_t instrNum; // UINT64_MAX for an empty entry
+    uint64_t base;
+    uint32_t length;
+    uint32_t cycles; // Access cycles
+    bool isLoad;
+
+    uint64_t firstWord; // The first word (LDST_WORD_BYTES) of the address index it is in
+    uint32_t wordCount; // Words of the address index it is in (0: not indexed, UINT32_MAX: too wide)
+    uint64_t olderInWord[LDST_MAX_WORDS];
+    // olderInWord[i] = The previous load/store (by sequence number) in word firstWord + i
+} LdStEntry;
+
+
+/**
+ * The state that the core models track about the instructions modeled so far
+ * The last producer of each register is kept in a flat table indexed by the
+ * register number, and the most recent loads/stores in a fixed ring (as many
+ * as fit in the load/store queues), so neither allocates per instruction.
+ *
+ * If enabled, the loads/stores of the ring are also indexed by the words they
+ * access: an open-addressing table maps a word to the youngest load/store in
+ * it, and each load/store links to the previous one in each of its words. The
+ * youngest older load/store with a common address is then found by following
+ * a few links instead of scanning the whole ring. Loads/stores leave the
+ * index when the ring overwrites them; links to them are recognized as stale
+ * by their sequence numbers.
+ */
+class PipelineBookkeeping
+{
+  private:
+    alignas(64) RegisterProducer producers[MAX_REGISTERS];
+
+    vector<LdStEntry> ldStWindow;
+    uint32_t ldStWindowPointer; // The slot of the next load/store (i.e., of the oldest one)
+    uint64_t ldStCount; // Sequence number of the next load/store (slot: sequence % size)
+
+    bool indexAddresses;
+    vector<pair<uint64_t, uint64_t>> wordIndex;
+    // Open addressing with linear probing
+    // First: Word (UINT64_MAX for an empty bucket), Second: Youngest load/store sequence in it
+    uint64_t wordIndexMask;
+    uint32_t wideLdSts; // Loads/stores in the ring that span more than LDST_MAX_WORDS words
+
+    static void checkRegister(int reg)
+    {
+        if ((uint32_t)reg >= MAX_REGISTERS)
+        {
+            CALIPERS_ERROR("Register number " << reg << " out of range");
+        }
+    }
+
+    // Whether the access shares an address with a previous load/store (the
+    // check the memory order constraints have always used)
+    static bool sharesAddress(uint64_t base, uint32_t length, const LdStEntry& previous)
+    {
+        uint64_t prev_base = previous.base;
+        uint64_t prev_length = previous.length;
+        return ((base >= prev_base) && (base < prev_base + prev_length)) ||
+               ((base + length > prev_base) && (base + length <= prev_base + prev_length));
+    }
+
+    // The words in which an access may share an address with a previous
+    // load/store. A zero-length access can match one that ends at its base.
+    static void lookupWords(uint64_t base, uint32_t length, uint64_t& first, uint64_t& last)
+    {
+        uint64_t first_byte = ((length == 0) && (base != 0)) ? base - 1 : base;
+        uint64_t last_byte = (length == 0) ? base : base + length - 1;
+        first = first_byte / LDST_WORD_BYTES;
+        last = last_byte / LDST_WORD_BYTES;
+    }
+
+    bool isLive(uint64_t sequence) const
+    {
+        return (sequence != UINT64_MAX) && (ldStCount - sequence <= ldStWindow.size());
+    }
+
+    uint64_t bucketOf(uint64_t word) const
+    {
+        return ((word * 0x9E3779B97F4A7C15ull) >> 32) & wordIndexMask;
+    }
+
+    // The bucket of the word, or the empty bucket where it would be inserted
+    uint64_t findBucket(uint64_t word) const
+    {
+        uint64_t bucket = bucketOf(word);
+        while ((wordIndex[bucket].first != word) && (wordIndex[bucket].first != UINT64_MAX))
+        {
+            bucket = (bucket + 1) & wordIndexMask;
+        }
+        return bucket;
+    }
+
+    void eraseBucket(uint64_t bucket)
+    {
+        // Backward shift deletion: moves back the entries that probed past the bucket
+        uint64_t next = bucket;
+        while (true)
+        {
+            next = (next + 1) & wordIndexMask;
+            if (wordIndex[next].first == UINT64_MAX)
+            {
+                break;
+            }
+            uint64_t home = bucketOf(wordIndex[next].first);
+            if (((next - home) & wordIndexMask) >= ((next - bucket) & wordIndexMask))
+            {
+                wordIndex[bucket] = wordIndex[next];
+                bucket = next;
+            }
+        }
+        wordIndex[bucket].first = UINT64_MAX;
+    }
+
+    void indexLdSt(LdStEntry& entry, uint64_t sequence)
+    {
+        entry.wordCount = 0;
+        if (entry.length == 0) // Never shares an address with a later access
+        {
+            return;
+        }
+
+        uint64_t last_word;
+        lookupWords(entry.base, entry.length, entry.firstWord, last_word);
+        if (last_word - entry.firstWord >= LDST_MAX_WORDS)
+        {
+            entry.wordCount = UINT32_MAX;
+            ++wideLdSts;
+            return;
+        }
+
+        entry.wordCount = last_word - entry.firstWord + 1;
+        for (uint32_t i = 0; i < entry.wordCount; ++i)
+        {
+            uint64_t bucket = findBucket(entry.firstWord + i);
+            entry.olderInWord[i] = (wordIndex[bucket].first == UINT64_MAX) ?
+                                   UINT64_MAX : wordIndex[bucket].second;
+            wordIndex[bucket].first = entry.firstWord + i;
+            wordIndex[bucket].second = sequence;
+        }
+    }
+
+    void unindexLdSt(const LdStEntry& entry, uint64_t sequence)
+    {
+        if (entry.wordCount == UINT32_MAX)
+        {
+            --wideLdSts;
+            return;
+        }
+
+        for (uint32_t i = 0; i < entry.wordCount; ++i)
+        {
+            // Younger loads/stores in the word still link to it, but see it as stale
+            uint64_t bucket = findBucket(entry.firstWord + i);
+            if (wordIndex[bucket].second == sequence)
+            {
+                eraseBucket(bucket);
+            }
+        }
+    }
+
+  public:
+    uint64_t lastMisprediction; // The last mispredicted branch (UINT64_MAX for none)
+    uint64_t lastBranch; // UINT64_MAX for none
+    uint64_t lastMemLdSt; // UINT64_MAX for none
+    bool previousInstrMispredicted;
+    bool previousWasBranch;
+    uint64_t linearPC; // The PC after the previous instruction
+
+    PipelineBookkeeping() : ldStWindowPointer(0), ldStCount(0), indexAddresses(false),
+                            wordIndexMask(0), wideLdSts(0)
+    {
+        reset();
+    }
+
+    // index_addresses: Whether youngestSharingAddress() should use the address index
+    void initLdStWindow(uint32_t size, bool index_addresses = false)
+    {
+        ldStWindow.resize(size);
+        indexAddresses = index_addresses;
+        if (indexAddresses)
+        {
+            // At most LDST_MAX_WORDS words per load/store, at most half of the buckets used
+            uint64_t buckets = 1;
+            while (buckets < 2 * LDST_MAX_WORDS * (uint64_t)size)
+            {
+                buckets *= 2;
+            }
+            wordIndex.resize(buckets);
+            wordIndexMask = buckets - 1;
+        }
+        reset();
+    }
+
+    // Forgets all instructions
+    void reset()
+    {
+        lastMisprediction = UINT64_MAX;
+        lastBranch = UINT64_MAX;
+        lastMemLdSt = UINT64_MAX;
+        previousInstrMispredicted = false;
+        previousWasBranch = false;
+        linearPC = 0;
+
+        for (uint32_t i = 0; i < MAX_REGISTERS; ++i)
+        {
+            producers[i].instrNum = UINT64_MAX;
+        }
+
+        for (auto& entry : ldStWindow)
+        {
+            entry.instrNum = UINT64_MAX;
+        }
+        ldStWindowPointer = 0;
+        ldStCount = 0;
+
+        for (auto& bucket : wordIndex)
+        {
+            bucket.first = UINT64_MAX;
+        }
+        wideLdSts = 0;
+    }
+
+    const RegisterProducer& producer(int reg) const
+    {
+        checkRegister(reg);
+        return producers[reg];
+    }
+
+    void setProducer(int reg, uint64_t instr_num, uint32_t cycles, bool is_load)
+    {
+        checkRegister(reg);
+        producers[reg].instrNum = instr_num;
+        producers[reg].cycles = cycles;
+        producers[reg].isLoad = is_load;
+    }
+
+    uint32_t ldStWindowSize() const
+    {
+        return ldStWindow.size();
+    }
+
+    // Age 0 is the youngest load/store and ldStWindowSize() - 1 the oldest
+    const LdStEntry& ldStByAge(uint32_t age) const
+    {
+        uint32_t size = ldStWindow.size();
+        return ldStWindow[(ldStWindowPointer + size - 1 - age) % size];
+    }
+
+    // The entries in the order of their slots
+    const LdStEntry& ldStSlot(uint32_t slot) const
+    {
+        return ldStWindow[slot];
+    }
+
+    // Replaces the oldest load/store
+    void pushLdSt(uint64_t instr_num, uint64_t base, uint32_t length,
+                  uint32_t cycles, bool is_load)
+    {
+        LdStEntry& entry = ldStWindow[ldStWindowPointer];
+        if (indexAddresses && (entry.instrNum != UINT64_MAX))
+        {
+            unindexLdSt(entry, ldStCount - ldStWindow.size());
+        }
+
+        entry.instrNum = instr_num;
+        entry.base = base;
+        entry.length = length;
+        entry.cycles = cycles;
+        entry.isLoad = is_load;
+        if (indexAddresses)
+        {
+            indexLdSt(entry, ldStCount);
+        }
+
+        ldStWindowPointer = (ldStWindowPointer + 1) % ldStWindow.size();
+        ++ldStCount;
+        lastMemLdSt = instr_num;
+    }
+
+    // The youngest load/store in the ring that shares an address with the
+    // access and, for a load (stores_only), is a store. NULL if there is none.
+    const LdStEntry* youngestSharingAddress(uint64_t base, uint32_t length,
+                                            bool stores_only) const
+    {
+        uint64_t first_word, last_word;
+        lookupWords(base, length, first_word, last_word);
+
+        if (!indexAddresses || (wideLdSts != 0) || (last_word - first_word >= LDST_MAX_WORDS))
+        {
+            for (uint32_t i = 0; i < ldStWindow.size(); ++i)
+            {
+                const LdStEntry& previous = ldStByAge(i);
+                if (previous.instrNum == UINT64_MAX)
+                {
+                    break;
+                }
+                if ((!stores_only || !previous.isLoad) && sharesAddress(base, length, previous))
+                {
+                    return &previous;
+                }
+            }
+            return NULL;
+        }
+
+        const LdStEntry* youngest = NULL;
+        uint64_t youngest_sequence = 0;
+        for (uint64_t word = first_word; word <= last_word; ++word)
+        {
+            uint64_t bucket = findBucket(word);
+            uint64_t sequence = (wordIndex[bucket].first == UINT64_MAX) ?
+                                UINT64_MAX : wordIndex[bucket].second;
+
+            // The loads/stores in the word, from the youngest, until an older
+            // match was found in a previous word
+            while (isLive(sequence) && ((youngest == NULL) || (sequence > youngest_sequence)))
+            {
+                const LdStEntry& previous = ldStWindow[sequence % ldStWindow.size()];
+                if ((!stores_only || !previous.isLoad) && sharesAddress(base, length, previous))
+                {
+                    youngest = &previous;
+                    youngest_sequence = sequence;
+                    break;
+                }
+                sequence = previous.olderInWord[word - previous.firstWord];
+            }
+        }
+        return youngest;
+    }
+};
+
+
+#endif // PIPELINE_BOOKKEEPING_H
@@ -0,0 +1,361 @@
+/**
+ * Copyright (c) Microsoft Corporation.
+ * 
+ * MIT License
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SCHEDULE_QUEUE_H
+#define SCHEDULE_QUEUE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "calipers_defs.h"
+
+using namespace std;
+
+
+/**
+ * A bucket queue of <instruction number, critical path length> pairs, ordered
+ * by length and then by instruction number
+ * There is a bucket per length, kept in a ring of buckets that covers the
+ * range of queued lengths (a bitmap tells the occupied buckets apart).
+ * The nodes are intrusive: the node of an instruction is found from its
+ * number, so finding, erasing and re-inserting an instruction need neither
+ * a search nor an allocation. Both rings grow (by doubling) when needed.
+ * Inserting may invalidate the iterators.
+ */
+class ScheduleQueue
+{
+  private:
+    static constexpr uint32_t NIL = UINT32_MAX;
+    static constexpr uint64_t FREE = UINT64_MAX;
+    static constexpr int64_t NO_LENGTH = INT64_MAX;
+
+    typedef struct SCHEDULE_NODE
+    {
+        pair<uint64_t, int64_t> entry;
+        // First: Instruction number (FREE for an unused node), Second: Critical path length
+
+        uint32_t prev; // The nodes of a bucket form a circular list
+        uint32_t next; // sorted by instruction number
+    } ScheduleNode;
+
+    vector<ScheduleNode> nodes;
+    // nodes[instruction number % nodes.size()] = The node of a queued instruction
+
+    vector<uint32_t> buckets;
+    // buckets[length % buckets.size()] = The first node with that length (if occupied)
+
+    vector<uint64_t> occupied;
+    // Bit b of occupied[b / 64] = Whether buckets[b] has any node
+
+    int64_t minLength; // No queued length is smaller
+    int64_t maxLength; // No queued length is larger
+    uint64_t count;
+
+    uint32_t slot(uint64_t instr_num) const
+    {
+        return instr_num & (nodes.size() - 1);
+    }
+
+    uint32_t bucket(int64_t length) const
+    {
+        return (uint64_t)length & (buckets.size() - 1);
+    }
+
+    bool isOccupied(uint32_t b) const
+    {
+        return (occupied[b >> 6] >> (b & 63)) & 1;
+    }
+
+    // The smallest occupied length in [from, maxLength] (NO_LENGTH if none)
+    int64_t firstOccupied(int64_t from) const
+    {
+        int64_t length = from;
+        while (length <= maxLength)
+        {
+            uint32_t b = bucket(length);
+            uint64_t word = occupied[b >> 6] >> (b & 63);
+            if (word != 0)
+            {
+                length += __builtin_ctzll(word);
+                return (length <= maxLength) ? length : NO_LENGTH;
+            }
+            length += 64 - (b & 63);
+        }
+        return NO_LENGTH;
+    }
+
+    // The largest occupied length in [minLength, from] (NO_LENGTH if none)
+    int64_t lastOccupied(int64_t from) const
+    {
+        int64_t length = from;
+        while (length >= minLength)
+        {
+            uint32_t b = bucket(length);
+            uint64_t word = occupied[b >> 6] << (63 - (b & 63));
+            if (word != 0)
+            {
+                length -= __builtin_clzll(word);
+                return (length >= minLength) ? length : NO_LENGTH;
+            }
+            length -= (b & 63) + 1;
+        }
+        return NO_LENGTH;
+    }
+
+    void link(uint32_t s)
+    {
+        uint32_t b = bucket(nodes[s].entry.second);
+        if (!isOccupied(b))
+        {
+            buckets[b] = s;
+            nodes[s].prev = s;
+            nodes[s].next = s;
+            occupied[b >> 6] |= (uint64_t)1 << (b & 63);
+            return;
+        }
+
+        // Instructions are mostly inserted in order, i.e., after the last node
+        uint64_t instr_num = nodes[s].entry.first;
+        uint32_t head = buckets[b];
+        uint32_t n = head;
+        if (nodes[nodes[head].prev].entry.first > instr_num)
+        {
+            while (nodes[n].entry.first < instr_num)
+            {
+                n = nodes[n].next;
+            }
+            if (n == head)
+            {
+                buckets[b] = s;
+            }
+        }
+        nodes[s].prev = nodes[n].prev;
+        nodes[s].next = n;
+        nodes[nodes[n].prev].next = s;
+        nodes[n].prev = s;
+    }
+
+    void unlink(uint32_t s)
+    {
+        uint32_t b = bucket(nodes[s].entry.second);
+        if (nodes[s].next == s)
+        {
+            occupied[b >> 6] &= ~((uint64_t)1 << (b & 63));
+            return;
+        }
+        nodes[nodes[s].prev].next = nodes[s].next;
+        nodes[nodes[s].next].prev = nodes[s].prev;
+        if (buckets[b] == s)
+        {
+            buckets[b] = nodes[s].next;
+        }
+    }
+
+    // Resizes the rings and links the queued nodes again
+    void rebuild(uint64_t node_count, uint64_t bucket_count)
+    {
+        vector<pair<uint64_t, int64_t>> entries;
+        entries.reserve(count);
+        for (ScheduleNode& node : nodes)
+        {
+            if (node.entry.first != FREE)
+            {
+                entries.push_back(node.entry);
+            }
+        }
+
+        while (true)
+        {
+            nodes.assign(node_count, {pair<uint64_t, int64_t>(FREE, 0), NIL, NIL});
+            buckets.assign(bucket_count, NIL);
+            occupied.assign(bucket_count / 64, 0);
+
+            bool collision = false;
+            for (auto& entry : entries)
+            {
+                uint32_t s = slot(entry.first);
+                if (nodes[s].entry.first != FREE)
+                {
+                    collision = true;
+                    break;
+                }
+                nodes[s].entry = entry;
+                link(s);
+            }
+            if (!collision)
+            {
+                return;
+            }
+            node_count *= 2;
+        }
+    }
+
+  public:
+    class iterator
+    {
+      private:
+        ScheduleQueue* queue;
+        uint32_t s;
+
+      public:
+        iterator() : queue(NULL), s(NIL) {}
+        iterator(ScheduleQueue* queue, uint32_t s) : queue(queue), s(s) {}
+
+        const pair<uint64_t, int64_t>& operator*() const
+        {
+            return queue->nodes[s].entry;
+        }
+
+        const pair<uint64_t, int64_t>* operator->() const
+        {
+            return &queue->nodes[s].entry;
+        }
+
+        iterator& operator++()
+        {
+            int64_t length = queue->nodes[s].entry.second;
+            s = queue->nodes[s].next;
+            if (s == queue->buckets[queue->bucket(length)])
+            {
+                // Back to the first node of the bucket
+                length = queue->firstOccupied(length + 1);
+                s = (length == NO_LENGTH) ? NIL : queue->buckets[queue->bucket(length)];
+            }
+            return *this;
+        }
+
+        bool operator==(const iterator& other) const
+        {
+            return s == other.s;
+        }
+
+        bool operator!=(const iterator& other) const
+        {
+            return s != other.s;
+        }
+
+        friend class ScheduleQueue;
+    };
+
+    ScheduleQueue() : minLength(0), maxLength(0), count(0)
+    {
+        rebuild(1024, 1024);
+    }
+
+    void insert(uint64_t instr_num, int64_t length)
+    {
+        if (count == 0)
+        {
+            minLength = length;
+            maxLength = length;
+        }
+        else if ((uint64_t)(max(maxLength, length) - min(minLength, length)) >= buckets.size())
+        {
+            // The bounds may be loose after erasing, so tighten them before growing
+            minLength = firstOccupied(minLength);
+            maxLength = lastOccupied(maxLength);
+        }
+        minLength = min(minLength, length);
+        maxLength = max(maxLength, length);
+
+        uint64_t bucket_count = buckets.size();
+        while ((uint64_t)(maxLength - minLength) >= bucket_count)
+        {
+            bucket_count *= 2;
+        }
+        uint64_t node_count = nodes.size();
+        if (nodes[slot(instr_num)].entry.first != FREE)
+        {
+            if (nodes[slot(instr_num)].entry.first == instr_num)
+            {
+                CALIPERS_ERROR("Instruction already in the schedule queue");
+            }
+            node_count *= 2;
+        }
+        if ((bucket_count != buckets.size()) || (node_count != nodes.size()))
+        {
+            rebuild(node_count, bucket_count);
+            while (nodes[slot(instr_num)].entry.first != FREE)
+            {
+                rebuild(nodes.size() * 2, bucket_count);
+            }
+        }
+
+        uint32_t s = slot(instr_num);
+        nodes[s].entry = pair<uint64_t, int64_t>(instr_num, length);
+        link(s);
+        ++count;
+    }
+
+    iterator find(uint64_t instr_num)
+    {
+        uint32_t s = slot(instr_num);
+        return iterator(this, (nodes[s].entry.first == instr_num) ? s : NIL);
+    }
+
+    void erase(iterator it)
+    {
+        unlink(it.s);
+        nodes[it.s].entry.first = FREE;
+        --count;
+    }
+
+    iterator begin()
+    {
+        if (count == 0)
+        {
+            return end();
+        }
+        minLength = firstOccupied(minLength);
+        return iterator(this, buckets[bucket(minLength)]);
+    }
+
+    iterator end()
+    {
+        return iterator(this, NIL);
+    }
+
+    bool empty() const
+    {
+        return count == 0;
+    }
+
+    uint64_t size() const
+    {
+        return count;
+    }
+
+    void clear()
+    {
+        for (ScheduleNode& node : nodes)
+        {
+            node.entry.first = FREE;
+        }
+        fill(occupied.begin(), occupied.end(), 0);
+        count = 0;
+    }
+};
+
+
+#endif // SCHEDULE_QUEUE_H
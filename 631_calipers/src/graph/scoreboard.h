@@ -21,11 +21,23 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
  * SOFTWARE.
  */
-
 #ifndef SCOREBOARD_H
 #define SCOREBOARD_H
 
 #include "calipers_defs.h"
+#include "calipers_types.h"
+
+
+// The resource whose units perform an operation type; multiplications and
+// divisions are mixed operations that share the units of one resource
+constexpr int executingResource(int operation_type)
+{
+    return ((operation_type == Resource::RscIntMul) ||
+            (operation_type == Resource::RscIntDiv)) ? Resource::RscIntMulDiv :
+           ((operation_type == Resource::RscFpMul) ||
+            (operation_type == Resource::RscFpDiv)) ? Resource::RscFpMulDiv :
+           operation_type;
+}
 
 
 /**
@@ -40,7 +52,7 @@ class Scoreboard
         uint32_t latency;
         bool pipelined;
         uint32_t nextAvailable;
-        uint64_t* assignedInstrNum;
+        uint64_t* assignedInstrNum; // NULL if the resource is not initialized
         int* assignedOp; // For resources that do a mixture of operations
     } ResourceInstance;
 
@@ -50,29 +62,46 @@ class Scoreboard
         uint32_t size;
         uint64_t* latency;
         uint32_t nextAvailable;
-        uint64_t* assignedInstrNum;
+        uint64_t* assignedInstrNum; // NULL if the queue is not initialized
     } QueueInstance;
 
-    unordered_map<int, ResourceInstance> resources;
-    // Key: Resource type (from enum Resource)
+    ResourceInstance resources[Resource::RscLast + 1];
+    // Index: Resource type (from enum Resource)
 
-    unordered_map<int, int> mixedOperationResource;
-    // Key: Operation type (from enum Resource)
-    // Value: Resource type (from enum Resource)
-
-    unordered_map<int, pair<uint32_t, bool>> mixedOperationSpec;
-    // Key: Operation type (from enum Resource)
+    pair<uint32_t, bool> mixedOperationSpec[Resource::RscLast + 1];
+    // Index: Operation type (from enum Resource)
     // Value.first: Operation latency
     // Value.second: Pipelined?
 
-    unordered_map<int, QueueInstance> queues;
-    // Key: Queue type (from enum QueueResource)
+    QueueInstance queues[QueueResource::RscQueueLast + 1];
+    // Index: Queue type (from enum QueueResource)
 
   public:
+    Scoreboard()
+    {
+        for (int i = 0; i <= Resource::RscLast; ++i)
+        {
+            resources[i].assignedInstrNum = NULL;
+            resources[i].assignedOp = NULL;
+            mixedOperationSpec[i] = pair<uint32_t, bool>(0, false);
+        }
+        for (int i = 0; i <= QueueResource::RscQueueLast; ++i)
+        {
+            queues[i].latency = NULL;
+            queues[i].assignedInstrNum = NULL;
+        }
+    }
+
     void setMixedOperation(int operation_type, int resource_type,
                            uint32_t latency, bool pipelined)
     {
-        if (resources.count(resource_type) == 0)
+        if ((executingResource(operation_type) != resource_type) ||
+            (operation_type == resource_type))
+        {
+            CALIPERS_ERROR("Invalid resource for the mixed operation");
+        }
+
+        if (resources[resource_type].assignedInstrNum == NULL)
         {
             CALIPERS_ERROR("Resource for the mixed operation not initialized yet");
         }
@@ -80,9 +109,12 @@ class Scoreboard
         if (resources[resource_type].assignedOp == NULL)
         {
             resources[resource_type].assignedOp = new int[resources[resource_type].count];
+            for (uint32_t i = 0; i < resources[resource_type].count; ++i)
+            {
+                resources[resource_type].assignedOp[i] = -1;
+            }
         }
 
-        mixedOperationResource[operation_type] = resource_type;
         mixedOperationSpec[operation_type].first = latency;
         mixedOperationSpec[operation_type].second = pipelined;
     }
@@ -90,7 +122,7 @@ class Scoreboard
     void initResource(int resource_type, uint32_t count,
                       uint32_t latency, bool pipelined)
     {
-        if (resources.count(resource_type) != 0)
+        if (resources[resource_type].assignedInstrNum != NULL)
         {
             CALIPERS_ERROR("Resource already initialized");
         }
@@ -114,7 +146,7 @@ class Scoreboard
 
     void initQueue(int type, uint32_t size)
     {
-        if (queues.count(type) != 0)
+        if (queues[type].assignedInstrNum != NULL)
         {
             CALIPERS_ERROR("Queue already initialized");
         }
@@ -138,46 +170,42 @@ class Scoreboard
     void scheduleResource(int operation_type, uint64_t instr_num,
                           uint64_t& previous_instr, uint32_t& wait_cycles)
     {
-        int resource_type;
-        uint32_t sample_num;
-        uint32_t latency;
-        bool pipelined;
+        int resource_type = executingResource(operation_type);
+        ResourceInstance& resource = resources[resource_type];
+        uint32_t sample_num = resource.nextAvailable;
+        uint32_t latency = resource.latency;
+        bool pipelined = resource.pipelined;
 
-        if (mixedOperationResource.count(operation_type) == 0)
+        if (resource_type != operation_type)
         {
-            resource_type = operation_type;
-            sample_num = resources[resource_type].nextAvailable;
-            latency = resources[resource_type].latency;
-            pipelined = resources[resource_type].pipelined;
-        }
-        else
-        {
-            resource_type = mixedOperationResource[operation_type];
-            sample_num = resources[resource_type].nextAvailable;
-            int previous_operation_type = resources[resource_type].assignedOp[sample_num];
-            latency = mixedOperationSpec[previous_operation_type].first;
-            pipelined = mixedOperationSpec[previous_operation_type].second;
-            resources[resource_type].assignedOp[sample_num] = operation_type;
+            // The unit is busy according to the operation it performed last
+            int previous_operation_type = resource.assignedOp[sample_num];
+            if (previous_operation_type != -1)
+            {
+                latency = mixedOperationSpec[previous_operation_type].first;
+                pipelined = mixedOperationSpec[previous_operation_type].second;
+            }
+            resource.assignedOp[sample_num] = operation_type;
         }
 
-        previous_instr = resources[resource_type].assignedInstrNum[sample_num];
+        previous_instr = resource.assignedInstrNum[sample_num];
         wait_cycles = pipelined ? 1 : latency;
 
-        resources[resource_type].assignedInstrNum[sample_num] = instr_num;
-        resources[resource_type].nextAvailable = (sample_num + 1) %
-                                                 resources[resource_type].count;
+        resource.assignedInstrNum[sample_num] = instr_num;
+        resource.nextAvailable = (sample_num + 1) % resource.count;
     }
 
     void scheduleQueue(int type, uint64_t instr_num, uint32_t latency,
                        uint64_t& previous_instr, uint32_t& wait_cycles)
     {
-        uint32_t entry = queues[type].nextAvailable;
-        previous_instr = queues[type].assignedInstrNum[entry];
-        wait_cycles = queues[type].latency[entry];
-
-        queues[type].nextAvailable = (entry + 1) % queues[type].size;
-        queues[type].assignedInstrNum[entry] = instr_num;
-        queues[type].latency[entry] = latency;
+        QueueInstance& queue = queues[type];
+        uint32_t entry = queue.nextAvailable;
+        previous_instr = queue.assignedInstrNum[entry];
+        wait_cycles = queue.latency[entry];
+
+        queue.nextAvailable = (entry + 1) % queue.size;
+        queue.assignedInstrNum[entry] = instr_num;
+        queue.latency[entry] = latency;
     }
 
     uint32_t getResourceCount(int type)
@@ -187,7 +215,7 @@ class Scoreboard
 
     uint32_t getResourceLatency(int type)
     {
-        if (mixedOperationResource.count(type) == 0)
+        if (executingResource(type) == type)
         {
             return resources[type].latency;
         }
@@ -204,21 +232,16 @@ class Scoreboard
 
     ~Scoreboard()
     {
-        for (auto it = resources.begin(); it != resources.end(); ++it)
+        for (int i = 0; i <= Resource::RscLast; ++i)
         {
-            int type = it->first;
-            delete[] resources[type].assignedInstrNum;
-            if (resources[type].assignedOp != NULL)
-            {
-                delete[] resources[type].assignedOp;
-            }
+            delete[] resources[i].assignedInstrNum;
+            delete[] resources[i].assignedOp;
         }
 
-        for (auto it = queues.begin(); it != queues.end(); ++it)
+        for (int i = 0; i <= QueueResource::RscQueueLast; ++i)
         {
-            int type = it->first;
-            delete[] queues[type].latency;
-            delete[] queues[type].assignedInstrNum;
+            delete[] queues[i].latency;
+            delete[] queues[i].assignedInstrNum;
         }
     }
 };
@@ -26,6 +26,7 @@
 #define SCOREBOARD_SIMPLE_H
 
 #include "calipers_defs.h"
+#include "calipers_types.h"
 
 
 /**
@@ -46,21 +47,30 @@ class ScoreboardSimple
     // The record of the units of a particular resrouce type
     typedef struct RESOURCE_RECORD
     {
-        uint64_t* users; // Instruction number of the last user of each unit
+        uint64_t* users; // Instruction number of the last user of each unit (NULL if not initialized)
         uint32_t next; // Index of the unit to be used by the next instruction
         uint64_t** prevUsers; // Instruction numbers of the previous users of each unit
         uint32_t* pipelineHead; // Index of the pipeline head (in prevUsers) for each unit
 
     } ResourceRecord;
 
-    unordered_map<int, ResourceInstance> resources; // Key: Resource type (from enum Resource)
-    unordered_map<int, ResourceRecord> records; // Key: Resource type (from enum Resource)
+    ResourceInstance resources[Resource::RscLast + 1]; // Index: Resource type (from enum Resource)
+    ResourceRecord records[Resource::RscLast + 1]; // Index: Resource type (from enum Resource)
 
   public:
+    ScoreboardSimple()
+    {
+        for (int type = 0; type <= Resource::RscLast; ++type)
+        {
+            resources[type].count = 0;
+            records[type].users = NULL;
+        }
+    }
+
     void initResource(int type, uint32_t count, uint32_t total_cycles,
                       uint32_t source_independent_cycles, uint32_t next_issue_cycles)
     {
-        if (resources.count(type) != 0)
+        if (records[type].users != NULL)
         {
             CALIPERS_ERROR("Resource already initialized")
         }
@@ -70,25 +80,25 @@ class ScoreboardSimple
         resources[type].sourceIndependentCycles = source_independent_cycles;
         resources[type].nextIssueCycles = next_issue_cycles;
 
-        for (uint32_t i = 0; i < count; ++i)
+        records[type].users = new uint64_t[count];
+        records[type].prevUsers = new uint64_t*[count];
+        for (uint32_t j = 0; j < count; ++j)
         {
-            records[type].users = new uint64_t[count];
-            records[type].prevUsers = new uint64_t*[count];
-            for (uint32_t j = 0; j < count; ++j)
-            {
-                records[type].prevUsers[j] = new uint64_t[total_cycles];
-            }
-            records[type].pipelineHead = new uint32_t[count];
+            records[type].prevUsers[j] = new uint64_t[total_cycles];
         }
+        records[type].pipelineHead = new uint32_t[count];
 
         initRecords();
     }
 
     void initRecords()
     {
-        for (auto it = records.begin(); it != records.end(); ++it)
+        for (int type = 0; type <= Resource::RscLast; ++type)
         {
-            int type = it->first;
+            if (records[type].users == NULL)
+            {
+                continue;
+            }
             records[type].next = 0;
             for (uint32_t j = 0; j < resources[type].count; ++j)
             {
@@ -106,16 +116,19 @@ class ScoreboardSimple
                           uint32_t& instance, uint64_t& previous_instr,
                           uint32_t& wait_cycles, uint64_t& head_of_pipeline)
     {
-        instance = records[type].next;
-        uint32_t pipeline_idx = records[type].pipelineHead[instance];
-        previous_instr = records[type].users[instance];
-        wait_cycles = resources[type].nextIssueCycles;
-        head_of_pipeline = records[type].prevUsers[instance][pipeline_idx];
+        ResourceInstance& resource = resources[type];
+        ResourceRecord& record = records[type];
 
-        records[type].users[instance] = instrNum;
-        records[type].next = (instance + 1) % resources[type].count;
-        records[type].prevUsers[instance][pipeline_idx] = instrNum;
-        records[type].pipelineHead[instance] = (pipeline_idx + 1) % resources[type].totalCycles;
+        instance = record.next;
+        uint32_t pipeline_idx = record.pipelineHead[instance];
+        previous_instr = record.users[instance];
+        wait_cycles = resource.nextIssueCycles;
+        head_of_pipeline = record.prevUsers[instance][pipeline_idx];
+
+        record.users[instance] = instrNum;
+        record.next = (instance + 1) % resource.count;
+        record.prevUsers[instance][pipeline_idx] = instrNum;
+        record.pipelineHead[instance] = (pipeline_idx + 1) % resource.totalCycles;
 
     }
 
@@ -141,9 +154,12 @@ class ScoreboardSimple
 
     ~ScoreboardSimple()
     {
-        for (auto it = records.begin(); it != records.end(); ++it)
+        for (int type = 0; type <= Resource::RscLast; ++type)
         {
-            int type = it->first;
+            if (records[type].users == NULL)
+            {
+                continue;
+            }
             delete[] records[type].users;
             for (uint32_t j = 0; j < resources[type].count; ++j)
             {
@@ -0,0 +1,183 @@
+/**
+ * Copyright (c) Microsoft Corporation.
+ * 
+ * MIT License
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SPILL_LOG_H
+#define SPILL_LOG_H
+
+#include <cstdint>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "calipers_defs.h"
+
+using namespace std;
+
+
+/**
+ * An array of records kept in a memory-mapped scratch file (rather than on the heap)
+ * Records are only appended at the end; the file grows and is mapped again as
+ * needed, so the users must not keep pointers to the records across push_back.
+ * The page cache holds the pages in use, so the array can be larger than the
+ * memory as long as it is accessed in order: the pages behind a sequential
+ * access are released in large chunks (see releaseBefore) and written back to
+ * the file by the kernel. The file is removed when the array is destroyed.
+ */
+template <typename T>
+class SpillLog
+{
+  private:
+    string fileName;
+    int fd;
+    T* records;
+    uint64_t count;
+    uint64_t capacity; // In records
+    uint64_t residentBegin; // The first record whose page may still be resident
+
+    static constexpr uint64_t InitialCapacity = ((uint64_t)1 << 20);
+    static constexpr uint64_t ReleaseChunk = ((uint64_t)64 << 20) / sizeof(T);
+
+    void map(uint64_t new_capacity)
+    {
+        if (ftruncate(fd, new_capacity * sizeof(T)) != 0)
+        {
+            CALIPERS_ERROR("Cannot grow the spill file " << fileName);
+        }
+        void* address = mmap(NULL, new_capacity * sizeof(T), PROT_READ | PROT_WRITE,
+                             MAP_SHARED, fd, 0);
+        if (address == MAP_FAILED)
+        {
+            CALIPERS_ERROR("Cannot map the spill file " << fileName);
+        }
+        if (records != NULL)
+        {
+            munmap(records, capacity * sizeof(T));
+        }
+        records = (T*)address;
+        capacity = new_capacity;
+        madvise(records, capacity * sizeof(T), MADV_SEQUENTIAL);
+    }
+
+    // Drops the whole pages of records [begin, end) from the memory of the process
+    // (a shared mapping keeps their contents in the file)
+    void release(uint64_t begin, uint64_t end)
+    {
+        uint64_t page = sysconf(_SC_PAGESIZE);
+        uint64_t first = (begin * sizeof(T) + page - 1) / page * page;
+        uint64_t last = end * sizeof(T) / page * page;
+        if (last > first)
+        {
+            madvise((char*)records + first, last - first, MADV_DONTNEED);
+        }
+    }
+
+  public:
+    SpillLog() : fd(-1), records(NULL), count(0), capacity(0), residentBegin(0)
+    {}
+
+    ~SpillLog()
+    {
+        if (records != NULL)
+        {
+            munmap(records, capacity * sizeof(T));
+        }
+        if (fd >= 0)
+        {
+            close(fd);
+            unlink(fileName.c_str());
+        }
+    }
+
+    void open(string file_name)
+    {
+        fileName = file_name;
+        fd = ::open(file_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if (fd < 0)
+        {
+            CALIPERS_ERROR("Cannot create the spill file " << file_name);
+        }
+        map(InitialCapacity);
+    }
+
+    bool isOpen() const
+    {
+        return fd >= 0;
+    }
+
+    uint64_t size() const
+    {
+        return count;
+    }
+
+    T& operator[](uint64_t idx)
+    {
+        return records[idx];
+    }
+
+    void push_back(const T& record)
+    {
+        if (count == capacity)
+        {
+            map(2 * capacity);
+        }
+        records[count++] = record;
+        releaseBefore(count);
+    }
+
+    // Keeps the first size records
+    void resize(uint64_t size)
+    {
+        count = size;
+    }
+
+    void clear()
+    {
+        if (records != NULL)
+        {
+            release(0, count);
+        }
+        count = 0;
+        residentBegin = 0;
+    }
+
+    // Called as a sequential access (appending or a sweep) passes record idx.
+    // The pages before it are released once they add up to a chunk; going back
+    // to an earlier record starts a new sweep.
+    void releaseBefore(uint64_t idx)
+    {
+        if (idx < residentBegin)
+        {
+            residentBegin = idx;
+        }
+        else if (idx - residentBegin >= ReleaseChunk)
+        {
+            release(residentBegin, idx);
+            residentBegin = idx;
+        }
+    }
+};
+
+
+#endif // SPILL_LOG_H
@@ -0,0 +1,156 @@
+/**
+ * Copyright (c) Microsoft Corporation.
+ * 
+ * MIT License
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+
+#include "calipers_defs.h"
+
+using namespace std;
+
+
+/**
+ * A fixed set of worker threads that run the parts of a job in parallel
+ * The calling thread runs part 0 itself, so a pool of one thread runs the
+ * job inline and never starts a worker.
+ */
+class ThreadPool
+{
+  private:
+    vector<thread> workers;
+
+    mutex jobMutex;
+    condition_variable jobStart;
+    condition_variable jobDone;
+
+    const function<void(uint32_t, uint32_t)>* job; // Called as job(part, parts)
+    uint32_t jobParts;
+    uint64_t jobGeneration; // Incremented for each job, so that workers notice a new one
+    uint32_t pendingParts;
+    bool stopping;
+
+    void work(uint32_t part)
+    {
+        uint64_t seen_generation = 0;
+        while (true)
+        {
+            unique_lock<mutex> lock(jobMutex);
+            jobStart.wait(lock, [&] { return stopping || (jobGeneration != seen_generation); });
+            if (stopping)
+            {
+                return;
+            }
+            seen_generation = jobGeneration;
+            if (part >= jobParts)
+            {
+                continue;
+            }
+            lock.unlock();
+
+            (*job)(part, jobParts);
+
+            lock.lock();
+            if (--pendingParts == 0)
+            {
+                jobDone.notify_one();
+            }
+        }
+    }
+
+  public:
+    ThreadPool(uint32_t threads) : job(nullptr), jobParts(0), jobGeneration(0),
+                                   pendingParts(0), stopping(false)
+    {
+        if (threads == 0)
+        {
+            CALIPERS_ERROR("A thread pool needs at least one thread");
+        }
+        for (uint32_t i = 1; i < threads; ++i)
+        {
+            workers.emplace_back(&ThreadPool::work, this, i);
+        }
+    }
+
+    ~ThreadPool()
+    {
+        {
+            lock_guard<mutex> lock(jobMutex);
+            stopping = true;
+        }
+        jobStart.notify_all();
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    uint32_t size() const
+    {
+        return workers.size() + 1;
+    }
+
+    // Runs f(part, parts) for each part in [0, parts) and waits for all of them
+    // (parts is capped at the number of threads)
+    void run(uint32_t parts, const function<void(uint32_t, uint32_t)>& f)
+    {
+        parts = min(parts, size());
+        if (parts <= 1)
+        {
+            f(0, 1);
+            return;
+        }
+
+        {
+            lock_guard<mutex> lock(jobMutex);
+            job = &f;
+            jobParts = parts;
+            pendingParts = parts - 1;
+            ++jobGeneration;
+        }
+        jobStart.notify_all();
+
+        f(0, parts);
+
+        unique_lock<mutex> lock(jobMutex);
+        jobDone.wait(lock, [&] { return pendingParts == 0; });
+    }
+
+    // The range [begin, end) of part out of parts for count items
+    static void partition(uint32_t count, uint32_t part, uint32_t parts,
+                          uint32_t& begin, uint32_t& end)
+    {
+        begin = (uint64_t)count * part / parts;
+        end = (uint64_t)count * (part + 1) / parts;
+    }
+};
+
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,416 @@
+/**
+ * Copyright (c) Microsoft Corporation.
+ * 
+ * MIT License
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef VECTOR_KERNELS_H
+#define VECTOR_KERNELS_H
+
+#include <cstdint>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+#include "calipers_defs.h"
+
+using namespace std;
+
+
+typedef uint64_t LaneMask;
+// Bit i corresponds to scenario i
+
+static_assert(MAX_VECTOR_WIDTH <= 64, "MAX_VECTOR_WIDTH does not fit in a LaneMask");
+
+// The mask of all lanes of a W-wide vector
+template <uint32_t W>
+constexpr LaneMask allLanes()
+{
+    return (W >= 64) ? ~(LaneMask)0 : (((LaneMask)1 << W) - 1);
+}
+
+
+/**
+ * Kernels over the W lanes of a vector
+ * The generic versions are plain loops over the (compile-time) number of
+ * lanes. The versions for the lane types used on the critical path (int32_t
+ * lengths/weights and int64_t statistics) are overloaded for AVX-512 or AVX2
+ * when the compiler targets them; lanes that do not fill a whole register are
+ * handled by the plain loop.
+ */
+namespace kernels
+{
+
+// Plain loops over the lanes [start, W)
+
+// out[i] = in[i] + w for the lanes where in[i] + w >= out[i]; returns those lanes
+template <uint32_t W, typename T>
+inline LaneMask relaxUniformLoop(T* out, const T* in, T w, uint32_t start)
+{
+    LaneMask mask = 0;
+    for (uint32_t i = start; i < W; ++i)
+    {
+        if (in[i] + w >= out[i])
+        {
+            out[i] = in[i] + w;
+            mask |= (LaneMask)1 << i;
+        }
+    }
+    return mask;
+}
+
+// Same as relaxUniform, with per-lane weights (lanes with an absent weight are skipped)
+template <uint32_t W, typename T, typename U>
+inline LaneMask relaxMixedLoop(T* out, const T* in, const U* w, U absent, uint32_t start)
+{
+    LaneMask mask = 0;
+    for (uint32_t i = start; i < W; ++i)
+    {
+        if ((w[i] != absent) && (in[i] + w[i] >= out[i]))
+        {
+            out[i] = in[i] + w[i];
+            mask |= (LaneMask)1 << i;
+        }
+    }
+    return mask;
+}
+
+// out[i] = in[i] for the lanes in mask
+template <uint32_t W, typename T>
+inline void blendMaskedLoop(T* out, const T* in, LaneMask mask, uint32_t start)
+{
+    for (uint32_t i = start; i < W; ++i)
+    {
+        if ((mask >> i) & 1)
+        {
+            out[i] = in[i];
+        }
+    }
+}
+
+// out[i] += in[i] for the lanes in mask
+template <uint32_t W, typename T, typename U>
+inline void addMaskedLoop(T* out, const U* in, LaneMask mask, uint32_t start)
+{
+    for (uint32_t i = start; i < W; ++i)
+    {
+        if ((mask >> i) & 1)
+        {
+            out[i] += in[i];
+        }
+    }
+}
+
+// out[i] += w for the lanes in mask
+template <uint32_t W, typename T>
+inline void addScalarMaskedLoop(T* out, T w, LaneMask mask, uint32_t start)
+{
+    for (uint32_t i = start; i < W; ++i)
+    {
+        if ((mask >> i) & 1)
+        {
+            out[i] += w;
+        }
+    }
+}
+
+// The lanes in mask where v[i] > val
+template <uint32_t W, typename T>
+inline LaneMask compareGreaterLoop(const T* v, T val, LaneMask mask, uint32_t start)
+{
+    LaneMask result = 0;
+    for (uint32_t i = start; i < W; ++i)
+    {
+        if (v[i] > val)
+        {
+            result |= (LaneMask)1 << i;
+        }
+    }
+    return result & mask;
+}
+
+// out[i] = max(out[i], in[i] + w) for i in [start, count) where in[i] is not unreachable
+// (a row of a length known at run time, e.g., of a max-plus matrix)
+template <typename T>
+inline void maxPlusRowLoop(T* out, const T* in, T w, T unreachable, uint32_t start, uint32_t count)
+{
+    for (uint32_t i = start; i < count; ++i)
+    {
+        if ((in[i] != unreachable) && (in[i] + w > out[i]))
+        {
+            out[i] = in[i] + w;
+        }
+    }
+}
+
+
+// Entry points (overloaded below for the targeted instruction sets)
+
+template <uint32_t W, typename T>
+inline LaneMask relaxUniform(T* out, const T* in, T w)
+{
+    return relaxUniformLoop<W>(out, in, w, 0);
+}
+
+template <uint32_t W, typename T, typename U>
+inline LaneMask relaxMixed(T* out, const T* in, const U* w, U absent)
+{
+    return relaxMixedLoop<W>(out, in, w, absent, 0);
+}
+
+template <uint32_t W, typename T>
+inline void blendMasked(T* out, const T* in, LaneMask mask)
+{
+    blendMaskedLoop<W>(out, in, mask, 0);
+}
+
+template <uint32_t W, typename T, typename U>
+inline void addMasked(T* out, const U* in, LaneMask mask)
+{
+    addMaskedLoop<W>(out, in, mask, 0);
+}
+
+template <uint32_t W, typename T>
+inline void addScalarMasked(T* out, T w, LaneMask mask)
+{
+    addScalarMaskedLoop<W>(out, w, mask, 0);
+}
+
+template <uint32_t W, typename T>
+inline LaneMask compareGreater(const T* v, T val, LaneMask mask)
+{
+    return compareGreaterLoop<W>(v, val, mask, 0);
+}
+
+template <typename T>
+inline void maxPlusRow(T* out, const T* in, T w, T unreachable, uint32_t count)
+{
+    maxPlusRowLoop(out, in, w, unreachable, 0, count);
+}
+
+
+#if defined(__AVX512F__)
+
+template <uint32_t W>
+inline LaneMask relaxUniform(int32_t* out, const int32_t* in, int32_t w)
+{
+    LaneMask mask = 0;
+    uint32_t i = 0;
+    __m512i wv = _mm512_set1_epi32(w);
+    for (; i + 16 <= W; i += 16)
+    {
+        __m512i o = _mm512_loadu_si512(out + i);
+        __m512i s = _mm512_add_epi32(_mm512_loadu_si512(in + i), wv);
+        __mmask16 ge = _mm512_cmpge_epi32_mask(s, o);
+        _mm512_storeu_si512(out + i, _mm512_mask_mov_epi32(o, ge, s));
+        mask |= (LaneMask)ge << i;
+    }
+    return mask | relaxUniformLoop<W>(out, in, w, i);
+}
+
+template <uint32_t W>
+inline LaneMask relaxMixed(int32_t* out, const int32_t* in, const int32_t* w,
+                                             int32_t absent)
+{
+    LaneMask mask = 0;
+    uint32_t i = 0;
+    __m512i absent_v = _mm512_set1_epi32(absent);
+    for (; i + 16 <= W; i += 16)
+    {
+        __m512i o = _mm512_loadu_si512(out + i);
+        __m512i wv = _mm512_loadu_si512(w + i);
+        __m512i s = _mm512_add_epi32(_mm512_loadu_si512(in + i), wv);
+        __mmask16 ge = _mm512_mask_cmpge_epi32_mask(
+            _mm512_cmpneq_epi32_mask(wv, absent_v), s, o);
+        _mm512_storeu_si512(out + i, _mm512_mask_mov_epi32(o, ge, s));
+        mask |= (LaneMask)ge << i;
+    }
+    return mask | relaxMixedLoop<W>(out, in, w, absent, i);
+}
+
+template <uint32_t W>
+inline void blendMasked(int64_t* out, const int64_t* in, LaneMask mask)
+{
+    uint32_t i = 0;
+    for (; i + 8 <= W; i += 8)
+    {
+        __m512i o = _mm512_loadu_si512(out + i);
+        __m512i v = _mm512_loadu_si512(in + i);
+        _mm512_storeu_si512(out + i, _mm512_mask_mov_epi64(o, (__mmask8)(mask >> i), v));
+    }
+    blendMaskedLoop<W>(out, in, mask, i);
+}
+
+template <uint32_t W>
+inline void addScalarMasked(int64_t* out, int64_t w, LaneMask mask)
+{
+    uint32_t i = 0;
+    __m512i wv = _mm512_set1_epi64(w);
+    for (; i + 8 <= W; i += 8)
+    {
+        __m512i o = _mm512_loadu_si512(out + i);
+        _mm512_storeu_si512(out + i, _mm512_mask_add_epi64(o, (__mmask8)(mask >> i), o, wv));
+    }
+    addScalarMaskedLoop<W>(out, w, mask, i);
+}
+
+template <uint32_t W>
+inline LaneMask compareGreater(const int32_t* v, int32_t val, LaneMask mask)
+{
+    LaneMask result = 0;
+    uint32_t i = 0;
+    __m512i val_v = _mm512_set1_epi32(val);
+    for (; i + 16 <= W; i += 16)
+    {
+        result |= (LaneMask)_mm512_cmpgt_epi32_mask(_mm512_loadu_si512(v + i), val_v) << i;
+    }
+    return (result & mask) | compareGreaterLoop<W>(v, val, mask, i);
+}
+
+inline void maxPlusRow(int32_t* out, const int32_t* in, int32_t w, int32_t unreachable,
+                       uint32_t count)
+{
+    uint32_t i = 0;
+    __m512i wv = _mm512_set1_epi32(w);
+    __m512i unreachable_v = _mm512_set1_epi32(unreachable);
+    for (; i + 16 <= count; i += 16)
+    {
+        __m512i o = _mm512_loadu_si512(out + i);
+        __m512i v = _mm512_loadu_si512(in + i);
+        __mmask16 reached = _mm512_cmpneq_epi32_mask(v, unreachable_v);
+        _mm512_storeu_si512(out + i, _mm512_mask_max_epi32(o, reached, o, _mm512_add_epi32(v, wv)));
+    }
+    maxPlusRowLoop(out, in, w, unreachable, i, count);
+}
+
+#elif defined(__AVX2__)
+
+// Expands bits [0, 4) of bits to 64-bit lane masks
+inline __m256i expandMask64(LaneMask bits)
+{
+    const __m256i select = _mm256_setr_epi64x(1, 2, 4, 8);
+    __m256i b = _mm256_set1_epi64x((int64_t)(bits & 0xF));
+    return _mm256_cmpeq_epi64(_mm256_and_si256(b, select), select);
+}
+
+template <uint32_t W>
+inline LaneMask relaxUniform(int32_t* out, const int32_t* in, int32_t w)
+{
+    LaneMask mask = 0;
+    uint32_t i = 0;
+    __m256i wv = _mm256_set1_epi32(w);
+    for (; i + 8 <= W; i += 8)
+    {
+        __m256i o = _mm256_loadu_si256((const __m256i*)(out + i));
+        __m256i s = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(in + i)), wv);
+        __m256i lt = _mm256_cmpgt_epi32(o, s); // Lanes that keep their value
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_blendv_epi8(s, o, lt));
+        LaneMask ge = ~(LaneMask)_mm256_movemask_ps(_mm256_castsi256_ps(lt)) & 0xFF;
+        mask |= ge << i;
+    }
+    return mask | relaxUniformLoop<W>(out, in, w, i);
+}
+
+template <uint32_t W>
+inline LaneMask relaxMixed(int32_t* out, const int32_t* in, const int32_t* w,
+                                             int32_t absent)
+{
+    LaneMask mask = 0;
+    uint32_t i = 0;
+    __m256i absent_v = _mm256_set1_epi32(absent);
+    for (; i + 8 <= W; i += 8)
+    {
+        __m256i o = _mm256_loadu_si256((const __m256i*)(out + i));
+        __m256i wv = _mm256_loadu_si256((const __m256i*)(w + i));
+        __m256i s = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(in + i)), wv);
+        __m256i keep = _mm256_or_si256(_mm256_cmpgt_epi32(o, s),
+                                        _mm256_cmpeq_epi32(wv, absent_v));
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_blendv_epi8(s, o, keep));
+        LaneMask ge = ~(LaneMask)_mm256_movemask_ps(_mm256_castsi256_ps(keep)) & 0xFF;
+        mask |= ge << i;
+    }
+    return mask | relaxMixedLoop<W>(out, in, w, absent, i);
+}
+
+template <uint32_t W>
+inline void blendMasked(int64_t* out, const int64_t* in, LaneMask mask)
+{
+    uint32_t i = 0;
+    for (; i + 4 <= W; i += 4)
+    {
+        __m256i o = _mm256_loadu_si256((const __m256i*)(out + i));
+        __m256i v = _mm256_loadu_si256((const __m256i*)(in + i));
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_blendv_epi8(o, v, expandMask64(mask >> i)));
+    }
+    blendMaskedLoop<W>(out, in, mask, i);
+}
+
+template <uint32_t W>
+inline void addScalarMasked(int64_t* out, int64_t w, LaneMask mask)
+{
+    uint32_t i = 0;
+    __m256i wv = _mm256_set1_epi64x(w);
+    for (; i + 4 <= W; i += 4)
+    {
+        __m256i o = _mm256_loadu_si256((const __m256i*)(out + i));
+        __m256i add = _mm256_and_si256(wv, expandMask64(mask >> i));
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_add_epi64(o, add));
+    }
+    addScalarMaskedLoop<W>(out, w, mask, i);
+}
+
+template <uint32_t W>
+inline LaneMask compareGreater(const int32_t* v, int32_t val, LaneMask mask)
+{
+    LaneMask result = 0;
+    uint32_t i = 0;
+    __m256i val_v = _mm256_set1_epi32(val);
+    for (; i + 8 <= W; i += 8)
+    {
+        __m256i gt = _mm256_cmpgt_epi32(_mm256_loadu_si256((const __m256i*)(v + i)), val_v);
+        result |= (LaneMask)_mm256_movemask_ps(_mm256_castsi256_ps(gt)) << i;
+    }
+    return (result & mask) | compareGreaterLoop<W>(v, val, mask, i);
+}
+
+inline void maxPlusRow(int32_t* out, const int32_t* in, int32_t w, int32_t unreachable,
+                       uint32_t count)
+{
+    uint32_t i = 0;
+    __m256i wv = _mm256_set1_epi32(w);
+    __m256i unreachable_v = _mm256_set1_epi32(unreachable);
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i o = _mm256_loadu_si256((const __m256i*)(out + i));
+        __m256i v = _mm256_loadu_si256((const __m256i*)(in + i));
+        __m256i s = _mm256_max_epi32(o, _mm256_add_epi32(v, wv));
+        __m256i unreached = _mm256_cmpeq_epi32(v, unreachable_v);
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_blendv_epi8(s, o, unreached));
+    }
+    maxPlusRowLoop(out, in, w, unreachable, i, count);
+}
+
+#endif
+
+} // namespace kernels
+
+#endif // VECTOR_KERNELS_H
@@ -0,0 +1,159 @@
+/**
+ * Copyright (c) Microsoft Corporation.
+ * 
+ * MIT License
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef VERTEX_SLOTS_H
+#define VERTEX_SLOTS_H
+
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+
+/**
+ * A fixed ring of per-vertex edge lists, one slot per vertex of the
+ * analysis window (indexed by the window position of the vertex)
+ * The first N edges of a vertex are kept in its slot and any further
+ * edges in chunks of N taken from a shared overflow pool. Clearing a slot
+ * returns its chunks to the pool, so once the pool has grown to the
+ * largest number of overflowing edges, no more memory is allocated.
+ */
+template <typename E, uint32_t N>
+class VertexSlots
+{
+  private:
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    typedef struct EDGE_CHUNK
+    {
+        E edges[N];
+        uint32_t next; // The next chunk of the same slot (or the next free chunk)
+    } EdgeChunk;
+
+    typedef struct VERTEX_SLOT
+    {
+        E edges[N];
+        uint32_t count;
+        uint32_t overflow; // The first overflow chunk
+    } VertexSlot;
+
+    vector<VertexSlot> slots;
+    vector<EdgeChunk> pool;
+    uint32_t freeChunk;
+
+    uint32_t allocateChunk()
+    {
+        if (freeChunk == NIL)
+        {
+            pool.emplace_back();
+            pool.back().next = NIL;
+            return pool.size() - 1;
+        }
+        uint32_t chunk = freeChunk;
+        freeChunk = pool[chunk].next;
+        pool[chunk].next = NIL;
+        return chunk;
+    }
+
+  public:
+    VertexSlots() : freeChunk(NIL) {}
+
+    void init(uint64_t slot_count)
+    {
+        slots.resize(slot_count);
+        for (auto& slot : slots)
+        {
+            slot.count = 0;
+            slot.overflow = NIL;
+        }
+        pool.clear();
+        freeChunk = NIL;
+    }
+
+    uint32_t size(uint64_t slot) const
+    {
+        return slots[slot].count;
+    }
+
+    E& at(uint64_t slot, uint32_t i)
+    {
+        VertexSlot& s = slots[slot];
+        if (i < N)
+        {
+            return s.edges[i];
+        }
+        uint32_t chunk = s.overflow;
+        for (i -= N; i >= N; i -= N)
+        {
+            chunk = pool[chunk].next;
+        }
+        return pool[chunk].edges[i];
+    }
+
+    void push_back(uint64_t slot, const E& e)
+    {
+        VertexSlot& s = slots[slot];
+        uint32_t i = s.count++;
+        if (i < N)
+        {
+            s.edges[i] = e;
+            return;
+        }
+
+        i -= N;
+        if (s.overflow == NIL)
+        {
+            s.overflow = allocateChunk();
+        }
+        uint32_t chunk = s.overflow;
+        for (; i >= N; i -= N)
+        {
+            if (pool[chunk].next == NIL)
+            {
+                uint32_t next = allocateChunk(); // May move the pool
+                pool[chunk].next = next;
+            }
+            chunk = pool[chunk].next;
+        }
+        pool[chunk].edges[i] = e;
+    }
+
+    void clear(uint64_t slot)
+    {
+        VertexSlot& s = slots[slot];
+        uint32_t chunk = s.overflow;
+        while (chunk != NIL)
+        {
+            uint32_t next = pool[chunk].next;
+            pool[chunk].next = freeChunk;
+            freeChunk = chunk;
+            chunk = next;
+        }
+        s.count = 0;
+        s.overflow = NIL;
+    }
+};
+
+
+#endif // VERTEX_SLOTS_H
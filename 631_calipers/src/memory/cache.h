@@ -33,6 +33,8 @@
 class Cache
 {
   public:
+    static constexpr bool fromTrace = false; // True only for TraceCache
+
     virtual uint32_t loadCycles(uint64_t base, uint32_t length) = 0;
     virtual uint32_t storeCycles(uint64_t base, uint32_t length) = 0;
     virtual void printStats() {}
@@ -32,7 +32,7 @@
 /**
  * An ideal cache with single-cycle loads/stores
  */
-class IdealCache: public Cache
+class IdealCache final : public Cache
 {
   public:
     uint32_t loadCycles(uint64_t base, uint32_t length)
@@ -471,7 +471,7 @@ class CacheInternals
 /**
  * An analytical/functional cache model
  */
-class RealCache: public Cache
+class RealCache final : public Cache
 {
   private:
     CacheInternals* cacheInternals;
@@ -33,7 +33,7 @@
 /**
  * A statistical/stochastic cache with fixed load/store hit rate and hit/miss cycles
  */
-class StatisticalCache: public Cache
+class StatisticalCache final : public Cache
 {
   private:
     float loadHitRate;
@@ -0,0 +1,53 @@
+/**
+ * Copyright (c) Microsoft Corporation.
+ * 
+ * MIT License
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED *AS IS*, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TRACE_CACHE_H
+#define TRACE_CACHE_H
+
+#include <stdint.h>
+
+#include "cache.h"
+
+/**
+ * Stands for the load/store and fetch cycles recorded in the trace
+ * The models read the cycles of the instruction instead of accessing
+ * a cache of this type, so it is never instantiated.
+ */
+class TraceCache final : public Cache
+{
+  public:
+    static constexpr bool fromTrace = true;
+
+    uint32_t loadCycles(uint64_t base, uint32_t length)
+    {
+        return 0;
+    }
+
+    uint32_t storeCycles(uint64_t base, uint32_t length)
+    {
+        return 0;
+    }
+};
+
+#endif // TRACE_CACHE_H
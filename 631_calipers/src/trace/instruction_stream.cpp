@@ -41,3 +41,13 @@ InstructionStream::InstructionStream(string trace_file_name, bool trace_bp,
         CALIPERS_ERROR("Unable to open the trace file");
     }
 }
+
+void InstructionStream::seek(uint64_t offset)
+{
+    traceFile.clear();
+    traceFile.seekg(offset);
+    if (!traceFile)
+    {
+        CALIPERS_ERROR("Unable to seek to offset " << offset << " of the trace file");
+    }
+}
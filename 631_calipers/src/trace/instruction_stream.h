@@ -27,6 +27,7 @@
 
 #include <string>
 #include <fstream>
+#include <vector>
 
 #include "calipers_types.h"
 
@@ -48,7 +49,15 @@ class InstructionStream
   public:
     InstructionStream(string trace_file_name, bool trace_bp,
                       bool trace_icache, bool trace_dcache);
+    virtual ~InstructionStream() {}
     virtual Instruction* next() = 0;
+
+    virtual uint64_t index(uint64_t stride, vector<uint64_t>& offsets) = 0;
+    // Scans the trace and fills in the byte offsets of every stride'th instruction
+    // (from the first one), and returns the number of instructions in the trace
+
+    virtual void seek(uint64_t offset);
+    // Continues the stream from the instruction at a byte offset found by index
 };
 
 #endif // INSTRUCTION_STREAM_H
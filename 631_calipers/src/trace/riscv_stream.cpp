@@ -135,6 +135,40 @@ Instruction* RiscvStream::next()
     return &instr;
 }
 
+uint64_t RiscvStream::index(uint64_t stride, vector<uint64_t>& offsets)
+{
+    // Each "@I" line starts an instruction (see next). The offsets are counted
+    // from the line lengths, since getline drops the line feeds.
+    string line;
+    uint64_t offset = 0;
+    uint64_t count = 0;
+
+    offsets.clear();
+    seek(0);
+    while (getline(traceFile, line))
+    {
+        if (line.find("@I ") == 0)
+        {
+            if (count % stride == 0)
+            {
+                offsets.push_back(offset);
+            }
+            ++count;
+        }
+        offset += line.size() + 1;
+    }
+    seek(0);
+
+    return count;
+}
+
+void RiscvStream::seek(uint64_t offset)
+{
+    InstructionStream::seek(offset);
+    lastInstrLine = "";
+    readFromFile = true;
+}
+
 string RiscvStream::parseNext(string& instr_line, size_t& current_pos)
 {
     size_t pos;
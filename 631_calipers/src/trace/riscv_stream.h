@@ -32,7 +32,7 @@
  * Defining how a RISC-V stream of instructions is parsed
  * Based on: "The RISC-V Instruction Set Manual" (Version 2.2)
  */
-class RiscvStream : public InstructionStream
+class RiscvStream final : public InstructionStream
 {
   private:
 enum IntReg
@@ -202,6 +202,8 @@ enum IntReg
     }
 
     Instruction* next();
+    uint64_t index(uint64_t stride, vector<uint64_t>& offsets);
+    void seek(uint64_t offset);
 };
 
 #endif // RISCV_STREAM_H
@@ -0,0 +1,60 @@
+#!/bin/sh
+# End-to-end tests of the out-of-order model (run by "make test" from the top directory)
+# Usage: run_tests.sh calipers_binary
+#
+# Each test runs the model set of demo/OoO.cfg, with some of its parameters
+# replaced, on a trace of this directory and compares the result file with
+# the expected one. lsq.trace is dominated by loads and stores, whose queue
+# edges used to make the graph of a window cyclic.
+
+CALIPERS=$1
+TEST_DIR=$(dirname "$0")
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "$WORK_DIR"' EXIT
+failed=0
+
+# run_test name trace expected [parameter=value ...]
+run_test()
+{
+    name=$1
+    trace=$2
+    expected=$3
+    shift 3
+
+    cp demo/OoO.cfg "$WORK_DIR/$name.cfg"
+    for setting in "$@"
+    do
+        parameter=${setting%%=*}
+        value=${setting#*=}
+        sed -i "s|^$parameter .*|$parameter $value|" "$WORK_DIR/$name.cfg"
+        if ! grep -q "^$parameter " "$WORK_DIR/$name.cfg"
+        then
+            echo "$parameter $value" >> "$WORK_DIR/$name.cfg"
+        fi
+    done
+
+    if ! "$CALIPERS" "$WORK_DIR/$name.cfg" "$trace" "$WORK_DIR/$name.result" \
+         > "$WORK_DIR/$name.log" 2>&1 || grep -q CALIPERS_ERROR "$WORK_DIR/$name.log"
+    then
+        echo "FAILED: $name"
+        grep CALIPERS_ERROR "$WORK_DIR/$name.log"
+        failed=1
+    elif ! diff "$TEST_DIR/$expected" "$WORK_DIR/$name.result" > "$WORK_DIR/$name.diff"
+    then
+        echo "FAILED: $name (result differs from $expected)"
+        head -20 "$WORK_DIR/$name.diff"
+        failed=1
+    else
+        echo "PASSED: $name"
+    fi
+}
+
+run_test lsq "$TEST_DIR/lsq.trace" lsq.expected
+run_test lsq_threads "$TEST_DIR/lsq.trace" lsq.expected Analysis_Threads=2
+run_test lsq_windows "$TEST_DIR/lsq.trace" lsq_windows.expected Memory_Budget=1
+run_test lsq_spilled "$TEST_DIR/lsq.trace" lsq.expected Graph_Spill_File="$WORK_DIR/spill"
+run_test lsq_spilled_lazy "$TEST_DIR/lsq.trace" lsq.expected Graph_Spill_File="$WORK_DIR/spill" \
+         Lazy_Breakdown=1
+run_test lsq_sliding "$TEST_DIR/lsq.trace" lsq_sliding.expected Engine=Sliding
+
+exit $failed